@@ -0,0 +1,25 @@
+# Runs "gpick --convert" without a display and checks the output file.
+# Configuration directory must not be created by conversion.
+# Variables: GPICK, INPUT, OUTPUT, CONVERTER (optional), EXPECT (regular expression), DATA_PATH, CONFIG_PATH.
+unset(ENV{DISPLAY})
+unset(ENV{WAYLAND_DISPLAY})
+set(ENV{XDG_DATA_HOME} "${DATA_PATH}")
+set(ENV{XDG_DATA_DIRS} "${DATA_PATH}")
+set(ENV{XDG_CONFIG_HOME} "${CONFIG_PATH}")
+file(REMOVE_RECURSE "${CONFIG_PATH}")
+file(REMOVE "${OUTPUT}")
+set(arguments --convert "${INPUT}" "${OUTPUT}")
+if (CONVERTER)
+	list(APPEND arguments --converter "${CONVERTER}")
+endif()
+execute_process(COMMAND "${GPICK}" ${arguments} RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+	message(FATAL_ERROR "gpick --convert failed: ${result}")
+endif()
+file(READ "${OUTPUT}" content)
+if (NOT content MATCHES "${EXPECT}")
+	message(FATAL_ERROR "Unexpected output:\n${content}")
+endif()
+if (EXISTS "${CONFIG_PATH}/gpick")
+	message(FATAL_ERROR "Configuration directory was created")
+endif()
@@ -165,4 +165,9 @@ gpick:addConverter('css_border_bottom_color_hex', 'CSS(border-bottom-color)', se
 gpick:addConverter('css_border_left_hex', 'CSS(border-left-color)', serializeCssBorderLeftHex)
 gpick:addConverter('color_csv', 'CSV', serializeColorCsv)
 gpick:addConverter('color_css_block', 'CSS block', serializeColorCssBlock)
+-- Signatures let paste skip deserializers which can not match the text
+gpick:setConverterSignature('color_web_hex', {'hash6'}, 7)
+gpick:setConverterSignature('color_web_hex_3_digit', {'hash3'}, 4)
+gpick:setConverterSignature('color_web_hex_no_hash', {'hex6'}, 6)
+gpick:setConverterSignature('color_css_rgb', {'rgb'}, 7)
 return {}
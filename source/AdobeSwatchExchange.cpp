@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "AdobeSwatchExchange.h"
+#include "ColorObject.h"
+#include "MathUtil.h"
+#include <boost/endian/conversion.hpp>
+#include <algorithm>
+#include <cstring>
+namespace ase {
+namespace {
+// Bounds checked big endian reader over a memory block
+struct BufferReader {
+	BufferReader(const uint8_t *data, size_t size):
+		m_data(data),
+		m_size(size),
+		m_offset(0) {
+	}
+	bool read(const uint8_t *&data, size_t length) {
+		if (!has(length))
+			return false;
+		data = m_data + m_offset;
+		m_offset += length;
+		return true;
+	}
+	bool read(uint16_t &value) {
+		if (!has(sizeof(value)))
+			return false;
+		memcpy(&value, m_data + m_offset, sizeof(value));
+		m_offset += sizeof(value);
+		value = boost::endian::big_to_native<uint16_t>(value);
+		return true;
+	}
+	bool read(uint32_t &value) {
+		if (!has(sizeof(value)))
+			return false;
+		memcpy(&value, m_data + m_offset, sizeof(value));
+		m_offset += sizeof(value);
+		value = boost::endian::big_to_native<uint32_t>(value);
+		return true;
+	}
+	bool read(float *values, size_t count) {
+		static_assert(sizeof(float) == sizeof(uint32_t), "unexpected float size");
+		for (size_t i = 0; i < count; i++) {
+			uint32_t intValue;
+			if (!read(intValue))
+				return false;
+			memcpy(&values[i], &intValue, sizeof(float));
+		}
+		return true;
+	}
+	bool end() const {
+		return m_offset == m_size;
+	}
+private:
+	const uint8_t *m_data;
+	size_t m_size, m_offset;
+	bool has(size_t length) const {
+		return m_size - m_offset >= length;
+	}
+};
+const uint32_t replacementCharacter = 0xfffd;
+// Longest name, which still fits into 16 bit length together with zero terminator
+const size_t maxNameUnits = 0xfffe;
+void appendUtf8(uint32_t codePoint, std::string &result) {
+	if (codePoint < 0x80) {
+		result += static_cast<char>(codePoint);
+	} else if (codePoint < 0x800) {
+		result += static_cast<char>(0xc0 | (codePoint >> 6));
+		result += static_cast<char>(0x80 | (codePoint & 0x3f));
+	} else if (codePoint < 0x10000) {
+		result += static_cast<char>(0xe0 | (codePoint >> 12));
+		result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+		result += static_cast<char>(0x80 | (codePoint & 0x3f));
+	} else {
+		result += static_cast<char>(0xf0 | (codePoint >> 18));
+		result += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+		result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+		result += static_cast<char>(0x80 | (codePoint & 0x3f));
+	}
+}
+// Converts big endian UTF-16 text straight from file data, stopping at zero terminator. Unpaired surrogates become U+FFFD.
+void utf16BigEndianToUtf8(const uint8_t *data, size_t units, std::string &result) {
+	result.clear();
+	for (size_t i = 0; i < units; i++) {
+		uint32_t unit = data[i * 2] << 8 | data[i * 2 + 1];
+		if (unit == 0)
+			break;
+		if (unit < 0x80) {
+			result += static_cast<char>(unit);
+			continue;
+		}
+		if (unit >= 0xd800 && unit < 0xdc00 && i + 1 < units) {
+			uint32_t low = data[i * 2 + 2] << 8 | data[i * 2 + 3];
+			if (low >= 0xdc00 && low < 0xe000) {
+				appendUtf8(0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00), result);
+				i++;
+				continue;
+			}
+		}
+		appendUtf8(unit >= 0xd800 && unit < 0xe000 ? replacementCharacter : unit, result);
+	}
+}
+// Decodes one UTF-8 sequence. Invalid, overlong and truncated sequences consume one byte and return U+FFFD.
+uint32_t nextCodePoint(const uint8_t *&text, const uint8_t *end) {
+	uint32_t lead = *text++;
+	if (lead < 0x80)
+		return lead;
+	int length;
+	uint32_t codePoint, minimum;
+	if ((lead & 0xe0) == 0xc0) {
+		length = 1;
+		codePoint = lead & 0x1f;
+		minimum = 0x80;
+	} else if ((lead & 0xf0) == 0xe0) {
+		length = 2;
+		codePoint = lead & 0x0f;
+		minimum = 0x800;
+	} else if ((lead & 0xf8) == 0xf0) {
+		length = 3;
+		codePoint = lead & 0x07;
+		minimum = 0x10000;
+	} else {
+		return replacementCharacter;
+	}
+	if (end - text < length)
+		return replacementCharacter;
+	for (int i = 0; i < length; i++) {
+		if ((text[i] & 0xc0) != 0x80)
+			return replacementCharacter;
+		codePoint = codePoint << 6 | (text[i] & 0x3f);
+	}
+	if (codePoint < minimum || codePoint > 0x10ffff || (codePoint >= 0xd800 && codePoint < 0xe000))
+		return replacementCharacter;
+	text += length;
+	return codePoint;
+}
+void storeUint16(uint16_t value, char *to) {
+	to[0] = static_cast<char>(value >> 8);
+	to[1] = static_cast<char>(value);
+}
+void storeUint32(uint32_t value, char *to) {
+	to[0] = static_cast<char>(value >> 24);
+	to[1] = static_cast<char>(value >> 16);
+	to[2] = static_cast<char>(value >> 8);
+	to[3] = static_cast<char>(value);
+}
+void appendUint32(uint32_t value, std::string &output) {
+	char bytes[4];
+	storeUint32(value, bytes);
+	output.append(bytes, sizeof(bytes));
+}
+void appendFloat(float value, std::string &output) {
+	uint32_t intValue;
+	memcpy(&intValue, &value, sizeof(intValue));
+	appendUint32(intValue, output);
+}
+// Appends name as big endian UTF-16 without zero terminator, truncated to the longest name ASE can store. Returns number of appended code units.
+size_t appendUtf16BigEndian(const std::string &text, std::string &output) {
+	size_t start = output.length();
+	// Every UTF-8 byte produces at most one UTF-16 code unit
+	output.resize(start + std::min(text.length(), maxNameUnits) * 2);
+	char *to = &output[start];
+	size_t units = 0;
+	auto data = reinterpret_cast<const uint8_t *>(text.data());
+	auto end = data + text.length();
+	while (data < end) {
+		if (*data < 0x80) {
+			if (units == maxNameUnits)
+				break;
+			storeUint16(*data++, to + units++ * 2);
+			continue;
+		}
+		uint32_t codePoint = nextCodePoint(data, end);
+		if (codePoint < 0x10000) {
+			if (units + 1 > maxNameUnits)
+				break;
+			storeUint16(static_cast<uint16_t>(codePoint), to + units++ * 2);
+		} else {
+			if (units + 2 > maxNameUnits)
+				break;
+			codePoint -= 0x10000;
+			storeUint16(static_cast<uint16_t>(0xd800 + (codePoint >> 10)), to + units++ * 2);
+			storeUint16(static_cast<uint16_t>(0xdc00 + (codePoint & 0x3ff)), to + units++ * 2);
+		}
+	}
+	output.resize(start + units * 2);
+	return units;
+}
+}
+bool decode(const uint8_t *data, size_t size, const ColorCallback &callback) {
+	BufferReader reader(data, size);
+	const uint8_t *magic;
+	uint32_t version, blocks;
+	if (!reader.read(magic, 4) || memcmp(magic, "ASEF", 4) != 0 || !reader.read(version) || !reader.read(blocks))
+		return false;
+	std::string name;
+	// Block count is not trusted, some files end earlier
+	for (uint32_t i = 0; i < blocks && !reader.end(); i++) {
+		uint16_t blockType;
+		uint32_t blockSize;
+		const uint8_t *blockData;
+		if (!reader.read(blockType) || !reader.read(blockSize) || !reader.read(blockData, blockSize))
+			return false;
+		if (blockType != 0x0001) // only color blocks are used, groups are skipped
+			continue;
+		BufferReader block(blockData, blockSize);
+		uint16_t nameLength;
+		const uint8_t *nameData, *colorSpace;
+		if (!block.read(nameLength) || !block.read(nameData, nameLength * size_t(2)) || !block.read(colorSpace, 4))
+			return false;
+		Color color;
+		float values[4];
+		if (memcmp(colorSpace, "RGB ", 4) == 0) {
+			if (!block.read(values, 3))
+				return false;
+			color.rgb.red = values[0];
+			color.rgb.green = values[1];
+			color.rgb.blue = values[2];
+		} else if (memcmp(colorSpace, "CMYK", 4) == 0) {
+			if (!block.read(values, 4))
+				return false;
+			Color cmyk;
+			cmyk.cmyk.c = values[0];
+			cmyk.cmyk.m = values[1];
+			cmyk.cmyk.y = values[2];
+			cmyk.cmyk.k = values[3];
+			color_cmyk_to_rgb(&cmyk, &color);
+		} else if (memcmp(colorSpace, "Gray", 4) == 0) {
+			if (!block.read(values, 1))
+				return false;
+			color.rgb.red = color.rgb.green = color.rgb.blue = values[0];
+		} else if (memcmp(colorSpace, "LAB ", 4) == 0) {
+			if (!block.read(values, 3))
+				return false;
+			Color lab;
+			lab.lab.L = values[0] * 100;
+			lab.lab.a = values[1];
+			lab.lab.b = values[2];
+			color_lab_to_rgb_d50(&lab, &color);
+			color.rgb.red = clamp_float(color.rgb.red, 0, 1);
+			color.rgb.green = clamp_float(color.rgb.green, 0, 1);
+			color.rgb.blue = clamp_float(color.rgb.blue, 0, 1);
+		} else {
+			continue;
+		}
+		utf16BigEndianToUtf8(nameData, nameLength, name);
+		callback(name, color);
+	}
+	return true;
+}
+void encode(const std::vector<ColorObject *> &colorObjects, std::string &output) {
+	// Header and typical short name colors, so that output is rarely reallocated
+	output.reserve(output.length() + 12 + colorObjects.size() * 64);
+	output.append("ASEF", 4);
+	appendUint32(0x00010000, output);
+	appendUint32(static_cast<uint32_t>(colorObjects.size()), output);
+	for (auto colorObject: colorObjects) {
+		// Block type, block size and name length are stored after the name is converted
+		size_t blockStart = output.length();
+		output.append(8, '\0');
+		uint32_t nameUnits = static_cast<uint32_t>(appendUtf16BigEndian(colorObject->getName(), output) + 1);
+		output.append(2, '\0');
+		output.append("RGB ", 4);
+		const Color &color = colorObject->getColor();
+		appendFloat(color.rgb.red, output);
+		appendFloat(color.rgb.green, output);
+		appendFloat(color.rgb.blue, output);
+		output.append(2, '\0');
+		char *block = &output[blockStart];
+		storeUint16(0x0001, block);
+		// Name length, zero terminated name, color space, 3 float values and color type
+		storeUint32(2 + nameUnits * 2 + 4 + 3 * 4 + 2, block + 2);
+		storeUint16(static_cast<uint16_t>(nameUnits), block + 6);
+	}
+}
+}
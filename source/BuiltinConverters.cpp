@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BuiltinConverters.h"
+#include "ConverterSerializePosition.h"
+#include "ColorObject.h"
+#include "Color.h"
+#include <sstream>
+#include <locale>
+#include <iomanip>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+namespace {
+const double Pi = 3.141592653589793;
+// Same as helpers.round, but refuses values which Lua string.format would not accept as integers.
+bool round(double value, int64_t &result) {
+	if (!std::isfinite(value))
+		return false;
+	double rounded = value - std::floor(value) >= 0.5 ? std::ceil(value) : std::floor(value);
+	if (rounded < -9.2e18 || rounded > 9.2e18)
+		return false;
+	result = static_cast<int64_t>(rounded);
+	return true;
+}
+bool round(const Color &color, double red, double green, double blue, int64_t result[3]) {
+	return round(color.ma[0] * red, result[0]) && round(color.ma[1] * green, result[1]) && round(color.ma[2] * blue, result[2]);
+}
+bool appendHex(const Color &color, double scale, bool upperCase, const char *lowerFormat, const char *upperFormat, std::string &result) {
+	int64_t values[3];
+	if (!round(color, scale, scale, scale, values))
+		return false;
+	// Lua versions differ in how negative values are formatted as hex, so leave them to Lua.
+	if (values[0] < 0 || values[1] < 0 || values[2] < 0)
+		return false;
+	char buffer[64];
+	int length = std::snprintf(buffer, sizeof(buffer), upperCase ? upperFormat : lowerFormat, static_cast<long long>(values[0]), static_cast<long long>(values[1]), static_cast<long long>(values[2]));
+	if (length < 0 || static_cast<size_t>(length) >= sizeof(buffer))
+		return false;
+	result.append(buffer, length);
+	return true;
+}
+bool appendWebHex(const Color &color, const BuiltinConverterOptions &options, std::string &result) {
+	result += '#';
+	return appendHex(color, 255, options.upperCase, "%02llx%02llx%02llx", "%02llX%02llX%02llX", result);
+}
+bool appendRgb(const Color &color, std::string &result) {
+	int64_t values[3];
+	if (!round(color, 255, 255, 255, values))
+		return false;
+	char buffer[80];
+	int length = std::snprintf(buffer, sizeof(buffer), "%lld, %lld, %lld", static_cast<long long>(values[0]), static_cast<long long>(values[1]), static_cast<long long>(values[2]));
+	if (length < 0 || static_cast<size_t>(length) >= sizeof(buffer))
+		return false;
+	result.append(buffer, length);
+	return true;
+}
+bool appendHsl(const Color &color, std::string &result) {
+	int64_t values[3];
+	if (!round(color, 360, 100, 100, values))
+		return false;
+	char buffer[80];
+	int length = std::snprintf(buffer, sizeof(buffer), "%lld, %lld%%, %lld%%", static_cast<long long>(values[0]), static_cast<long long>(values[1]), static_cast<long long>(values[2]));
+	if (length < 0 || static_cast<size_t>(length) >= sizeof(buffer))
+		return false;
+	result.append(buffer, length);
+	return true;
+}
+bool serializeWebHex(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	return appendWebHex(colorObject.getColor(), options, result);
+}
+bool serializeWebHexNoHash(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	return appendHex(colorObject.getColor(), 255, options.upperCase, "%02llx%02llx%02llx", "%02llX%02llX%02llX", result);
+}
+bool serializeWebHex3Digit(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	result += '#';
+	return appendHex(colorObject.getColor(), 15, options.upperCase, "%01llx%01llx%01llx", "%01llX%01llX%01llX", result);
+}
+bool serializeCssHsl(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &, std::string &result) {
+	Color color = colorObject.getColor(), hsl;
+	color_rgb_to_hsl(&color, &hsl);
+	result += "hsl(";
+	if (!appendHsl(hsl, result))
+		return false;
+	result += ')';
+	return true;
+}
+bool serializeCssRgb(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &, std::string &result) {
+	result += "rgb(";
+	if (!appendRgb(colorObject.getColor(), result))
+		return false;
+	result += ')';
+	return true;
+}
+bool serializeColorCssBlock(const ColorObject &colorObject, const ConverterSerializePosition &position, const BuiltinConverterOptions &options, std::string &result) {
+	const Color &color = colorObject.getColor();
+	if (position.first()) {
+		result += "/**\n * Generated by Gpick ";
+		result += options.version;
+		result += '\n';
+	}
+	result += " * ";
+	result += colorObject.getName();
+	result += ": ";
+	if (!appendWebHex(color, options, result))
+		return false;
+	result += ", rgb(";
+	if (!appendRgb(color, result))
+		return false;
+	// Lua version reads HSL components from RGB color, keep it that way.
+	result += "), hsl(";
+	if (!appendHsl(color, result))
+		return false;
+	result += ')';
+	if (position.last())
+		result += "\n */";
+	return true;
+}
+bool serializePrefixedWebHex(const char *prefix, const ColorObject &colorObject, const BuiltinConverterOptions &options, std::string &result) {
+	result += prefix;
+	return appendWebHex(colorObject.getColor(), options, result);
+}
+bool serializeCssColorHex(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	return serializePrefixedWebHex("color: ", colorObject, options, result);
+}
+bool serializeCssBackgroundColorHex(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	return serializePrefixedWebHex("background-color: ", colorObject, options, result);
+}
+bool serializeCssBorderColorHex(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	return serializePrefixedWebHex("border-color: ", colorObject, options, result);
+}
+bool serializeCssBorderTopColorHex(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	return serializePrefixedWebHex("border-top-color: ", colorObject, options, result);
+}
+bool serializeCssBorderRightColorHex(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	return serializePrefixedWebHex("border-right-color: ", colorObject, options, result);
+}
+bool serializeCssBorderBottomColorHex(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	return serializePrefixedWebHex("border-bottom-color: ", colorObject, options, result);
+}
+bool serializeCssBorderLeftHex(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &options, std::string &result) {
+	return serializePrefixedWebHex("border-left-color: ", colorObject, options, result);
+}
+bool serializeColorCsv(const ColorObject &colorObject, const ConverterSerializePosition &, const BuiltinConverterOptions &, std::string &result) {
+	const Color &color = colorObject.getColor();
+	std::ostringstream stream;
+	stream.imbue(std::locale::classic());
+	stream << std::fixed << std::setprecision(6) << static_cast<double>(color.rgb.red) << '\t' << static_cast<double>(color.rgb.green) << '\t' << static_cast<double>(color.rgb.blue);
+	result += stream.str();
+	return true;
+}
+bool isHexDigit(char value) {
+	return (value >= '0' && value <= '9') || (value >= 'a' && value <= 'f') || (value >= 'A' && value <= 'F');
+}
+bool isDigit(char value) {
+	return value >= '0' && value <= '9';
+}
+bool isSpace(char value) {
+	return value == ' ' || (value >= '\t' && value <= '\r');
+}
+int hexValue(char value) {
+	if (value >= '0' && value <= '9')
+		return value - '0';
+	if (value >= 'a' && value <= 'f')
+		return value - 'a' + 10;
+	return value - 'A' + 10;
+}
+float getQuality(size_t start, size_t end, size_t length) {
+	return static_cast<float>(1 - std::atan(static_cast<double>(start)) / Pi - std::atan(static_cast<double>(length - end)) / Pi);
+}
+// Equivalent of string.find(text, '(#?)([%x]{n})([%x]{n})([%x]{n})[^%x]?'), start is zero based and end is one past the last matched character.
+bool findHex(const char *value, bool hash, int digits, int components[3], size_t &start, size_t &end) {
+	size_t length = std::strlen(value);
+	size_t matchLength = (hash ? 1 : 0) + digits * 3;
+	for (size_t i = 0; i + matchLength <= length; i++) {
+		if (hash && value[i] != '#')
+			continue;
+		const char *data = value + i + (hash ? 1 : 0);
+		bool valid = true;
+		for (int j = 0; j < digits * 3; j++) {
+			if (!isHexDigit(data[j])) {
+				valid = false;
+				break;
+			}
+		}
+		if (!valid)
+			continue;
+		for (int j = 0; j < 3; j++) {
+			components[j] = 0;
+			for (int k = 0; k < digits; k++)
+				components[j] = components[j] * 16 + hexValue(data[j * digits + k]);
+		}
+		start = i;
+		end = i + matchLength;
+		if (end < length && !isHexDigit(value[end]))
+			end++;
+		return true;
+	}
+	return false;
+}
+bool deserializeHex(const char *value, bool hash, int digits, double scale, ColorObject &colorObject, float &quality) {
+	int components[3];
+	size_t start, end;
+	if (!findHex(value, hash, digits, components, start, end)) {
+		quality = -1;
+		return true;
+	}
+	Color color;
+	color.rgb.red = static_cast<float>(components[0] / scale);
+	color.rgb.green = static_cast<float>(components[1] / scale);
+	color.rgb.blue = static_cast<float>(components[2] / scale);
+	colorObject.setColor(color);
+	quality = getQuality(start, end, std::strlen(value));
+	return true;
+}
+bool deserializeWebHex(const char *value, ColorObject &colorObject, float &quality) {
+	return deserializeHex(value, true, 2, 255, colorObject, quality);
+}
+bool deserializeWebHexNoHash(const char *value, ColorObject &colorObject, float &quality) {
+	return deserializeHex(value, false, 2, 255, colorObject, quality);
+}
+bool deserializeWebHex3Digit(const char *value, ColorObject &colorObject, float &quality) {
+	return deserializeHex(value, true, 1, 15, colorObject, quality);
+}
+const char *skipDigits(const char *value) {
+	while (isDigit(*value))
+		value++;
+	return value;
+}
+const char *skipSpaces(const char *value) {
+	while (isSpace(*value))
+		value++;
+	return value;
+}
+// Equivalent of string.find(text, 'rgb%(([%d]*)[%s]*,[%s]*([%d]*)[%s]*,[%s]*([%d]*)%)').
+bool findRgb(const char *value, const char *components[3][2], size_t &start, size_t &end) {
+	for (const char *i = std::strstr(value, "rgb("); i != nullptr; i = std::strstr(i + 1, "rgb(")) {
+		const char *position = i + 4;
+		bool valid = true;
+		for (int j = 0; j < 3; j++) {
+			if (j > 0) {
+				position = skipSpaces(position);
+				if (*position != ',') {
+					valid = false;
+					break;
+				}
+				position = skipSpaces(position + 1);
+			}
+			components[j][0] = position;
+			position = skipDigits(position);
+			components[j][1] = position;
+		}
+		if (!valid || *position != ')')
+			continue;
+		start = i - value;
+		end = position + 1 - value;
+		return true;
+	}
+	return false;
+}
+bool deserializeCssRgb(const char *value, ColorObject &colorObject, float &quality) {
+	const char *components[3][2];
+	size_t start, end;
+	if (!findRgb(value, components, start, end)) {
+		quality = -1;
+		return true;
+	}
+	double values[3];
+	for (int i = 0; i < 3; i++) {
+		// Lua version fails with arithmetic on empty string.
+		if (components[i][0] == components[i][1])
+			return false;
+		std::string digits(components[i][0], components[i][1]);
+		values[i] = std::min(1.0, std::strtod(digits.c_str(), nullptr) / 255);
+	}
+	Color color;
+	color.rgb.red = static_cast<float>(values[0]);
+	color.rgb.green = static_cast<float>(values[1]);
+	color.rgb.blue = static_cast<float>(values[2]);
+	colorObject.setColor(color);
+	quality = getQuality(start, end, std::strlen(value));
+	return true;
+}
+const BuiltinConverter converters[] = {
+	{ "color_web_hex", serializeWebHex, deserializeWebHex },
+	{ "color_web_hex_3_digit", serializeWebHex3Digit, deserializeWebHex3Digit },
+	{ "color_web_hex_no_hash", serializeWebHexNoHash, deserializeWebHexNoHash },
+	{ "color_css_hsl", serializeCssHsl, nullptr },
+	{ "color_css_rgb", serializeCssRgb, deserializeCssRgb },
+	{ "css_color_hex", serializeCssColorHex, nullptr },
+	{ "css_background_color_hex", serializeCssBackgroundColorHex, nullptr },
+	{ "css_border_color_hex", serializeCssBorderColorHex, nullptr },
+	{ "css_border_top_color_hex", serializeCssBorderTopColorHex, nullptr },
+	{ "css_border_right_color_hex", serializeCssBorderRightColorHex, nullptr },
+	{ "css_border_bottom_color_hex", serializeCssBorderBottomColorHex, nullptr },
+	{ "css_border_left_hex", serializeCssBorderLeftHex, nullptr },
+	{ "color_csv", serializeColorCsv, nullptr },
+	{ "color_css_block", serializeColorCssBlock, nullptr },
+};
+}
+BuiltinConverterOptions::BuiltinConverterOptions():
+	upperCase(false) {
+}
+const BuiltinConverter *getBuiltinConverter(const std::string &name) {
+	for (auto &converter: converters) {
+		if (name == converter.name)
+			return &converter;
+	}
+	return nullptr;
+}
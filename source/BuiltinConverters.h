@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_BUILTIN_CONVERTERS_H_
+#define GPICK_BUILTIN_CONVERTERS_H_
+#include <string>
+struct ColorObject;
+struct ConverterSerializePosition;
+struct BuiltinConverterOptions {
+	BuiltinConverterOptions();
+	bool upperCase;
+	std::string version;
+};
+// Native versions of converters from share/gpick/converters.lua. Results must match Lua versions byte for byte.
+struct BuiltinConverter {
+	const char *name;
+	// Returns false when result can not be produced natively and Lua version should be used instead.
+	bool (*serialize)(const ColorObject &colorObject, const ConverterSerializePosition &position, const BuiltinConverterOptions &options, std::string &result);
+	bool (*deserialize)(const char *value, ColorObject &colorObject, float &quality);
+};
+const BuiltinConverter *getBuiltinConverter(const std::string &name);
+#endif /* GPICK_BUILTIN_CONVERTERS_H_ */
@@ -64,19 +64,13 @@ static void setData(GtkClipboard *, GtkSelectionData *selectionData, Target targ
 		const auto &colors = args->colors->colors;
 		std::stringstream text;
 		std::string textLine;
-		ConverterSerializePosition position(args->colors->colors.size());
-		if (position.count() > 0) {
-			for (auto &color: colors) {
-				if (position.index() + 1 == position.count())
-					position.last(true);
-				textLine = args->converter->serialize(color, position);
-				if (position.first()) {
-					text << textLine;
-					position.first(false);
-				} else {
-					text << "\n" << textLine;
-				}
-				position.incrementIndex();
+		bool first = true;
+		for (auto &line: args->converter->serialize(std::vector<ColorObject *>(colors.begin(), colors.end()))) {
+			if (first) {
+				text << line;
+				first = false;
+			} else {
+				text << "\n" << line;
 			}
 		}
 		textLine = text.str();
@@ -337,6 +331,7 @@ ColorList *getColors(GlobalState *gs) {
 			//TODO: multiple colors should be extracted from string, but converters do not support this right now
 			if (gs->converters().deserialize(text.c_str(), &colorObject)) {
 				color_list_add_color_object(colorList, colorObject, false);
+				colorObject->release();
 				success = true;
 				return VisitResult::stop;
 			}
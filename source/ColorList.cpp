@@ -25,12 +25,14 @@ ColorList* color_list_new()
 {
 	ColorList* color_list = new ColorList;
 	color_list->on_insert = nullptr;
+	color_list->on_insert_many = nullptr;
 	color_list->on_change = nullptr;
 	color_list->on_delete = nullptr;
 	color_list->on_clear = nullptr;
 	color_list->on_delete_selected = nullptr;
 	color_list->on_get_positions = nullptr;
 	color_list->userdata = nullptr;
+	color_list->revision = 0;
 	return color_list;
 }
 ColorList* color_list_new(ColorList *color_list)
@@ -74,6 +76,7 @@ ColorObject* color_list_add_color(ColorList *color_list, const Color *color)
 int color_list_add_color_object(ColorList *color_list, ColorObject *color_object, bool add_to_palette)
 {
 	color_list->colors.push_back(color_object->reference());
+	color_list->revision++;
 	if (add_to_palette && color_list->on_insert)
 		color_list->on_insert(color_list, color_object);
 	return 0;
@@ -82,17 +85,36 @@ int color_list_add_color_object(ColorList *color_list, const ColorObject &colorO
 {
 	ColorObject *reference;
 	color_list->colors.push_back((reference = colorObject.copy()));
+	color_list->revision++;
 	if (add_to_palette && color_list->on_insert)
 		color_list->on_insert(color_list, reference);
 	return 0;
 }
-int color_list_add(ColorList *color_list, ColorList *items, bool add_to_palette)
+template<typename T>
+static void addColorObjects(ColorList *color_list, const T &items, bool add_to_palette)
 {
-	for (auto color_object: items->colors){
+	vector<ColorObject*> visible;
+	color_list->revision++;
+	for (auto color_object: items){
 		color_list->colors.push_back(color_object->reference());
-		if (add_to_palette && color_list->on_insert && color_object->isVisible())
-			color_list->on_insert(color_list, color_object);
+		if (add_to_palette && color_object->isVisible()){
+			if (color_list->on_insert_many)
+				visible.push_back(color_object);
+			else if (color_list->on_insert)
+				color_list->on_insert(color_list, color_object);
+		}
 	}
+	if (!visible.empty())
+		color_list->on_insert_many(color_list, visible);
+}
+int color_list_add(ColorList *color_list, ColorList *items, bool add_to_palette)
+{
+	addColorObjects(color_list, items->colors, add_to_palette);
+	return 0;
+}
+int color_list_add(ColorList *color_list, const std::vector<ColorObject*> &items, bool add_to_palette)
+{
+	addColorObjects(color_list, items, add_to_palette);
 	return 0;
 }
 int color_list_remove_color_object(ColorList *color_list, ColorObject *color_object)
@@ -101,6 +123,7 @@ int color_list_remove_color_object(ColorList *color_list, ColorObject *color_obj
 	if (i != color_list->colors.end()){
 		if (color_list->on_delete) color_list->on_delete(color_list, color_object);
 		color_list->colors.erase(i);
+		color_list->revision++;
 		color_object->release();
 		return 0;
 	}else return -1;
@@ -114,6 +137,7 @@ int color_list_remove_selected(ColorList *color_list)
 			i = color_list->colors.erase(i);
 		}else ++i;
 	}
+	color_list->revision++;
 	color_list->on_delete_selected(color_list);
 	return 0;
 }
@@ -137,6 +161,14 @@ int color_list_remove_all(ColorList *color_list)
 		}
 	}
 	color_list->colors.clear();
+	color_list->revision++;
+	return 0;
+}
+int color_list_changed(ColorList *color_list, ColorObject *color_object)
+{
+	color_list->revision++;
+	if (color_list->on_change)
+		color_list->on_change(color_list, color_object);
 	return 0;
 }
 size_t color_list_get_count(ColorList *color_list)
@@ -158,3 +190,23 @@ int color_list_get_positions(ColorList *color_list)
 	}
 	return 0;
 }
+int color_list_get_palette_order(ColorList *color_list, std::vector<ColorObject*> &colors)
+{
+	color_list_get_positions(color_list);
+	std::vector<ColorObject*> hidden;
+	colors.clear();
+	colors.reserve(color_list->colors.size());
+	for (auto color: color_list->colors){
+		if (color->isPositionSet())
+			colors.push_back(color);
+		else
+			hidden.push_back(color);
+	}
+	auto position_sort = [](ColorObject *a, ColorObject *b){
+		return a->getPosition() < b->getPosition();
+	};
+	if (!std::is_sorted(colors.begin(), colors.end(), position_sort))
+		std::stable_sort(colors.begin(), colors.end(), position_sort);
+	colors.insert(colors.end(), hidden.begin(), hidden.end());
+	return 0;
+}
@@ -21,6 +21,7 @@
 #include "Color.h"
 #include "dynv/Map.h"
 #include <list>
+#include <vector>
 #include <cstddef>
 struct ColorObject;
 struct ColorList
@@ -29,12 +30,16 @@ struct ColorList
 	typedef std::list<ColorObject*>::iterator iter;
 	dynv::Ref options;
 	int (*on_insert)(ColorList *color_list, ColorObject *color_object);
+	// Called once instead of on_insert for each color object when many color objects are added at once
+	int (*on_insert_many)(ColorList *color_list, const std::vector<ColorObject*> &color_objects);
 	int (*on_delete)(ColorList *color_list, ColorObject *color_object);
 	int (*on_delete_selected)(ColorList *color_list);
 	int (*on_change)(ColorList *color_list, ColorObject *color_object);
 	int (*on_clear)(ColorList *color_list);
 	int (*on_get_positions)(ColorList *color_list);
 	void* userdata;
+	// Incremented each time colors are added, removed or changed through color_list functions
+	size_t revision;
 };
 
 ColorList* color_list_new();
@@ -46,11 +51,16 @@ ColorObject* color_list_add_color(ColorList *color_list, const Color *color);
 int color_list_add_color_object(ColorList *color_list, ColorObject *color_object, bool add_to_palette);
 int color_list_add_color_object(ColorList *color_list, const ColorObject &colorObject, bool add_to_palette);
 int color_list_add(ColorList *color_list, ColorList *items, bool add_to_palette);
+int color_list_add(ColorList *color_list, const std::vector<ColorObject*> &items, bool add_to_palette);
 int color_list_remove_color_object(ColorList *color_list, ColorObject *color_object);
 int color_list_remove_selected(ColorList *color_list);
 int color_list_set_selected(ColorList *color_list, bool selected);
 int color_list_remove_all(ColorList *color_list);
+// Called after color object in the list was modified in place, calls on_change
+int color_list_changed(ColorList *color_list, ColorObject *color_object);
 size_t color_list_get_count(ColorList *color_list);
 int color_list_get_positions(ColorList *color_list);
+// Updates positions and returns visible colors sorted by position, followed by hidden colors
+int color_list_get_palette_order(ColorList *color_list, std::vector<ColorObject*> &colors);
 
 #endif /* GPICK_COLOR_LIST_H_ */
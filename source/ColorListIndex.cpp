@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ColorListIndex.h"
+#include "ColorObject.h"
+#include "Color.h"
+#include "MathUtil.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+namespace {
+const int SpaceDivisions = 16;
+struct Entry {
+	std::string name;
+	std::vector<uint32_t> trigrams;
+	Color lab;
+	uint32_t cell;
+};
+std::string toLower(const std::string &value) {
+	std::string result(value);
+	for (auto &ch: result) {
+		if (ch >= 'A' && ch <= 'Z')
+			ch = static_cast<char>(ch - 'A' + 'a');
+	}
+	return result;
+}
+std::vector<uint32_t> getTrigrams(const std::string &value) {
+	std::vector<uint32_t> result;
+	if (value.length() < 3)
+		return result;
+	result.reserve(value.length() - 2);
+	for (size_t i = 0, end = value.length() - 2; i < end; i++) {
+		auto data = reinterpret_cast<const uint8_t *>(value.data() + i);
+		result.push_back(static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 | static_cast<uint32_t>(data[2]) << 16);
+	}
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+int cellL(float value) {
+	return clamp_int(static_cast<int>(std::floor(value / 100.0f * SpaceDivisions)), 0, SpaceDivisions - 1);
+}
+int cellAB(float value) {
+	return clamp_int(static_cast<int>(std::floor((value + 128.0f) / 256.0f * SpaceDivisions)), 0, SpaceDivisions - 1);
+}
+uint32_t getCell(int l, int a, int b) {
+	return static_cast<uint32_t>((l * SpaceDivisions + a) * SpaceDivisions + b);
+}
+float distance(const Color &a, const Color &b) {
+	float dl = a.lab.L - b.lab.L, da = a.lab.a - b.lab.a, db = a.lab.b - b.lab.b;
+	return std::sqrt(dl * dl + da * da + db * db);
+}
+}
+struct ColorListIndex::Impl {
+	std::unordered_map<ColorObject *, Entry> m_entries;
+	std::unordered_map<uint32_t, std::unordered_set<ColorObject *>> m_trigrams;
+	std::unordered_map<uint32_t, std::unordered_set<ColorObject *>> m_cells;
+	~Impl() {
+		clear();
+	}
+	void fill(ColorObject *colorObject, Entry &entry) {
+		entry.name = toLower(colorObject->getName());
+		entry.trigrams = getTrigrams(entry.name);
+		auto color = colorObject->getColor();
+		color_rgb_to_lab_d50(&color, &entry.lab);
+		entry.cell = getCell(cellL(entry.lab.lab.L), cellAB(entry.lab.lab.a), cellAB(entry.lab.lab.b));
+		for (auto trigram: entry.trigrams)
+			m_trigrams[trigram].insert(colorObject);
+		m_cells[entry.cell].insert(colorObject);
+	}
+	void unlink(ColorObject *colorObject, const Entry &entry) {
+		for (auto trigram: entry.trigrams) {
+			auto i = m_trigrams.find(trigram);
+			if (i == m_trigrams.end())
+				continue;
+			i->second.erase(colorObject);
+			if (i->second.empty())
+				m_trigrams.erase(i);
+		}
+		auto i = m_cells.find(entry.cell);
+		if (i != m_cells.end()) {
+			i->second.erase(colorObject);
+			if (i->second.empty())
+				m_cells.erase(i);
+		}
+	}
+	void add(ColorObject *colorObject) {
+		auto i = m_entries.find(colorObject);
+		if (i != m_entries.end()) {
+			unlink(colorObject, i->second);
+			fill(colorObject, i->second);
+			return;
+		}
+		fill(colorObject->reference(), m_entries[colorObject]);
+	}
+	void remove(ColorObject *colorObject) {
+		auto i = m_entries.find(colorObject);
+		if (i == m_entries.end())
+			return;
+		unlink(colorObject, i->second);
+		m_entries.erase(i);
+		colorObject->release();
+	}
+	void update(ColorObject *colorObject) {
+		auto i = m_entries.find(colorObject);
+		if (i == m_entries.end())
+			return;
+		unlink(colorObject, i->second);
+		fill(colorObject, i->second);
+	}
+	void clear() {
+		for (auto &entry: m_entries)
+			entry.first->release();
+		m_entries.clear();
+		m_trigrams.clear();
+		m_cells.clear();
+	}
+	void findByName(const std::string &text, std::function<bool(ColorObject *)> callback) const {
+		auto query = toLower(text);
+		auto trigrams = getTrigrams(query);
+		if (trigrams.empty()) {
+			for (auto &entry: m_entries) {
+				if (entry.second.name.find(query) == std::string::npos)
+					continue;
+				if (!callback(entry.first))
+					return;
+			}
+			return;
+		}
+		const std::unordered_set<ColorObject *> *candidates = nullptr;
+		for (auto trigram: trigrams) {
+			auto i = m_trigrams.find(trigram);
+			if (i == m_trigrams.end())
+				return;
+			if (!candidates || i->second.size() < candidates->size())
+				candidates = &i->second;
+		}
+		for (auto colorObject: *candidates) {
+			auto &entry = m_entries.at(colorObject);
+			if (entry.name.find(query) == std::string::npos)
+				continue;
+			if (!callback(colorObject))
+				return;
+		}
+	}
+	void findByColor(const Color &color, float maxDistance, std::function<bool(ColorObject *, float)> callback) const {
+		Color lab;
+		color_rgb_to_lab_d50(&color, &lab);
+		int l1 = cellL(lab.lab.L - maxDistance), l2 = cellL(lab.lab.L + maxDistance);
+		int a1 = cellAB(lab.lab.a - maxDistance), a2 = cellAB(lab.lab.a + maxDistance);
+		int b1 = cellAB(lab.lab.b - maxDistance), b2 = cellAB(lab.lab.b + maxDistance);
+		for (int l = l1; l <= l2; l++) {
+			for (int a = a1; a <= a2; a++) {
+				for (int b = b1; b <= b2; b++) {
+					auto i = m_cells.find(getCell(l, a, b));
+					if (i == m_cells.end())
+						continue;
+					for (auto colorObject: i->second) {
+						float delta = distance(m_entries.at(colorObject).lab, lab);
+						if (delta > maxDistance)
+							continue;
+						if (!callback(colorObject, delta))
+							return;
+					}
+				}
+			}
+		}
+	}
+};
+ColorListIndex::ColorListIndex():
+	m_impl(std::make_unique<Impl>()) {
+}
+ColorListIndex::~ColorListIndex() {
+}
+void ColorListIndex::add(ColorObject *colorObject) {
+	m_impl->add(colorObject);
+}
+void ColorListIndex::remove(ColorObject *colorObject) {
+	m_impl->remove(colorObject);
+}
+void ColorListIndex::update(ColorObject *colorObject) {
+	m_impl->update(colorObject);
+}
+void ColorListIndex::clear() {
+	m_impl->clear();
+}
+size_t ColorListIndex::size() const {
+	return m_impl->m_entries.size();
+}
+bool ColorListIndex::contains(ColorObject *colorObject) const {
+	return m_impl->m_entries.find(colorObject) != m_impl->m_entries.end();
+}
+void ColorListIndex::findByName(const std::string &text, std::function<bool(ColorObject *)> callback) const {
+	m_impl->findByName(text, callback);
+}
+void ColorListIndex::findByColor(const Color &color, float distance, std::function<bool(ColorObject *, float)> callback) const {
+	m_impl->findByColor(color, distance, callback);
+}
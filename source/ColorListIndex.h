@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_COLOR_LIST_INDEX_H_
+#define GPICK_COLOR_LIST_INDEX_H_
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstddef>
+struct ColorObject;
+struct Color;
+// Incrementally maintained search index over color object names (trigrams) and colors (CIE Lab grid).
+struct ColorListIndex {
+	ColorListIndex();
+	~ColorListIndex();
+	void add(ColorObject *colorObject);
+	void remove(ColorObject *colorObject);
+	void update(ColorObject *colorObject);
+	void clear();
+	size_t size() const;
+	bool contains(ColorObject *colorObject) const;
+	// Callback receives each color object which name contains text (ASCII case insensitive). Search stops when callback returns false.
+	void findByName(const std::string &text, std::function<bool(ColorObject *)> callback) const;
+	// Callback receives each color object within CIE76 distance from color. Search stops when callback returns false.
+	void findByColor(const Color &color, float distance, std::function<bool(ColorObject *, float)> callback) const;
+private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+};
+#endif /* GPICK_COLOR_LIST_INDEX_H_ */
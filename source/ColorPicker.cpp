@@ -25,6 +25,7 @@
 #include "DragDrop.h"
 #include "Converters.h"
 #include "dynv/Map.h"
+#include "dynv/Handle.h"
 #include "FloatingPicker.h"
 #include "ColorRYB.h"
 #include "ColorWheelType.h"
@@ -90,6 +91,8 @@ struct ColorPickerArgs {
 	FloatingPicker floating_picker;
 	dynv::Ref options;
 	dynv::Ref mainOptions;
+	// Read on every screen update
+	dynv::Handle<bool> zoomedEnabled;
 	GlobalState* gs;
 	bool ignore_callback;
 
@@ -197,7 +200,7 @@ static int source_get_nth_color(ColorPickerArgs *args, uint32_t color_n, ColorOb
 
 static void updateMainColorNow(ColorPickerArgs* args)
 {
-	if (!args->options->getBool("zoomed_enabled", true)){
+	if (!args->zoomedEnabled()){
 		Color c;
 		gtk_swatch_get_active_color(GTK_SWATCH(args->swatch_display), &c);
 		string text = args->gs->converters().serialize(c, Converters::Type::display);
@@ -222,7 +225,7 @@ static gboolean updateMainColor( gpointer data ){
 	Rect2<int> sampler_rect, zoomed_rect, final_rect;
 	sampler_get_screen_rect(args->gs->getSampler(), pointer, screen_rect, &sampler_rect);
 	screen_reader_add_rect(screen_reader, screen, sampler_rect);
-	bool zoomed_enabled = args->options->getBool("zoomed_enabled", true);
+	bool zoomed_enabled = args->zoomedEnabled();
 	if (zoomed_enabled){
 		gtk_zoomed_get_screen_rect(GTK_ZOOMED(args->zoomed_display), pointer, screen_rect, &zoomed_rect);
 		screen_reader_add_rect(screen_reader, screen, zoomed_rect);
@@ -731,7 +734,7 @@ static int source_activate(ColorPickerArgs *args)
 	gtk_color_set_transformation_chain(GTK_COLOR(args->color_code), chain);
 	gtk_color_set_transformation_chain(GTK_COLOR(args->contrastCheck), chain);
 
-	if (args->options->getBool("zoomed_enabled", true)){
+	if (args->zoomedEnabled()){
 		auto refresh_rate = args->mainOptions->getInt32("refresh_rate", 30);
 		args->timeout_source_id = g_timeout_add_full(G_PRIORITY_DEFAULT_IDLE, static_cast<int>(1000 / refresh_rate), (GSourceFunc)updateMainColorTimer, args, (GDestroyNotify)nullptr);
 	}
@@ -802,9 +805,9 @@ static void show_dialog_converter(GtkWidget *widget, ColorPickerArgs *args){
 }
 
 static void on_zoomed_activate(GtkWidget *widget, ColorPickerArgs *args){
-	if (args->options->getBool("zoomed_enabled", true)){
+	if (args->zoomedEnabled()){
 		gtk_zoomed_set_fade(GTK_ZOOMED(args->zoomed_display), true);
-		args->options->set("zoomed_enabled", false);
+		args->zoomedEnabled.set(false);
 
 		if (args->timeout_source_id > 0){
 			g_source_remove(args->timeout_source_id);
@@ -812,7 +815,7 @@ static void on_zoomed_activate(GtkWidget *widget, ColorPickerArgs *args){
 		}
 	}else{
 		gtk_zoomed_set_fade(GTK_ZOOMED(args->zoomed_display), false);
-		args->options->set("zoomed_enabled", true);
+		args->zoomedEnabled.set(true);
 
 		if (args->timeout_source_id > 0){
 			g_source_remove(args->timeout_source_id);
@@ -830,6 +833,7 @@ static ColorSource* source_implement(ColorSource *source, GlobalState *gs, const
 
 	args->options = options;
 	args->mainOptions = gs->settings().getOrCreateMap("gpick.picker");
+	args->zoomedEnabled.bind(options, "zoomed_enabled", true);
 	args->statusbar = gs->getStatusBar();
 	args->floating_picker = 0;
 	args->ignore_callback = false;
@@ -22,6 +22,7 @@
 #include "lua/Color.h"
 #include "lua/Script.h"
 #include "lua/Callbacks.h"
+#include "lua/Profiler.h"
 extern "C"{
 #include <lua.h>
 }
@@ -91,6 +92,7 @@ std::list<std::string> color_space_color_to_text(const char *type, const Color *
 	gs->callbacks().componentToText().get();
 	lua_pushstring(L, type);
 	lua::pushColor(L, *color);
+	lua::Profiler::Scope scope(gs->callbacks().componentToTextSite(), L);
 	int status = lua_pcall(L, 2, 1, 0);
 	if (status == 0){
 		if (lua_type(L, -1) == LUA_TTABLE){
@@ -108,7 +110,9 @@ std::list<std::string> color_space_color_to_text(const char *type, const Color *
 		}else{
 			cerr << "componentToText: returned not a table value, type is \"" << type << "\"" << endl;
 		}
+		scope.error();
 	}else{
+		scope.error();
 		cerr << "componentToText: " << lua_tostring(L, -1) << endl;
 	}
 	lua_settop(L, stack_top);
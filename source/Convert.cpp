@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Convert.h"
+#include "GlobalState.h"
+#include "ImportExport.h"
+#include "ColorList.h"
+#include "Converters.h"
+#include "Converter.h"
+#include "lua/ScriptPool.h"
+#include <iostream>
+using namespace std;
+
+int convert_palette(const char *input_filename, const char *output_filename, const char *converter_name)
+{
+	GlobalState gs;
+	if (!gs.loadHeadless()){
+		cerr << "Could not initialize Lua scripts" << endl;
+		return -1;
+	}
+	FileType output_type = converter_name ? FileType::txt : ImportExport::getFileType(output_filename);
+	if (output_type == FileType::unknown || output_type == FileType::rgbtxt){
+		cerr << "Output file format is not supported: " << output_filename << endl;
+		return -1;
+	}
+	Converter *converter = nullptr;
+	if (output_type == FileType::txt){
+		converter = converter_name ? gs.converters().byName(converter_name) : gs.converters().display();
+		if (!converter || !converter->hasSerialize()){
+			cerr << "Converter not found: " << (converter_name ? converter_name : "") << endl;
+			return -1;
+		}
+	}
+	ColorList *color_list = color_list_new();
+	ImportExport import(color_list, input_filename, &gs.settings());
+	import.setConverters(&gs.converters());
+	if (!import.importType(ImportExport::getFileType(input_filename))){
+		cerr << "File could not be imported: " << input_filename << endl;
+		color_list_destroy(color_list);
+		return -1;
+	}
+	ImportExport output(color_list, output_filename, &gs.settings());
+	output.setConverter(converter);
+	output.setSerializer([&gs](const Converter &converter, const vector<ColorObject*> &color_objects, vector<string> &lines) {
+		return gs.scriptPool().serialize(converter.name(), color_objects, lines);
+	});
+	bool exported = output.exportType(output_type);
+	color_list_destroy(color_list);
+	if (!exported){
+		cerr << "File could not be exported: " << output_filename << endl;
+		return -1;
+	}
+	return 0;
+}
@@ -17,7 +17,7 @@
  */
 
 #include "Converter.h"
-#include "GlobalState.h"
+#include "BuiltinConverters.h"
 #include "ColorObject.h"
 #include "lua/Color.h"
 #include "lua/ColorObject.h"
@@ -44,12 +44,37 @@ Converter::Converter(const char *name, const char *label, lua::Ref &&serialize,
 	m_serialize(move(serialize)),
 	m_deserialize(move(deserialize)),
 	m_copy(false),
-	m_paste(false)
+	m_paste(false),
+	m_builtin(nullptr),
+	m_builtinOptions(nullptr),
+	m_serializeSite(nullptr),
+	m_deserializeSite(nullptr),
+	m_serializeManySite(nullptr)
+{
+}
+Converter::Converter(const char *name, const char *label, lua::Ref &&serialize, lua::Ref &&deserialize, lua::Ref &&serializeMany):
+	m_name(name),
+	m_label(label),
+	m_serialize(move(serialize)),
+	m_deserialize(move(deserialize)),
+	m_serializeMany(move(serializeMany)),
+	m_copy(false),
+	m_paste(false),
+	m_builtin(nullptr),
+	m_builtinOptions(nullptr),
+	m_serializeSite(nullptr),
+	m_deserializeSite(nullptr),
+	m_serializeManySite(nullptr)
 {
 }
 std::string Converter::serialize(const ColorObject &colorObject, const ConverterSerializePosition &position) {
 	if (!m_serialize.valid())
 		return "";
+	if (m_builtin && m_builtin->serialize) {
+		string result;
+		if (m_builtin->serialize(colorObject, position, *m_builtinOptions, result))
+			return result;
+	}
 	lua_State *L = m_serialize.script();
 	int stack_top = lua_gettop(L);
 	m_serialize.get();
@@ -63,6 +88,7 @@ std::string Converter::serialize(const ColorObject &colorObject, const Converter
 	lua_setfield(L, -2, "index");
 	lua_pushinteger(L, position.count());
 	lua_setfield(L, -2, "count");
+	lua::Profiler::Scope scope(m_serializeSite, L);
 	int status = lua_pcall(L, 2, 1, 0);
 	if (status == 0){
 		if (lua_type(L, -1) == LUA_TSTRING){
@@ -72,7 +98,9 @@ std::string Converter::serialize(const ColorObject &colorObject, const Converter
 		}else{
 			cerr << "serialize: returned not a string value \"" << m_name << "\"" << endl;
 		}
+		scope.error();
 	}else{
+		scope.error();
 		cerr << "serialize: " << lua_tostring(L, -1) << endl;
 	}
 	lua_settop(L, stack_top);
@@ -82,15 +110,92 @@ std::string Converter::serialize(const ColorObject *color_object, const Converte
 {
 	return serialize(*color_object, position);
 }
+bool Converter::serializeMany(const std::vector<ColorObject *> &colorObjects, std::vector<std::string> &result)
+{
+	lua_State *L = m_serializeMany.script();
+	int stack_top = lua_gettop(L);
+	m_serializeMany.get();
+	std::vector<ColorObject *> copies;
+	copies.reserve(colorObjects.size());
+	lua_createtable(L, static_cast<int>(colorObjects.size()), 0);
+	for (size_t i = 0; i < colorObjects.size(); i++){
+		copies.push_back(colorObjects[i]->copy());
+		lua::pushColorObject(L, copies.back());
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua::Profiler::Scope scope(m_serializeManySite, L);
+	int status = lua_pcall(L, 1, 1, 0);
+	bool valid = false;
+	if (status == 0){
+		if (lua_type(L, -1) == LUA_TTABLE && lua_rawlen(L, -1) == colorObjects.size()){
+			result.reserve(colorObjects.size());
+			valid = true;
+			for (size_t i = 0; i < colorObjects.size(); i++){
+				lua_rawgeti(L, -1, i + 1);
+				if (lua_type(L, -1) != LUA_TSTRING){
+					valid = false;
+					break;
+				}
+				result.push_back(lua_tostring(L, -1));
+				lua_pop(L, 1);
+			}
+		}
+		if (!valid){
+			cerr << "serializeMany: returned not an array of strings \"" << m_name << "\"" << endl;
+			scope.error();
+		}
+	}else{
+		scope.error();
+		cerr << "serializeMany: " << lua_tostring(L, -1) << endl;
+	}
+	lua_settop(L, stack_top);
+	for (auto colorObject: copies)
+		colorObject->release();
+	return valid;
+}
+void Converter::serialize(const ColorObject &colorObject, const ConverterSerializePosition &position, std::string &result) {
+	if (m_serialize.valid() && m_builtin && m_builtin->serialize) {
+		size_t length = result.length();
+		if (m_builtin->serialize(colorObject, position, *m_builtinOptions, result))
+			return;
+		result.resize(length);
+	}
+	result += serialize(colorObject, position);
+}
+std::vector<std::string> Converter::serialize(const std::vector<ColorObject *> &colorObjects)
+{
+	std::vector<std::string> result;
+	if (colorObjects.empty())
+		return result;
+	bool builtin = m_builtin && m_builtin->serialize;
+	if (!builtin && m_serializeMany.valid()){
+		if (serializeMany(colorObjects, result))
+			return result;
+		result.clear();
+	}
+	result.reserve(colorObjects.size());
+	ConverterSerializePosition position(colorObjects.size());
+	for (auto colorObject: colorObjects){
+		if (position.index() + 1 == position.count())
+			position.last(true);
+		result.push_back(serialize(*colorObject, position));
+		position.first(false);
+		position.incrementIndex();
+	}
+	return result;
+}
 bool Converter::deserialize(const char *value, ColorObject *color_object, float &quality)
 {
 	if (!m_deserialize.valid())
 		return "";
+	if (m_builtin && m_builtin->deserialize)
+		return m_builtin->deserialize(value, *color_object, quality);
 	lua_State *L = m_deserialize.script();
 	int stack_top = lua_gettop(L);
 	m_deserialize.get();
 	lua_pushstring(L, value);
 	lua::pushColorObject(L, color_object);
+	lua::Profiler::Scope scope(m_deserializeSite, L);
 	int status = lua_pcall(L, 2, 1, 0);
 	if (status == 0){
 		if (lua_type(L, -1) == LUA_TNUMBER){
@@ -100,7 +205,9 @@ bool Converter::deserialize(const char *value, ColorObject *color_object, float
 		}else{
 			cerr << "deserialize: returned not a number value \"" << m_name <<"\"" << endl;
 		}
+		scope.error();
 	}else{
+		scope.error();
 		cerr << "deserialize: " << lua_tostring(L, -1) << endl;
 	}
 	lua_settop(L, stack_top);
@@ -137,6 +244,10 @@ bool Converter::hasDeserialize() const
 {
 	return m_deserialize.valid();
 }
+bool Converter::hasSerializeMany() const
+{
+	return m_serializeMany.valid();
+}
 void Converter::copy(bool value)
 {
 	m_copy = value;
@@ -153,46 +264,30 @@ bool Converter::paste() const
 {
 	return m_paste;
 }
-
-ConverterSerializePosition::ConverterSerializePosition():
-	m_first(true),
-	m_last(true),
-	m_index(0),
-	m_count(1)
+const BuiltinConverter *Converter::builtin() const
 {
+	return m_builtin;
 }
-ConverterSerializePosition::ConverterSerializePosition(size_t count):
-	m_first(true),
-	m_last(count <= 1),
-	m_index(0),
-	m_count(count)
+void Converter::builtin(const BuiltinConverter *builtin, const BuiltinConverterOptions *options)
 {
+	m_builtin = builtin;
+	m_builtinOptions = options;
 }
-bool ConverterSerializePosition::first() const
+void Converter::profiler(lua::Profiler *profiler)
 {
-	return m_first;
-}
-bool ConverterSerializePosition::last() const
-{
-	return m_last;
-}
-size_t ConverterSerializePosition::index() const
-{
-	return m_index;
-}
-size_t ConverterSerializePosition::count() const
-{
-	return m_count;
-}
-void ConverterSerializePosition::incrementIndex()
-{
-	m_index++;
+	if (!profiler) {
+		m_serializeSite = m_deserializeSite = m_serializeManySite = nullptr;
+		return;
+	}
+	m_serializeSite = m_serialize.valid() ? profiler->site(m_name + ".serialize") : nullptr;
+	m_deserializeSite = m_deserialize.valid() ? profiler->site(m_name + ".deserialize") : nullptr;
+	m_serializeManySite = m_serializeMany.valid() ? profiler->site(m_name + ".serializeMany") : nullptr;
 }
-void ConverterSerializePosition::first(bool value)
+const ConverterSignature &Converter::signature() const
 {
-	m_first = value;
+	return m_signature;
 }
-void ConverterSerializePosition::last(bool value)
+void Converter::signature(const ConverterSignature &signature)
 {
-	m_last = value;
+	m_signature = signature;
 }
@@ -19,31 +19,24 @@
 #ifndef GPICK_CONVERTER_H_
 #define GPICK_CONVERTER_H_
 #include <string>
+#include <vector>
+#include "ConverterSerializePosition.h"
+#include "ConverterSignature.h"
 #include "lua/Ref.h"
+#include "lua/Profiler.h"
 struct ColorObject;
 struct Color;
-struct ConverterSerializePosition
-{
-	ConverterSerializePosition();
-	ConverterSerializePosition(size_t count);
-	bool first() const;
-	bool last() const;
-	size_t index() const;
-	size_t count() const;
-	void incrementIndex();
-	void first(bool value);
-	void last(bool value);
-	private:
-	bool m_first, m_last;
-	size_t m_index, m_count;
-};
+struct BuiltinConverter;
+struct BuiltinConverterOptions;
 struct Converter
 {
 	Converter(const char *name, const char *label, lua::Ref &&serialize, lua::Ref &&deserialize);
+	Converter(const char *name, const char *label, lua::Ref &&serialize, lua::Ref &&deserialize, lua::Ref &&serializeMany);
 	const std::string &name() const;
 	const std::string &label() const;
 	bool hasSerialize() const;
 	bool hasDeserialize() const;
+	bool hasSerializeMany() const;
 	bool copy() const;
 	bool paste() const;
 	void copy(bool value);
@@ -52,12 +45,27 @@ struct Converter
 	std::string serialize(const ColorObject *color_object);
 	std::string serialize(const ColorObject &colorObject, const ConverterSerializePosition &position);
 	std::string serialize(const ColorObject &colorObject);
+	// Appends serialized color to result. Builtin converters reuse result storage, so reusing result between calls avoids allocations.
+	void serialize(const ColorObject &colorObject, const ConverterSerializePosition &position, std::string &result);
 	std::string serialize(const Color &color);
+	std::vector<std::string> serialize(const std::vector<ColorObject *> &colorObjects);
 	bool deserialize(const char *value, ColorObject *color_object, float &quality);
+	const BuiltinConverter *builtin() const;
+	void builtin(const BuiltinConverter *builtin, const BuiltinConverterOptions *options);
+	// Enables measurement of Lua function calls. Sites are named "<converter>.serialize", "<converter>.deserialize" and "<converter>.serializeMany".
+	void profiler(lua::Profiler *profiler);
+	// Converters::deserialize skips this converter for text not matching the signature
+	const ConverterSignature &signature() const;
+	void signature(const ConverterSignature &signature);
 	private:
 	std::string m_name;
 	std::string m_label;
-	lua::Ref m_serialize, m_deserialize;
+	lua::Ref m_serialize, m_deserialize, m_serializeMany;
 	bool m_copy, m_paste;
+	const BuiltinConverter *m_builtin;
+	const BuiltinConverterOptions *m_builtinOptions;
+	lua::Profiler::Site *m_serializeSite, *m_deserializeSite, *m_serializeManySite;
+	ConverterSignature m_signature;
+	bool serializeMany(const std::vector<ColorObject *> &colorObjects, std::vector<std::string> &result);
 };
 #endif /* GPICK_CONVERTER_H_ */
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ConverterSerializePosition.h"
+ConverterSerializePosition::ConverterSerializePosition():
+	m_first(true),
+	m_last(true),
+	m_index(0),
+	m_count(1)
+{
+}
+ConverterSerializePosition::ConverterSerializePosition(size_t count):
+	m_first(true),
+	m_last(count <= 1),
+	m_index(0),
+	m_count(count)
+{
+}
+bool ConverterSerializePosition::first() const
+{
+	return m_first;
+}
+bool ConverterSerializePosition::last() const
+{
+	return m_last;
+}
+size_t ConverterSerializePosition::index() const
+{
+	return m_index;
+}
+size_t ConverterSerializePosition::count() const
+{
+	return m_count;
+}
+void ConverterSerializePosition::incrementIndex()
+{
+	m_index++;
+}
+void ConverterSerializePosition::index(size_t value)
+{
+	m_index = value;
+}
+void ConverterSerializePosition::first(bool value)
+{
+	m_first = value;
+}
+void ConverterSerializePosition::last(bool value)
+{
+	m_last = value;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ConverterSignature.h"
+#include <cstring>
+static bool isHexDigit(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+static char toLower(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+static bool isFunction(const char *value, const char *name)
+{
+	for (size_t i = 0; i < 3; i++) {
+		if (toLower(value[i]) != name[i])
+			return false;
+	}
+	return value[3] == '(';
+}
+ConverterSignature::Input::Input(const char *value):
+	m_features(0),
+	m_length(0)
+{
+	size_t hex_run = 0;
+	bool after_hash = false;
+	const char *i = value;
+	for (; *i; i++) {
+		char c = *i;
+		if (isHexDigit(c)) {
+			hex_run++;
+			if (c <= '9')
+				m_features |= digit;
+			if (hex_run >= 3) {
+				m_features |= hex3;
+				if (after_hash)
+					m_features |= hash3;
+			}
+			if (hex_run >= 6) {
+				m_features |= hex6;
+				if (after_hash)
+					m_features |= hash6;
+			}
+			continue;
+		}
+		hex_run = 0;
+		after_hash = c == '#';
+		if (c == 'r' || c == 'R') {
+			if (isFunction(i, "rgb"))
+				m_features |= rgb;
+		} else if (c == 'h' || c == 'H') {
+			if (isFunction(i, "hsl"))
+				m_features |= hsl;
+		}
+	}
+	m_length = i - value;
+}
+uint32_t ConverterSignature::Input::features() const
+{
+	return m_features;
+}
+size_t ConverterSignature::Input::length() const
+{
+	return m_length;
+}
+ConverterSignature::ConverterSignature():
+	m_features(0),
+	m_min_length(0)
+{
+}
+ConverterSignature::ConverterSignature(uint32_t features, size_t min_length):
+	m_features(features),
+	m_min_length(min_length)
+{
+}
+uint32_t ConverterSignature::features() const
+{
+	return m_features;
+}
+size_t ConverterSignature::minLength() const
+{
+	return m_min_length;
+}
+bool ConverterSignature::empty() const
+{
+	return m_features == 0 && m_min_length == 0;
+}
+bool ConverterSignature::matches(const Input &input) const
+{
+	return (input.features() & m_features) == m_features && input.length() >= m_min_length;
+}
+uint32_t ConverterSignature::featureByName(const char *name)
+{
+	const struct{
+		const char *name;
+		Feature feature;
+	}features[] = {
+		{"hash3", hash3},
+		{"hash6", hash6},
+		{"hex3", hex3},
+		{"hex6", hex6},
+		{"rgb", rgb},
+		{"hsl", hsl},
+		{"digit", digit},
+	};
+	for (auto &item: features) {
+		if (std::strcmp(item.name, name) == 0)
+			return item.feature;
+	}
+	return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_CONVERTER_SIGNATURE_H_
+#define GPICK_CONVERTER_SIGNATURE_H_
+#include <cstddef>
+#include <cstdint>
+// Cheap text features used to skip converters which can not deserialize given text
+struct ConverterSignature
+{
+	enum Feature: uint32_t
+	{
+		hash3 = 1 << 0, // '#' followed by at least 3 hex digits
+		hash6 = 1 << 1, // '#' followed by at least 6 hex digits
+		hex3 = 1 << 2, // at least 3 consecutive hex digits
+		hex6 = 1 << 3, // at least 6 consecutive hex digits
+		rgb = 1 << 4, // "rgb(", case insensitive
+		hsl = 1 << 5, // "hsl(", case insensitive
+		digit = 1 << 6, // at least one decimal digit
+	};
+	struct Input
+	{
+		Input(const char *value);
+		uint32_t features() const;
+		size_t length() const;
+		private:
+		uint32_t m_features;
+		size_t m_length;
+	};
+	// Signature without features matches any text
+	ConverterSignature();
+	ConverterSignature(uint32_t features, size_t min_length);
+	uint32_t features() const;
+	size_t minLength() const;
+	bool empty() const;
+	bool matches(const Input &input) const;
+	// Returns feature flag with a given name, or 0 if name is unknown
+	static uint32_t featureByName(const char *name);
+	private:
+	uint32_t m_features;
+	size_t m_min_length;
+};
+#endif /* GPICK_CONVERTER_SIGNATURE_H_ */
@@ -19,11 +19,14 @@
 #include "Converters.h"
 #include "Converter.h"
 #include "ColorObject.h"
+#include "version/Version.h"
 #include <map>
 #include <set>
 using namespace std;
-Converters::Converters()
+Converters::Converters():
+	m_profiler(nullptr)
 {
+	m_builtin_options.version = gpick_build_version;
 }
 Converters::~Converters()
 {
@@ -34,6 +37,8 @@ Converters::~Converters()
 void Converters::add(Converter *converter)
 {
 	m_all_converters.push_back(converter);
+	if (m_profiler)
+		converter->profiler(m_profiler);
 	if (converter->copy() && converter->hasSerialize())
 		m_copy_converters.push_back(converter);
 	if (converter->paste() && converter->hasDeserialize())
@@ -178,43 +183,32 @@ std::string Converters::serialize(const Color &color, Type type)
 }
 bool Converters::deserialize(const char *value, ColorObject **output_color_object)
 {
+	ConverterSignature::Input input(value);
 	ColorObject color_object;
-	multimap<float, ColorObject*, greater<float>> results;
-	if (m_display_converter){
-		Converter *converter = m_display_converter;
-		if (converter->hasDeserialize()){
-			float quality;
-			if (converter->deserialize(value, &color_object, quality)){
-				if (quality > 0){
-					results.insert(make_pair(quality, color_object.copy()));
-				}
-			}
-		}
-	}
-	for (auto &converter: m_paste_converters){
-		if (!converter->hasDeserialize())
-			continue;
+	ColorObject *best = nullptr;
+	float best_quality = 0;
+	auto tryConverter = [&](Converter *converter){
+		if (!converter->hasDeserialize() || !converter->signature().matches(input))
+			return;
 		float quality;
 		if (converter->deserialize(value, &color_object, quality)){
-			if (quality > 0){
-				results.insert(make_pair(quality, color_object.copy()));
+			// First converter wins when qualities are equal
+			if (quality > best_quality){
+				if (best)
+					best->release();
+				best = color_object.copy();
+				best_quality = quality;
 			}
 		}
-	}
-	bool first = true;
-	for (auto result: results){
-		if (first){
-			first = false;
-			*output_color_object = result.second;
-		}else{
-			result.second->release();
-		}
-	}
-	if (first){
+	};
+	if (m_display_converter)
+		tryConverter(m_display_converter);
+	for (auto &converter: m_paste_converters)
+		tryConverter(converter);
+	if (!best)
 		return false;
-	}else{
-		return true;
-	}
+	*output_color_object = best;
+	return true;
 }
 void Converters::reorder(const char **names, size_t count)
 {
@@ -253,3 +247,17 @@ void Converters::reorder(const std::vector<std::string> &names) {
 	m_all_converters.clear();
 	m_all_converters = converters;
 }
+BuiltinConverterOptions &Converters::builtinOptions()
+{
+	return m_builtin_options;
+}
+void Converters::profiler(lua::Profiler *profiler)
+{
+	m_profiler = profiler;
+	for (auto converter: m_all_converters)
+		converter->profiler(profiler);
+}
+lua::Profiler *Converters::profiler() const
+{
+	return m_profiler;
+}
@@ -21,9 +21,13 @@
 #include <map>
 #include <vector>
 #include <string>
+#include "BuiltinConverters.h"
 struct ColorObject;
 struct Converter;
 struct Color;
+namespace lua {
+	struct Profiler;
+}
 struct Converters {
 	enum class Type {
 		display,
@@ -57,6 +61,10 @@ struct Converters {
 	void reorder(const char **names, size_t count);
 	void reorder(const std::vector<std::string> &names);
 	bool hasCopy() const;
+	BuiltinConverterOptions &builtinOptions();
+	// Profiler is assigned to all current and later added converters
+	void profiler(lua::Profiler *profiler);
+	lua::Profiler *profiler() const;
 private:
 	std::map<std::string, Converter *> m_converters;
 	std::vector<Converter *> m_all_converters;
@@ -64,5 +72,7 @@ private:
 	std::vector<Converter *> m_paste_converters;
 	Converter *m_display_converter;
 	Converter *m_color_list_converter;
+	BuiltinConverterOptions m_builtin_options;
+	lua::Profiler *m_profiler;
 };
 #endif /* GPICK_CONVERTERS_H_ */
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Core.h"
+#include "ConverterSerializePosition.h"
+namespace core {
+bool importPalette(ColorList *colorList, const char *filename, Converters *converters) {
+	FileType type = ImportExport::getFileType(filename);
+	if (type == FileType::txt && !converters)
+		return false;
+	ImportExport importExport(colorList, filename);
+	importExport.setConverters(converters);
+	return importExport.importType(type);
+}
+bool exportPalette(ColorList *colorList, const char *filename, Converter *converter, const dynv::Map *settings) {
+	FileType type = ImportExport::getFileType(filename);
+	if (type == FileType::txt && !converter)
+		return false;
+	ImportExport importExport(colorList, filename, settings);
+	importExport.setConverter(converter);
+	return importExport.exportType(type);
+}
+bool serializeColor(const char *converterName, const ColorObject &colorObject, std::string &result, bool upperCase) {
+	auto converter = getBuiltinConverter(converterName);
+	if (!converter || !converter->serialize)
+		return false;
+	BuiltinConverterOptions options;
+	options.upperCase = upperCase;
+	ConverterSerializePosition position(1);
+	size_t length = result.length();
+	if (converter->serialize(colorObject, position, options, result))
+		return true;
+	result.resize(length);
+	return false;
+}
+void transformColors(ColorList *colorList, transformation::Chain &chain) {
+	for (auto colorObject: colorList->colors) {
+		Color color;
+		chain.apply(&colorObject->getColor(), &color);
+		colorObject->setColor(color);
+	}
+}
+}
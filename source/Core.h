@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_CORE_H_
+#define GPICK_CORE_H_
+// Entry point of the gpick-core library. Everything declared here and in the included headers works without GTK or a display.
+#include "Color.h"
+#include "ColorObject.h"
+#include "ColorList.h"
+#include "ImportExport.h"
+#include "Converter.h"
+#include "Converters.h"
+#include "BuiltinConverters.h"
+#include "color_names/ColorNames.h"
+#include "transformation/Chain.h"
+#include "transformation/Factory.h"
+#include "dynv/Map.h"
+#include <string>
+namespace core {
+// Imports palette file into color list. File format is detected from file name or contents. Converters are used by text file import.
+bool importPalette(ColorList *colorList, const char *filename, Converters *converters = nullptr);
+// Exports color list to a file. File format is selected by file name extension, text output needs a converter.
+bool exportPalette(ColorList *colorList, const char *filename, Converter *converter = nullptr, const dynv::Map *settings = nullptr);
+// Appends color serialized by native version of a converter, e.g. "color_web_hex" or "color_css_rgb".
+// Returns false if converter is unknown or color can not be serialized natively.
+bool serializeColor(const char *converterName, const ColorObject &colorObject, std::string &result, bool upperCase = false);
+// Replaces every color in color list with its transformed value
+void transformColors(ColorList *colorList, transformation::Chain &chain);
+}
+#endif /* GPICK_CORE_H_ */
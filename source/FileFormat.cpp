@@ -21,20 +21,39 @@
 #include "ColorList.h"
 #include "dynv/Map.h"
 #include "common/Scoped.h"
+#include "common/MappedFile.h"
 #include "version/Version.h"
 #include <string.h>
 #include <fstream>
+#include <sstream>
+#include <iostream>
 #include <list>
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
 #include <boost/endian/conversion.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <gio/gio.h>
 
 #define CHUNK_TYPE_VERSION "GPA version"
 #define CHUNK_TYPE_HANDLER_MAP "handler_map"
 #define CHUNK_TYPE_COLOR_LIST "color_list"
 #define CHUNK_TYPE_COLOR_POSITIONS "color_positions"
 #define CHUNK_TYPE_COLOR_ACTIONS "color_actions"
+#define CHUNK_TYPE_COLOR_COLUMNS "color_columns"
+#define CHUNK_TYPE_COMPRESSED "compressed"
+#define CHUNK_TYPE_COLOR_INDEX "color_index"
+#define CHUNK_TYPE_INDEX_OFFSET "index_offset"
+// Version 1.0 files are readable by all releases, because colors are stored in color_list chunks and unknown chunks are skipped.
+// Newer readers prefer color_columns chunks if they exist. Files without color_list chunks are marked as version 1.1, so that older releases refuse them instead of loading an empty palette.
 const uint32_t Version = static_cast<uint32_t>(1 * 0x10000 + 0);
+const uint32_t ColumnsOnlyVersion = static_cast<uint32_t>(1 * 0x10000 + 1);
+// Positions are stored as uint32, so hidden colors with position ~(size_t)0 are stored as 0xffffffff on all platforms
+const uint32_t HiddenPosition = UINT32_MAX;
+static bool isSupportedVersion(uint32_t version) {
+	return (version >> 16) == (Version >> 16);
+}
 struct ChunkHeader {
 	void prepareWrite(const std::string &type, uint64_t size) {
 		size_t length = type.length();
@@ -78,6 +97,11 @@ static bool read(std::istream &stream, uint32_t &value) {
 	value = boost::endian::little_to_native<uint32_t>(value);
 	return stream.good();
 }
+static bool read(std::istream &stream, uint64_t &value) {
+	stream.read(reinterpret_cast<char *>(&value), sizeof(value));
+	value = boost::endian::little_to_native<uint64_t>(value);
+	return stream.good();
+}
 static bool read(std::istream &stream, std::string &value) {
 	uint32_t length;
 	if (!read(stream, length))
@@ -86,94 +110,651 @@ static bool read(std::istream &stream, std::string &value) {
 	stream.read(reinterpret_cast<char *>(&value.front()), length);
 	return stream.good();
 }
-int palette_file_load(const char* filename, ColorList* colorList) {
-	std::ifstream file(filename, std::ios::binary);
-	if (!file.is_open())
-		return -1;
-	ChunkHeader header;
-	if (!read(file, header) || !header.valid() || !header.startsWith(CHUNK_TYPE_VERSION))
-		return -1;
-	if (header.size() < 4)
-		return -1;
-	uint32_t version;
-	if (!read(file, version))
-		return -1;
-	if (version != Version)
-		return -1;
-	file.seekg(header.size() - 4, std::ios::cur);
-	if (!file.good())
-		return -1;
-	if (!read(file, header) || !header.valid()) {
-		return file.eof() ? 0 : -1;
+// Checks that stream has enough data left, so that size from a broken file does not cause a huge allocation
+static bool hasData(std::istream &stream, uint64_t length) {
+	auto position = stream.tellg();
+	stream.seekg(0, std::ios::end);
+	auto end = stream.tellg();
+	stream.seekg(position);
+	return stream.good() && end >= position && static_cast<uint64_t>(end - position) >= length;
+}
+static bool read(std::istream &stream, std::vector<uint8_t> &value, uint64_t length) {
+	if (!hasData(stream, length))
+		return false;
+	value.resize(static_cast<size_t>(length));
+	if (length > 0)
+		stream.read(reinterpret_cast<char *>(&value.front()), length);
+	return stream.good();
+}
+namespace {
+// Reads values directly from mapped file data or chunk buffer, every read is bounds checked
+struct BufferReader {
+	BufferReader(const uint8_t *data, size_t size):
+		m_data(data),
+		m_size(size),
+		m_offset(0) {
 	}
-	std::vector<ColorObject *> colorObjects;
-	auto releaseColorObjects = common::makeScoped(std::function<void()>([&colorObjects]() {
-		for (auto colorObject: colorObjects)
-			if (colorObject)
-				colorObject->release();
-	}));
+	bool read(ChunkHeader &header) {
+		if (!has(sizeof(header)))
+			return false;
+		memcpy(&header, m_data + m_offset, sizeof(header));
+		m_offset += sizeof(header);
+		header.prepareRead();
+		return true;
+	}
+	bool read(uint8_t &value) {
+		if (!has(1))
+			return false;
+		value = m_data[m_offset++];
+		return true;
+	}
+	bool read(uint32_t &value) {
+		if (!has(sizeof(value)))
+			return false;
+		memcpy(&value, m_data + m_offset, sizeof(value));
+		m_offset += sizeof(value);
+		value = boost::endian::little_to_native<uint32_t>(value);
+		return true;
+	}
+	bool read(uint64_t &value) {
+		if (!has(sizeof(value)))
+			return false;
+		memcpy(&value, m_data + m_offset, sizeof(value));
+		m_offset += sizeof(value);
+		value = boost::endian::little_to_native<uint64_t>(value);
+		return true;
+	}
+	bool read(float &value) {
+		uint32_t intValue;
+		if (!read(intValue))
+			return false;
+		static_assert(sizeof(value) == sizeof(intValue), "unexpected float size");
+		memcpy(&value, &intValue, sizeof(value));
+		return true;
+	}
+	// Returns pointer to length prefixed data without copying it
+	bool read(const char *&value, uint32_t &length) {
+		if (!read(length) || !has(length))
+			return false;
+		value = reinterpret_cast<const char *>(m_data + m_offset);
+		m_offset += length;
+		return true;
+	}
+	// Returns pointer to data of a given length without copying it
+	bool view(const char *&value, uint64_t length) {
+		if (!has(length))
+			return false;
+		value = reinterpret_cast<const char *>(m_data + m_offset);
+		m_offset += static_cast<size_t>(length);
+		return true;
+	}
+	bool skip(uint64_t length) {
+		if (!has(length))
+			return false;
+		m_offset += static_cast<size_t>(length);
+		return true;
+	}
+	bool has(uint64_t length) const {
+		return length <= m_size - m_offset;
+	}
+	bool end() const {
+		return m_offset == m_size;
+	}
+	size_t offset() const {
+		return m_offset;
+	}
+	const uint8_t *current() const {
+		return m_data + m_offset;
+	}
+private:
+	const uint8_t *m_data;
+	size_t m_size, m_offset;
+};
+}
+// Only checks color record and skips it if colorObjects is nullptr
+static bool readColorObject(BufferReader &reader, const std::vector<dynv::types::ValueType> &types, std::vector<ColorObject *> *colorObjects) {
+	using ValueType = dynv::types::ValueType;
+	uint32_t count;
+	if (!reader.read(count))
+		return false;
+	const char *name = nullptr;
+	uint32_t nameLength = 0;
+	Color color;
+	for (uint32_t i = 0; i < count; i++) {
+		uint8_t handlerId;
+		const char *valueName;
+		uint32_t valueNameLength;
+		if (!reader.read(handlerId) || !reader.read(valueName, valueNameLength))
+			return false;
+		if (handlerId >= types.size()) {
+			uint32_t skip;
+			if (!reader.read(skip) || !reader.skip(skip))
+				return false;
+			continue;
+		}
+		bool isName = valueNameLength == 4 && memcmp(valueName, "name", 4) == 0;
+		bool isColor = valueNameLength == 5 && memcmp(valueName, "color", 5) == 0;
+		switch (types[handlerId]) {
+		case ValueType::basicBool:
+			if (!reader.skip(1))
+				return false;
+			if (isName || isColor)
+				return false;
+			break;
+		case ValueType::basicFloat:
+		case ValueType::basicInt32:
+			if (!reader.skip(4))
+				return false;
+			if (isName || isColor)
+				return false;
+			break;
+		case ValueType::string: {
+			const char *value;
+			uint32_t length;
+			if (!reader.read(value, length))
+				return false;
+			if (isName) {
+				name = value;
+				nameLength = length;
+			} else if (isColor) {
+				return false;
+			}
+		} break;
+		case ValueType::color: {
+			uint32_t storeLength;
+			if (!reader.read(storeLength))
+				return false;
+			if (isColor && storeLength == sizeof(float) * 4) {
+				for (int j = 0; j < 4; j++) {
+					if (!reader.read(color.ma[j]))
+						return false;
+				}
+			} else {
+				if (isColor || isName)
+					return false;
+				if (!reader.skip(storeLength))
+					return false;
+			}
+		} break;
+		case ValueType::map:
+		case ValueType::unknown:
+			return false;
+		}
+	}
+	if (colorObjects)
+		colorObjects->push_back(new ColorObject(name ? std::string(name, nameLength) : std::string(), color));
+	return true;
+}
+static void releaseColorObjects(std::vector<ColorObject *> &colorObjects) {
+	for (auto colorObject: colorObjects)
+		if (colorObject)
+			colorObject->release();
+	colorObjects.clear();
+}
+namespace {
+// Columns chunk: uint32 color count, count * 4 float32 color values, (count + 1) uint32 name offsets and UTF-8 name data
+struct ColorColumns {
+	ColorColumns():
+		m_count(0),
+		m_colors(nullptr),
+		m_offsets(nullptr),
+		m_names(nullptr) {
+	}
+	bool read(BufferReader &reader, uint64_t size) {
+		if (size < sizeof(uint32_t) || !reader.read(m_count))
+			return false;
+		uint64_t fixedSize = sizeof(uint32_t) + static_cast<uint64_t>(m_count) * (sizeof(float) * 4 + sizeof(uint32_t)) + sizeof(uint32_t);
+		if (fixedSize > size)
+			return false;
+		uint64_t namesLength = size - fixedSize;
+		if (namesLength > UINT32_MAX)
+			return false;
+		if (!reader.view(m_colors, static_cast<uint64_t>(m_count) * sizeof(float) * 4) || !reader.view(m_offsets, (static_cast<uint64_t>(m_count) + 1) * sizeof(uint32_t)) || !reader.view(m_names, namesLength))
+			return false;
+		return offset(0) == 0 && offset(m_count) == namesLength;
+	}
+	uint32_t count() const {
+		return m_count;
+	}
+	// Returns nullptr if name offsets are broken
+	ColorObject *get(uint32_t index) const {
+		uint32_t start = offset(index), end = offset(index + 1);
+		if (end < start || end > offset(m_count))
+			return nullptr;
+		Color color;
+		for (int j = 0; j < 4; j++) {
+			uint32_t value;
+			memcpy(&value, m_colors + (static_cast<size_t>(index) * 4 + j) * sizeof(uint32_t), sizeof(uint32_t));
+			value = boost::endian::little_to_native<uint32_t>(value);
+			memcpy(&color.ma[j], &value, sizeof(float));
+		}
+		return new ColorObject(std::string(m_names + start, end - start), color);
+	}
+	bool get(uint32_t first, uint32_t last, std::vector<ColorObject *> &colorObjects) const {
+		colorObjects.reserve(colorObjects.size() + (last - first));
+		for (uint32_t i = first; i < last; i++) {
+			auto colorObject = get(i);
+			if (!colorObject)
+				return false;
+			colorObjects.push_back(colorObject);
+		}
+		return true;
+	}
+private:
+	uint32_t m_count;
+	const char *m_colors, *m_offsets, *m_names;
+	uint32_t offset(size_t index) const {
+		uint32_t value;
+		memcpy(&value, m_offsets + index * sizeof(uint32_t), sizeof(uint32_t));
+		return boost::endian::little_to_native<uint32_t>(value);
+	}
+};
+}
+static bool readColorColumns(BufferReader &reader, uint64_t size, std::vector<ColorObject *> &colorObjects) {
+	ColorColumns columns;
+	if (!columns.read(reader, size))
+		return false;
+	return columns.get(0, columns.count(), colorObjects);
+}
+namespace {
+// Colors and positions collected from all chunks, color_columns are preferred over color_list if both exist. Files written with color_columns have them before color_list, so color_list can be skipped.
+struct LoadState {
+	std::vector<dynv::types::ValueType> types;
+	std::vector<ColorObject *> colorObjects, columnObjects;
 	std::vector<uint32_t> positions;
-	std::unordered_map<uint8_t, dynv::types::ValueType> typeMap;
-	std::vector<std::string> handlers;
-	bool hasPositions = false;
+	bool hasColumns, hasPositions;
+	LoadState():
+		hasColumns(false),
+		hasPositions(false) {
+	}
+	~LoadState() {
+		releaseColorObjects(colorObjects);
+		releaseColorObjects(columnObjects);
+	}
+	LoadState(const LoadState &) = delete;
+	LoadState &operator=(const LoadState &) = delete;
+	// Moves colors and positions to the end of this state
+	void append(LoadState &state);
+	void finish(ColorList *colorList);
+};
+// Part of mapped file colors, parts are decoded in parallel and appended to the result in file order
+struct LoadPart {
+	LoadState state;
+	std::function<bool(LoadState &state)> decode;
+};
+using LoadParts = std::vector<std::unique_ptr<LoadPart>>;
+// Decompresses zlib stream into a buffer of declared size. Input can be pushed in blocks while it is read from a stream.
+struct Inflater {
+	Inflater():
+		m_converter(G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB))),
+		m_written(0),
+		m_finished(false) {
+	}
+	~Inflater() {
+		g_object_unref(m_converter);
+	}
+	bool start(uint64_t size, uint64_t compressedSize) {
+		// Deflate can not compress better than about 1032:1, so larger declared size means a broken or malicious file
+		if (size == 0 || compressedSize > UINT64_MAX / 1032 || size > compressedSize * 1032 + 1024 || size > SIZE_MAX)
+			return false;
+		m_data.resize(static_cast<size_t>(size));
+		return true;
+	}
+	bool push(const uint8_t *data, size_t length, bool last) {
+		if (m_finished)
+			return false;
+		for (;;) {
+			if (length == 0 && !last)
+				return true;
+			uint8_t overflow;
+			size_t available = m_data.size() - m_written;
+			gsize bytesRead = 0, bytesWritten = 0;
+			GError *error = nullptr;
+			auto result = g_converter_convert(m_converter, data, length, available > 0 ? &m_data[m_written] : &overflow, available > 0 ? available : 1, last ? G_CONVERTER_INPUT_AT_END : G_CONVERTER_NO_FLAGS, &bytesRead, &bytesWritten, &error);
+			if (result == G_CONVERTER_ERROR) {
+				g_error_free(error);
+				return false;
+			}
+			if (available == 0 && bytesWritten > 0)
+				return false; // more data than declared
+			data += bytesRead;
+			length -= bytesRead;
+			m_written += bytesWritten;
+			if (result == G_CONVERTER_FINISHED) {
+				m_finished = true;
+				return length == 0 && m_written == m_data.size();
+			}
+			if (bytesRead == 0 && bytesWritten == 0)
+				return false;
+		}
+	}
+	bool finished() const {
+		return m_finished;
+	}
+	const std::vector<uint8_t> &data() const {
+		return m_data;
+	}
+	void takeData(std::vector<uint8_t> &data) {
+		data.swap(m_data);
+	}
+private:
+	GConverter *m_converter;
+	std::vector<uint8_t> m_data;
+	size_t m_written;
+	bool m_finished;
+};
+}
+const size_t CompressionBlockSize = 64 * 1024;
+// Compressed batches are decompressed as a whole when a range of colors is read, so saved files are split into batches of this size
+const size_t PagingBatchSize = 16 * 1024;
+// Number of colors in a single part when mapped file is decoded in parallel
+const uint32_t LoadPartSize = 16 * 1024;
+static LoadPart &addPart(LoadParts &parts, std::function<bool(LoadState &state)> decode) {
+	parts.push_back(std::make_unique<LoadPart>());
+	parts.back()->decode = std::move(decode);
+	return *parts.back();
+}
+// Compressed chunk: uint64 uncompressed size followed by zlib stream containing other chunks
+static bool readChunks(BufferReader &reader, LoadState &state, LoadParts *parts);
+static bool readCompressed(BufferReader &reader, uint64_t size, LoadState &state) {
+	uint64_t uncompressedSize;
+	const char *data;
+	if (size < sizeof(uncompressedSize) || !reader.read(uncompressedSize) || !reader.view(data, size - sizeof(uncompressedSize)))
+		return false;
+	Inflater inflater;
+	if (!inflater.start(uncompressedSize, size - sizeof(uncompressedSize)))
+		return false;
+	if (!inflater.push(reinterpret_cast<const uint8_t *>(data), static_cast<size_t>(size - sizeof(uncompressedSize)), true))
+		return false;
+	BufferReader innerReader(inflater.data().data(), inflater.data().size());
+	return readChunks(innerReader, state, nullptr);
+}
+static bool readCompressed(std::istream &stream, uint64_t size, LoadState &state) {
+	uint64_t uncompressedSize;
+	if (size < sizeof(uncompressedSize) || !read(stream, uncompressedSize) || !hasData(stream, size - sizeof(uncompressedSize)))
+		return false;
+	uint64_t remaining = size - sizeof(uncompressedSize);
+	Inflater inflater;
+	if (!inflater.start(uncompressedSize, remaining))
+		return false;
+	std::vector<uint8_t> block(static_cast<size_t>(std::min<uint64_t>(remaining, CompressionBlockSize)));
+	while (remaining > 0) {
+		size_t length = static_cast<size_t>(std::min<uint64_t>(remaining, block.size()));
+		stream.read(reinterpret_cast<char *>(block.data()), length);
+		if (!stream.good())
+			return false;
+		remaining -= length;
+		if (!inflater.push(block.data(), length, remaining == 0))
+			return false;
+	}
+	if (!inflater.finished())
+		return false;
+	BufferReader innerReader(inflater.data().data(), inflater.data().size());
+	return readChunks(innerReader, state, nullptr);
+}
+// Decodes chunks without intermediate dynv::Map for each color. Returns false if data has anything unusual, so that stream reader can handle it.
+// If parts are given, colors and compressed chunks are only checked and split into parts, which are decoded later.
+static bool readChunks(BufferReader &reader, LoadState &state, LoadParts *parts) {
+	ChunkHeader header;
+	while (!reader.end()) {
+		if (!reader.read(header) || !header.valid())
+			return false;
+		if (!reader.has(header.size()))
+			return false;
+		size_t end = reader.offset() + static_cast<size_t>(header.size());
+		if (header.is(CHUNK_TYPE_HANDLER_MAP)) {
+			uint32_t handlerCount;
+			if (!reader.read(handlerCount) || handlerCount > 255 || state.types.size() + handlerCount > 256)
+				return false;
+			for (size_t i = 0; i < handlerCount; i++) {
+				const char *typeName;
+				uint32_t length;
+				if (!reader.read(typeName, length))
+					return false;
+				state.types.push_back(dynv::types::stringToType(std::string(typeName, length)));
+			}
+		} else if (header.is(CHUNK_TYPE_COLOR_LIST) && !state.hasColumns) {
+			while (reader.offset() < end) {
+				if (!parts) {
+					if (!readColorObject(reader, state.types, &state.colorObjects))
+						return false;
+					continue;
+				}
+				const uint8_t *data = reader.current();
+				size_t first = reader.offset();
+				for (uint32_t i = 0; i < LoadPartSize && reader.offset() < end; i++) {
+					if (!readColorObject(reader, state.types, nullptr))
+						return false;
+				}
+				size_t length = reader.offset() - first;
+				auto types = state.types;
+				addPart(*parts, [data, length, types](LoadState &state) {
+					BufferReader reader(data, length);
+					while (!reader.end()) {
+						if (!readColorObject(reader, types, &state.colorObjects))
+							return false;
+					}
+					return true;
+				});
+			}
+		} else if (header.is(CHUNK_TYPE_COLOR_COLUMNS)) {
+			state.hasColumns = true;
+			if (!parts) {
+				if (!readColorColumns(reader, header.size(), state.columnObjects))
+					return false;
+			} else {
+				ColorColumns columns;
+				if (!columns.read(reader, header.size()))
+					return false;
+				uint32_t count = columns.count();
+				for (uint32_t first = 0; first < count;) {
+					uint32_t last = first + std::min(LoadPartSize, count - first);
+					addPart(*parts, [columns, first, last](LoadState &state) {
+						return columns.get(first, last, state.columnObjects);
+					});
+					first = last;
+				}
+			}
+		} else if (header.is(CHUNK_TYPE_COLOR_POSITIONS)) {
+			if (header.size() % sizeof(uint32_t) != 0)
+				return false;
+			state.hasPositions = true;
+			// Positions are cheap to read, so they are stored in a part without decoding function to keep file order
+			if (parts && (parts->empty() || parts->back()->decode))
+				addPart(*parts, nullptr);
+			auto &positions = parts ? parts->back()->state.positions : state.positions;
+			size_t first = positions.size();
+			positions.resize(first + static_cast<size_t>(header.size() / sizeof(uint32_t)));
+			for (size_t i = first; i < positions.size(); i++) {
+				if (!reader.read(positions[i]))
+					return false;
+			}
+		} else if (parts && header.is(CHUNK_TYPE_COMPRESSED)) {
+			const char *data;
+			uint64_t size = header.size();
+			if (!reader.view(data, size))
+				return false;
+			auto types = state.types;
+			addPart(*parts, [data, size, types](LoadState &state) {
+				state.types = types;
+				BufferReader reader(reinterpret_cast<const uint8_t *>(data), static_cast<size_t>(size));
+				return readCompressed(reader, size, state);
+			});
+		} else {
+			reader.skip(header.size());
+		}
+		if (reader.offset() != end)
+			return false;
+	}
+	return true;
+}
+static bool readChunks(std::istream &stream, LoadState &state) {
+	ChunkHeader header;
 	for (;;) {
+		if (!read(stream, header) || !header.valid())
+			return stream.eof();
 		if (header.is(CHUNK_TYPE_HANDLER_MAP)) {
 			uint32_t handlerCount;
-			if (!read(file, handlerCount))
-				return -1;
+			if (!read(stream, handlerCount))
+				return false;
 			if (handlerCount > 255)
-				return -1;
+				return false;
 			for (size_t i = 0; i < handlerCount; i++) {
 				std::string typeName;
-				if (!read(file, typeName))
-					return -1;
-				typeMap[static_cast<uint8_t>(handlers.size())] = dynv::types::stringToType(typeName);
-				handlers.push_back(typeName);
+				if (!read(stream, typeName))
+					return false;
+				state.types.push_back(dynv::types::stringToType(typeName));
 			}
-		} else if (header.is(CHUNK_TYPE_COLOR_LIST)) {
-			std::streamoff end = file.tellg() + static_cast<std::streamoff>(header.size());
-			while (file.tellg() < end) {
+		} else if (header.is(CHUNK_TYPE_COLOR_LIST) && !state.hasColumns) {
+			std::unordered_map<uint8_t, dynv::types::ValueType> typeMap;
+			for (size_t i = 0; i < state.types.size(); i++)
+				typeMap[static_cast<uint8_t>(i)] = state.types[i];
+			std::streamoff end = stream.tellg() + static_cast<std::streamoff>(header.size());
+			while (stream.tellg() < end) {
 				dynv::Map options;
-				if (!options.deserialize(file, typeMap))
-					return -1;
+				if (!options.deserialize(stream, typeMap))
+					return false;
 				auto color = options.getColor("color", Color());
 				auto name = options.getString("name", "");
-				colorObjects.push_back(new ColorObject(name, color));
+				state.colorObjects.push_back(new ColorObject(name, color));
 			}
+		} else if (header.is(CHUNK_TYPE_COLOR_COLUMNS)) {
+			std::vector<uint8_t> data;
+			if (!read(stream, data, header.size()))
+				return false;
+			BufferReader reader(data.data(), data.size());
+			state.hasColumns = true;
+			if (!readColorColumns(reader, data.size(), state.columnObjects))
+				return false;
 		} else if (header.is(CHUNK_TYPE_COLOR_POSITIONS)) {
-			hasPositions = true;
-			positions.resize(header.size() / sizeof(uint32_t));
-			file.read(reinterpret_cast<char *>(&positions.front()), positions.size() * sizeof(uint32_t));
-			if (!file.good())
-				return -1;
-			for (auto &position: positions) {
-				position = boost::endian::little_to_native<uint32_t>(position);
+			// Streamed files contain positions chunk after each batch of colors
+			if (header.size() % sizeof(uint32_t) != 0 || !hasData(stream, header.size()))
+				return false;
+			state.hasPositions = true;
+			auto &positions = state.positions;
+			size_t first = positions.size();
+			positions.resize(first + static_cast<size_t>(header.size() / sizeof(uint32_t)));
+			stream.read(reinterpret_cast<char *>(positions.data() + first), (positions.size() - first) * sizeof(uint32_t));
+			if (!stream.good())
+				return false;
+			for (size_t i = first; i < positions.size(); i++) {
+				positions[i] = boost::endian::little_to_native<uint32_t>(positions[i]);
 			}
+		} else if (header.is(CHUNK_TYPE_COMPRESSED)) {
+			if (!readCompressed(stream, header.size(), state))
+				return false;
 		} else {
-			file.seekg(header.size(), std::ios::cur);
-			if (file.eof())
-				break;
-			if (!file.good())
-				return -1;
-		}
-		if (!read(file, header) || !header.valid()) {
-			if (file.eof())
-				break;
-			else
-				return -1;
+			stream.seekg(header.size(), std::ios::cur);
+			if (stream.eof())
+				return true;
+			if (!stream.good())
+				return false;
 		}
 	}
+}
+static void addColorObjects(ColorList *colorList, std::vector<ColorObject *> &colorObjects, const std::vector<uint32_t> &positions, bool hasPositions) {
 	if (hasPositions) {
 		for (size_t i = 0, end = std::min(colorObjects.size(), positions.size()); i < end; i++) {
 			colorObjects[i]->setPosition(positions[i]);
 		}
-		std::sort(colorObjects.begin(), colorObjects.end(), colorObjectPositionSort);
+		// Saved files are already in palette order. Hidden colors share the same position, so stable sort keeps them in file order.
+		if (!std::is_sorted(colorObjects.begin(), colorObjects.end(), colorObjectPositionSort))
+			std::stable_sort(colorObjects.begin(), colorObjects.end(), colorObjectPositionSort);
 	}
 	for (auto colorObject: colorObjects) {
-		bool visible = hasPositions ? colorObject->getPosition() != ~(size_t)0 : true;
+		bool visible = hasPositions ? colorObject->getPosition() != HiddenPosition : true;
 		colorObject->setVisible(visible);
 		color_list_add_color_object(colorList, colorObject, visible);
 	}
+}
+void LoadState::append(LoadState &state) {
+	colorObjects.insert(colorObjects.end(), state.colorObjects.begin(), state.colorObjects.end());
+	state.colorObjects.clear();
+	columnObjects.insert(columnObjects.end(), state.columnObjects.begin(), state.columnObjects.end());
+	state.columnObjects.clear();
+	positions.insert(positions.end(), state.positions.begin(), state.positions.end());
+	hasColumns = hasColumns || state.hasColumns;
+	hasPositions = hasPositions || state.hasPositions;
+}
+// Decodes parts on up to threadCount threads, 0 uses all available cores. Part order is kept when results are appended to the state.
+static bool decodeParts(LoadParts &parts, LoadState &state, size_t threadCount) {
+	std::atomic<size_t> next(0);
+	std::atomic<bool> failed(false);
+	auto work = [&]() {
+		for (size_t i = next++; i < parts.size() && !failed; i = next++) {
+			auto &part = *parts[i];
+			if (part.decode && !part.decode(part.state))
+				failed = true;
+		}
+	};
+	if (threadCount == 0)
+		threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	size_t threads = std::min<size_t>(threadCount, parts.size());
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < threads; i++)
+		workers.emplace_back(work);
+	work();
+	for (auto &worker: workers)
+		worker.join();
+	if (failed)
+		return false;
+	for (auto &part: parts)
+		state.append(part->state);
+	return true;
+}
+void LoadState::finish(ColorList *colorList) {
+	addColorObjects(colorList, hasColumns ? columnObjects : colorObjects, positions, hasPositions);
+}
+// Reads memory mapped file. Returns false if file has anything unusual, so that stream reader can handle it.
+static bool loadMapped(const common::MappedFile &file, LoadState &state, size_t threadCount, int &result) {
+	BufferReader reader(file.data(), file.size());
+	ChunkHeader header;
+	if (!reader.read(header) || !header.valid() || !header.startsWith(CHUNK_TYPE_VERSION))
+		return false;
+	uint32_t version;
+	if (header.size() < 4 || !reader.read(version) || !isSupportedVersion(version))
+		return false;
+	if (!reader.skip(header.size() - 4))
+		return false;
+	// Stream reader always finishes at the end of file and returns 0
+	result = 0;
+	LoadParts parts;
+	if (!readChunks(reader, state, &parts))
+		return false;
+	return decodeParts(parts, state, threadCount);
+}
+int palette_file_load(const char* filename, ColorList* colorList, size_t threadCount) {
+	{
+		common::MappedFile mappedFile(filename);
+		if (mappedFile.valid()) {
+			LoadState state;
+			int result;
+			if (loadMapped(mappedFile, state, threadCount, result)) {
+				state.finish(colorList);
+				return result;
+			}
+		}
+	}
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+		return -1;
+	ChunkHeader header;
+	if (!read(file, header) || !header.valid() || !header.startsWith(CHUNK_TYPE_VERSION))
+		return -1;
+	if (header.size() < 4)
+		return -1;
+	uint32_t version;
+	if (!read(file, version))
+		return -1;
+	if (!isSupportedVersion(version))
+		return -1;
+	file.seekg(header.size() - 4, std::ios::cur);
+	if (!file.good())
+		return -1;
+	LoadState state;
+	if (!readChunks(file, state))
+		return -1;
+	state.finish(colorList);
 	file.close();
 	return file.good();
 }
@@ -188,70 +769,408 @@ static bool write(std::ostream &stream, const ChunkHeader &header) {
 	stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
 	return stream.good();
 }
-static bool write(std::ostream &stream, const std::string &value) {
-	if (!write(stream, static_cast<uint32_t>(value.length())))
-		return false;
-	stream.write(reinterpret_cast<const char *>(&value.front()), value.length());
+static bool write(std::ostream &stream, uint64_t value) {
+	auto data = boost::endian::native_to_little<uint64_t>(value);
+	stream.write(reinterpret_cast<const char *>(&data), sizeof(uint64_t));
 	return stream.good();
 }
-int palette_file_save(const char* filename, ColorList* colorList) {
+// Compresses data into a zlib stream
+static bool compress(const std::string &input, int level, std::string &output) {
+	auto converter = G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, level));
+	const char *data = input.data();
+	size_t length = input.length();
+	bool good = false;
+	output.clear();
+	for (;;) {
+		size_t offset = output.length();
+		output.resize(offset + CompressionBlockSize);
+		gsize bytesRead = 0, bytesWritten = 0;
+		GError *error = nullptr;
+		auto result = g_converter_convert(converter, data, length, &output[offset], CompressionBlockSize, G_CONVERTER_INPUT_AT_END, &bytesRead, &bytesWritten, &error);
+		output.resize(offset + bytesWritten);
+		if (result == G_CONVERTER_ERROR) {
+			std::cerr << "failed to compress palette data: " << error->message << std::endl;
+			g_error_free(error);
+			break;
+		}
+		data += bytesRead;
+		length -= bytesRead;
+		if (result == G_CONVERTER_FINISHED) {
+			good = true;
+			break;
+		}
+		if (bytesRead == 0 && bytesWritten == 0)
+			break;
+	}
+	g_object_unref(converter);
+	return good;
+}
+static void append(std::string &output, uint32_t value) {
+	value = boost::endian::native_to_little<uint32_t>(value);
+	output.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+static void append(std::string &output, const char *value, size_t length) {
+	append(output, static_cast<uint32_t>(length));
+	output.append(value, length);
+}
+// Handler ids used in color_list records, handler_map chunk lists handler names in the same order
+const uint8_t ColorHandlerId = 0;
+const uint8_t StringHandlerId = 1;
+struct PaletteFileWriter::Impl {
+	std::ostream &m_stream;
+	size_t m_batchSize;
+	int m_compressionLevel;
+	// Compressed batches never contain color_list chunks
+	bool m_writeList, m_headerWritten, m_good;
+	std::vector<uint32_t> m_colors, m_offsets, m_positions;
+	std::string m_names, m_list, m_compressed;
+	uint64_t m_written, m_colorCount, m_positionsOffset;
+	size_t m_batchColorCount;
+	// First color index and chunk offset of each batch
+	std::vector<std::pair<uint64_t, uint64_t>> m_index;
+	Impl(std::ostream &stream, size_t batchSize, int compressionLevel, bool compatible):
+		m_stream(stream),
+		m_batchSize(batchSize > 0 ? batchSize : 1),
+		m_compressionLevel(std::max(std::min(compressionLevel, 9), -1)),
+		m_writeList(compatible && m_compressionLevel == 0),
+		m_headerWritten(false),
+		m_good(true),
+		m_written(0),
+		m_colorCount(0),
+		m_positionsOffset(0),
+		m_batchColorCount(0) {
+		m_colors.reserve(m_batchSize * 4);
+		m_offsets.reserve(m_batchSize + 1);
+		m_offsets.push_back(0);
+	}
+	bool writeHeader() {
+		if (m_headerWritten)
+			return true;
+		m_headerWritten = true;
+		ChunkHeader header;
+		header.prepareWrite(std::string(CHUNK_TYPE_VERSION) + " " + gpick_build_version, 4);
+		if (!write(m_stream, header))
+			return false;
+		if (!write(m_stream, m_writeList ? Version : ColumnsOnlyVersion)) // file format version
+			return false;
+		m_written += sizeof(header) + sizeof(uint32_t);
+		std::string handlers;
+		append(handlers, 2); // handler count for colors
+		for (auto &name: { dynv::types::typeHandler<Color>().name, dynv::types::typeHandler<std::string>().name })
+			append(handlers, name.data(), name.length());
+		header.prepareWrite(CHUNK_TYPE_HANDLER_MAP, handlers.length());
+		if (!write(m_stream, header))
+			return false;
+		m_stream.write(handlers.data(), handlers.length());
+		m_written += sizeof(header) + handlers.length();
+		return m_stream.good();
+	}
+	bool add(const ColorObject &colorObject, size_t position) {
+		if (!m_good)
+			return false;
+		auto &name = colorObject.getName();
+		if (m_names.length() + name.length() > UINT32_MAX || m_list.length() + name.length() > UINT32_MAX / 2) {
+			if (!writeBatch())
+				return false;
+		}
+		const Color &color = colorObject.getColor();
+		for (int j = 0; j < 4; j++) {
+			uint32_t value;
+			memcpy(&value, &color.ma[j], sizeof(float));
+			m_colors.push_back(boost::endian::native_to_little<uint32_t>(value));
+		}
+		if (m_writeList) {
+			// Record has the same layout as dynv::Map::serialize output for a map with color and name values
+			append(m_list, 2);
+			m_list.push_back(static_cast<char>(ColorHandlerId));
+			append(m_list, "color", 5);
+			append(m_list, sizeof(float) * 4);
+			for (int j = 0; j < 4; j++) {
+				uint32_t value;
+				memcpy(&value, &color.ma[j], sizeof(float));
+				append(m_list, value);
+			}
+			m_list.push_back(static_cast<char>(StringHandlerId));
+			append(m_list, "name", 4);
+			append(m_list, name.data(), name.length());
+		}
+		m_names += name;
+		m_offsets.push_back(boost::endian::native_to_little<uint32_t>(static_cast<uint32_t>(m_names.length())));
+		m_positions.push_back(boost::endian::native_to_little<uint32_t>(static_cast<uint32_t>(position)));
+		if (++m_batchColorCount >= m_batchSize)
+			return writeBatch();
+		return true;
+	}
+	uint64_t chunksSize(bool withList) const {
+		return sizeof(ChunkHeader) + sizeof(uint32_t) + (m_colors.size() + m_offsets.size()) * sizeof(uint32_t) + m_names.length() + (withList ? sizeof(ChunkHeader) + m_list.length() : 0);
+	}
+	// Columns chunk is written first, so that readers preferring it can skip color_list
+	bool writeChunks(std::ostream &stream, bool withList) {
+		uint32_t count = boost::endian::native_to_little<uint32_t>(static_cast<uint32_t>(m_batchColorCount));
+		ChunkHeader header;
+		header.prepareWrite(CHUNK_TYPE_COLOR_COLUMNS, sizeof(count) + (m_colors.size() + m_offsets.size()) * sizeof(uint32_t) + m_names.length());
+		if (!write(stream, header)) // write color columns chunk header
+			return false;
+		stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+		stream.write(reinterpret_cast<const char *>(m_colors.data()), m_colors.size() * sizeof(uint32_t));
+		stream.write(reinterpret_cast<const char *>(m_offsets.data()), m_offsets.size() * sizeof(uint32_t));
+		stream.write(m_names.data(), m_names.length());
+		if (withList) {
+			header.prepareWrite(CHUNK_TYPE_COLOR_LIST, m_list.length());
+			if (!write(stream, header)) // write color list chunk header
+				return false;
+			stream.write(m_list.data(), m_list.length());
+		}
+		return stream.good();
+	}
+	// Compressed files can not be read by older releases anyway, so color_list is not written into them
+	bool writeCompressedChunks() {
+		std::ostringstream buffer;
+		if (!writeChunks(buffer, false))
+			return false;
+		auto data = buffer.str();
+		if (!compress(data, m_compressionLevel, m_compressed))
+			return false;
+		ChunkHeader header;
+		header.prepareWrite(CHUNK_TYPE_COMPRESSED, sizeof(uint64_t) + m_compressed.length());
+		if (!write(m_stream, header) || !write(m_stream, static_cast<uint64_t>(data.length())))
+			return false;
+		m_stream.write(m_compressed.data(), m_compressed.length());
+		m_written += sizeof(header) + sizeof(uint64_t) + m_compressed.length();
+		return m_stream.good();
+	}
+	bool writeBatch() {
+		if (!m_good || !writeHeader())
+			return m_good = false;
+		if (m_batchColorCount == 0)
+			return true;
+		m_index.emplace_back(m_colorCount, m_written);
+		if (m_compressionLevel != 0) {
+			if (!writeCompressedChunks())
+				return m_good = false;
+		} else {
+			if (!writeChunks(m_stream, m_writeList))
+				return m_good = false;
+			m_written += chunksSize(m_writeList);
+		}
+		m_colorCount += m_batchColorCount;
+		m_batchColorCount = 0;
+		m_colors.clear();
+		m_offsets.clear();
+		m_offsets.push_back(0);
+		m_names.clear();
+		m_list.clear();
+		return true;
+	}
+	// Releases reading version 1.0 files keep only the last color_positions chunk, so positions of all colors are written in a single chunk
+	bool writePositions() {
+		m_positionsOffset = m_written;
+		ChunkHeader header;
+		header.prepareWrite(CHUNK_TYPE_COLOR_POSITIONS, m_positions.size() * sizeof(uint32_t));
+		if (!write(m_stream, header)) // write positions chunk header
+			return false;
+		m_stream.write(reinterpret_cast<const char *>(m_positions.data()), m_positions.size() * sizeof(uint32_t));
+		m_written += sizeof(header) + m_positions.size() * sizeof(uint32_t);
+		return m_stream.good();
+	}
+	// Index chunk is followed by fixed size index_offset chunk at the end of file, so readers can find it without scanning
+	bool writeIndex() {
+		ChunkHeader header;
+		header.prepareWrite(CHUNK_TYPE_COLOR_INDEX, sizeof(uint64_t) * 2 + sizeof(uint32_t) + m_index.size() * sizeof(uint64_t) * 2);
+		if (!write(m_stream, header) || !write(m_stream, m_colorCount) || !write(m_stream, m_positionsOffset) || !write(m_stream, static_cast<uint32_t>(m_index.size())))
+			return false;
+		for (auto &entry: m_index) {
+			if (!write(m_stream, entry.first) || !write(m_stream, entry.second))
+				return false;
+		}
+		header.prepareWrite(CHUNK_TYPE_INDEX_OFFSET, sizeof(uint64_t));
+		return write(m_stream, header) && write(m_stream, m_written);
+	}
+	bool finish() {
+		if (!writeBatch() || !writePositions() || !writeIndex())
+			return m_good = false;
+		m_stream.flush();
+		return m_good = m_stream.good();
+	}
+};
+PaletteFileWriter::PaletteFileWriter(std::ostream &stream, size_t batchSize, int compressionLevel, bool compatible) {
+	m_impl = std::make_unique<Impl>(stream, batchSize, compressionLevel, compatible);
+}
+PaletteFileWriter::~PaletteFileWriter() {
+}
+bool PaletteFileWriter::add(const ColorObject &colorObject) {
+	return m_impl->add(colorObject, colorObject.getPosition());
+}
+bool PaletteFileWriter::add(const ColorObject &colorObject, size_t position) {
+	return m_impl->add(colorObject, position);
+}
+bool PaletteFileWriter::finish() {
+	return m_impl->finish();
+}
+int palette_file_save(const char* filename, ColorList* colorList, int compressionLevel, bool compatible) {
 	if (!filename || !colorList)
 		return -1;
 	std::ofstream file(filename, std::ios::binary);
 	if (!file.is_open())
 		return -1;
-	ChunkHeader header;
-	header.prepareWrite(std::string(CHUNK_TYPE_VERSION) + " " + gpick_build_version, 4);
-	if (!write(file, header))
-		return -1;
-	if (!write(file, Version)) // file format version
-		return -1;
-	auto handlerMapPosition = file.tellp();
-	if (!write(file, header)) // write temporary chunk header
-		return -1;
-	if (!write(file, static_cast<uint32_t>(2))) // handler count for colors
-		return -1;
-	std::unordered_map<dynv::types::ValueType, uint8_t> typeMap;
-	typeMap[dynv::types::typeHandler<Color>().type] = 0;
-	if (!write(file, dynv::types::typeHandler<Color>().name))
-		return -1;
-	typeMap[dynv::types::typeHandler<std::string>().type] = 1;
-	if (!write(file, dynv::types::typeHandler<std::string>().name))
-		return -1;
-	auto endPosition = file.tellp();
-	file.seekp(handlerMapPosition);
-	header.prepareWrite(CHUNK_TYPE_HANDLER_MAP, endPosition - handlerMapPosition - sizeof(ChunkHeader));
-	if (!write(file, header)) // write type handler chunk header
-		return -1;
-	file.seekp(endPosition);
-	auto colorListPosition = file.tellp();
-	if (!write(file, header)) // write temporary chunk header
-		return -1;
-	dynv::Map options;
-	for (auto colorObject: colorList->colors) {
-		options.set("name", colorObject->getName());
-		options.set("color", colorObject->getColor());
-		if (!options.serialize(file, typeMap))
+	// Colors are written in palette order, so that PaletteFileReader ranges match palette rows
+	std::vector<ColorObject *> colorObjects;
+	color_list_get_palette_order(colorList, colorObjects);
+	PaletteFileWriter writer(file, PagingBatchSize, compressionLevel, compatible);
+	size_t position = 0;
+	for (auto colorObject: colorObjects) {
+		if (!writer.add(*colorObject, colorObject->isPositionSet() ? position++ : ~(size_t)0))
 			return -1;
 	}
-	endPosition = file.tellp();
-	file.seekp(colorListPosition);
-	header.prepareWrite(CHUNK_TYPE_COLOR_LIST, endPosition - colorListPosition - sizeof(ChunkHeader));
-	if (!write(file, header)) // write color list chunk header
-		return -1;
-	file.seekp(endPosition);
-	color_list_get_positions(colorList);
-	std::vector<uint32_t> positions(colorList->colors.size());
-	size_t i = 0;
-	for (auto color: colorList->colors) {
-		positions[i++] = boost::endian::native_to_little<uint32_t>(color->getPosition());
-	}
-	header.prepareWrite(CHUNK_TYPE_COLOR_POSITIONS, positions.size() * sizeof(uint32_t));
-	if (!write(file, header)) // write positions chunk header
-		return -1;
-	file.write(reinterpret_cast<const char *>(&positions.front()), positions.size() * sizeof(uint32_t));
-	if (!file.good())
+	if (!writer.finish())
 		return -1;
 	file.close();
 	return file.good();
 }
+struct PaletteFileReader::Impl {
+	common::MappedFile m_file;
+	bool m_valid;
+	uint64_t m_count;
+	// First color index and chunk offset of each batch
+	std::vector<std::pair<uint64_t, uint64_t>> m_index;
+	// Positions of all colors, stored in a single color_positions chunk
+	const char *m_positions;
+	// Last decompressed batch is kept, because neighbouring ranges are usually requested while scrolling
+	size_t m_cachedBatch;
+	std::vector<uint8_t> m_cache;
+	Impl(const char *filename):
+		m_file(filename),
+		m_count(0),
+		m_positions(nullptr),
+		m_cachedBatch(SIZE_MAX) {
+		m_valid = open();
+	}
+	bool open() {
+		if (!m_file.valid())
+			return false;
+		BufferReader reader(m_file.data(), m_file.size());
+		ChunkHeader header;
+		uint32_t version;
+		if (!reader.read(header) || !header.valid() || !header.startsWith(CHUNK_TYPE_VERSION) || header.size() < 4 || !reader.read(version) || !isSupportedVersion(version))
+			return false;
+		const size_t trailerSize = sizeof(ChunkHeader) + sizeof(uint64_t);
+		if (m_file.size() < trailerSize)
+			return false;
+		size_t indexEnd = m_file.size() - trailerSize;
+		BufferReader trailer(m_file.data() + indexEnd, trailerSize);
+		uint64_t indexOffset;
+		if (!trailer.read(header) || !header.valid() || !header.is(CHUNK_TYPE_INDEX_OFFSET) || header.size() != sizeof(uint64_t) || !trailer.read(indexOffset) || indexOffset > indexEnd)
+			return false;
+		BufferReader index(m_file.data() + indexOffset, indexEnd - static_cast<size_t>(indexOffset));
+		uint64_t positionsOffset;
+		uint32_t entryCount;
+		if (!index.read(header) || !header.valid() || !header.is(CHUNK_TYPE_COLOR_INDEX) || !index.read(m_count) || !index.read(positionsOffset) || !index.read(entryCount))
+			return false;
+		if (header.size() != sizeof(uint64_t) * 2 + sizeof(uint32_t) + static_cast<uint64_t>(entryCount) * sizeof(uint64_t) * 2 || !index.has(static_cast<uint64_t>(entryCount) * sizeof(uint64_t) * 2))
+			return false;
+		if (positionsOffset >= indexOffset)
+			return false;
+		BufferReader positions(m_file.data() + positionsOffset, static_cast<size_t>(indexOffset - positionsOffset));
+		if (!positions.read(header) || !header.valid() || !header.is(CHUNK_TYPE_COLOR_POSITIONS) || m_count > UINT64_MAX / sizeof(uint32_t) || header.size() != m_count * sizeof(uint32_t) || !positions.view(m_positions, header.size()))
+			return false;
+		m_index.resize(entryCount);
+		for (size_t i = 0; i < m_index.size(); i++) {
+			auto &entry = m_index[i];
+			if (!index.read(entry.first) || !index.read(entry.second) || entry.second >= positionsOffset)
+				return false;
+			if (i == 0 ? entry.first != 0 : entry.first <= m_index[i - 1].first)
+				return false;
+			if (entry.first >= m_count)
+				return false;
+		}
+		return !m_index.empty() || m_count == 0;
+	}
+	static bool readBatch(BufferReader &reader, ColorColumns &columns) {
+		ChunkHeader header;
+		return reader.read(header) && header.valid() && header.is(CHUNK_TYPE_COLOR_COLUMNS) && reader.has(header.size()) && columns.read(reader, header.size());
+	}
+	bool loadBatch(size_t batch, ColorColumns &columns) {
+		size_t offset = static_cast<size_t>(m_index[batch].second);
+		BufferReader reader(m_file.data() + offset, m_file.size() - offset);
+		ChunkHeader header;
+		if (!reader.read(header) || !header.valid() || !reader.has(header.size()))
+			return false;
+		if (!header.is(CHUNK_TYPE_COMPRESSED)) {
+			BufferReader batchReader(m_file.data() + offset, m_file.size() - offset);
+			return readBatch(batchReader, columns);
+		}
+		if (m_cachedBatch != batch) {
+			m_cachedBatch = SIZE_MAX;
+			uint64_t uncompressedSize;
+			const char *data;
+			if (header.size() < sizeof(uncompressedSize) || !reader.read(uncompressedSize) || !reader.view(data, header.size() - sizeof(uncompressedSize)))
+				return false;
+			Inflater inflater;
+			if (!inflater.start(uncompressedSize, header.size() - sizeof(uncompressedSize)))
+				return false;
+			if (!inflater.push(reinterpret_cast<const uint8_t *>(data), static_cast<size_t>(header.size() - sizeof(uncompressedSize)), true))
+				return false;
+			inflater.takeData(m_cache);
+			m_cachedBatch = batch;
+		}
+		BufferReader batchReader(m_cache.data(), m_cache.size());
+		return readBatch(batchReader, columns);
+	}
+	bool read(size_t first, size_t count, std::vector<ColorObject *> &colorObjects) {
+		if (!m_valid || first > m_count || count > m_count - first)
+			return false;
+		if (count == 0)
+			return true;
+		size_t end = first + count, previousSize = colorObjects.size();
+		auto entry = std::upper_bound(m_index.begin(), m_index.end(), first, [](size_t value, const std::pair<uint64_t, uint64_t> &entry) {
+			return value < entry.first;
+		});
+		size_t batch = static_cast<size_t>(entry - m_index.begin()) - 1;
+		while (first < end) {
+			ColorColumns columns;
+			if (batch >= m_index.size() || !loadBatch(batch, columns))
+				break;
+			uint64_t batchFirst = m_index[batch].first;
+			uint64_t batchEnd = batchFirst + columns.count();
+			if (batchEnd != (batch + 1 < m_index.size() ? m_index[batch + 1].first : m_count))
+				break;
+			for (; first < end && first < batchEnd; first++) {
+				uint32_t index = static_cast<uint32_t>(first - batchFirst);
+				auto colorObject = columns.get(index);
+				if (!colorObject)
+					break;
+				uint32_t position;
+				memcpy(&position, m_positions + first * sizeof(uint32_t), sizeof(uint32_t));
+				position = boost::endian::little_to_native<uint32_t>(position);
+				bool visible = position != HiddenPosition;
+				colorObject->setPosition(visible ? position : ~(size_t)0);
+				colorObject->setVisible(visible);
+				colorObjects.push_back(colorObject);
+			}
+			if (first < end && first < batchEnd)
+				break;
+			batch++;
+		}
+		if (first < end) {
+			for (size_t i = previousSize; i < colorObjects.size(); i++)
+				colorObjects[i]->release();
+			colorObjects.resize(previousSize);
+			return false;
+		}
+		return true;
+	}
+};
+PaletteFileReader::PaletteFileReader(const char *filename) {
+	m_impl = std::make_unique<Impl>(filename);
+}
+PaletteFileReader::~PaletteFileReader() {
+}
+bool PaletteFileReader::valid() const {
+	return m_impl->m_valid;
+}
+size_t PaletteFileReader::size() const {
+	return static_cast<size_t>(m_impl->m_count);
+}
+bool PaletteFileReader::read(size_t first, size_t count, std::vector<ColorObject *> &colorObjects) {
+	return m_impl->read(first, count, colorObjects);
+}
@@ -19,8 +19,55 @@
 #ifndef GPICK_FILE_FORMAT_H_
 #define GPICK_FILE_FORMAT_H_
 
+#include <iosfwd>
+#include <memory>
+#include <vector>
+#include <cstddef>
 struct ColorList;
-int palette_file_save(const char* filename, ColorList* color_list);
-int palette_file_load(const char* filename, ColorList* color_list);
+struct ColorObject;
+// Compression level is passed to zlib, 0 writes uncompressed chunks. See PaletteFileWriter for compatible.
+int palette_file_save(const char* filename, ColorList* color_list, int compression_level = 0, bool compatible = true);
+// Mapped files are decoded on up to thread_count threads, 0 uses all available cores
+int palette_file_load(const char* filename, ColorList* color_list, size_t thread_count = 0);
+// Writes GPA data in a single pass without seeking, so pipes and sockets can be used as output.
+// Colors are buffered and each batch is written as a color_columns chunk, positions of all colors are written in a single chunk by finish().
+// If compatible is set, each batch is also written as a color_list chunk, so that releases reading only version 1.0 files can load it. This roughly doubles file size and save time.
+// If compression level is not 0, each batch is wrapped into a zlib compressed chunk without color_list, which older releases can not read.
+struct PaletteFileWriter {
+	PaletteFileWriter(std::ostream &stream, size_t batchSize = 4096, int compressionLevel = 0, bool compatible = true);
+	~PaletteFileWriter();
+	// Color position is taken from ColorObject::getPosition()
+	bool add(const ColorObject &colorObject);
+	// Position ~0 marks color as hidden
+	bool add(const ColorObject &colorObject, size_t position);
+	// Adds colors from a range of ColorObject pointers
+	template<typename Iterator>
+	bool add(Iterator begin, Iterator end) {
+		for (; begin != end; ++begin) {
+			if (!add(**begin))
+				return false;
+		}
+		return true;
+	}
+	// Writes remaining buffered colors, color index and flushes stream
+	bool finish();
+private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+};
+// Random access to colors of a GPA file using color_index chunk. Only the index is read when file is opened, batches of colors are decoded when a range is requested.
+struct PaletteFileReader {
+	PaletteFileReader(const char *filename);
+	~PaletteFileReader();
+	// Returns false if file could not be mapped or has no color index
+	bool valid() const;
+	// Number of colors in file
+	size_t size() const;
+	// Appends new color objects in file order with positions and visibility set. Returned objects must be released.
+	bool read(size_t first, size_t count, std::vector<ColorObject *> &colorObjects);
+private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+};
 
 #endif /* GPICK_FILE_FORMAT_H_ */
@@ -33,7 +33,11 @@
 #include "lua/Script.h"
 #include "lua/Extensions.h"
 #include "lua/Callbacks.h"
+#include "lua/ScriptPool.h"
+#include "lua/Profiler.h"
+#include "common/Hash.h"
 #include <boost/filesystem.hpp>
+#include <boost/endian/conversion.hpp>
 #include <stdlib.h>
 #include <glib/gstdio.h>
 extern "C"{
@@ -41,9 +45,54 @@ extern "C"{
 #include <lauxlib.h>
 }
 #include <fstream>
+#include <sstream>
 #include <iostream>
+#include <iterator>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <atomic>
 using namespace std;
 
+// Settings cache header: 16 byte magic, uint32 version, uint64 XML file size and uint64 XML file hash, followed by dynv tree
+static const char SettingsCacheMagic[16] = "GPICK-SETTINGS";
+static const uint32_t SettingsCacheVersion = 1;
+// Settings cache is a binary copy of settings, used instead of parsing settings.xml when the XML file is not changed
+static void writeSettingsCache(const dynv::Map &settings, const std::string &cacheFile, const std::string &xmlData)
+{
+	std::ofstream file(cacheFile.c_str(), std::ios::binary);
+	if (!file.is_open())
+		return;
+	uint32_t version = boost::endian::native_to_little<uint32_t>(SettingsCacheVersion);
+	uint64_t size = boost::endian::native_to_little<uint64_t>(xmlData.length());
+	uint64_t hash = boost::endian::native_to_little<uint64_t>(common::hash(xmlData.c_str(), xmlData.length()));
+	file.write(SettingsCacheMagic, sizeof(SettingsCacheMagic));
+	file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+	file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+	file.write(reinterpret_cast<const char *>(&hash), sizeof(hash));
+	bool result = file.good() && settings.serializeTree(file);
+	file.close();
+	if (!result || !file.good())
+		g_remove(cacheFile.c_str());
+}
+static bool writeSettingsFiles(const dynv::Map &settings, const std::string &configFile, const std::string &cacheFile)
+{
+	std::ostringstream settingsData;
+	if (!settings.serializeXml(settingsData))
+		return false;
+	auto data = settingsData.str();
+	std::ofstream settingsFile(configFile.c_str(), std::ios::binary);
+	if (!settingsFile.is_open()){
+		return false;
+	}
+	settingsFile.write(data.c_str(), data.length());
+	settingsFile.close();
+	if (!settingsFile.good())
+		return false;
+	writeSettingsCache(settings, cacheFile, data);
+	return true;
+}
+
 struct GlobalState::Impl
 {
 	GlobalState *m_decl;
@@ -54,12 +103,18 @@ struct GlobalState::Impl
 	dynv::Map m_settings;
 	lua::Script m_script;
 	Random *m_random;
+	lua::Profiler m_profiler;
 	Converters m_converters;
 	layout::Layouts m_layouts;
 	lua::Callbacks m_callbacks;
+	std::unique_ptr<lua::ScriptPool> m_script_pool;
 	transformation::Chain *m_transformation_chain;
 	GtkWidget *m_status_bar;
 	ColorSource *m_color_source;
+	std::atomic<uint64_t> m_writtenRevision;
+	uint64_t m_idleRevision;
+	std::thread m_settingsWriter;
+	std::atomic<bool> m_settingsWriterBusy;
 	Impl(GlobalState *decl):
 		m_decl(decl),
 		m_color_names(nullptr),
@@ -69,11 +124,15 @@ struct GlobalState::Impl
 		m_random(nullptr),
 		m_transformation_chain(nullptr),
 		m_status_bar(nullptr),
-		m_color_source(nullptr)
+		m_color_source(nullptr),
+		m_writtenRevision(0),
+		m_idleRevision(0),
+		m_settingsWriterBusy(false)
 	{
 	}
 	~Impl()
 	{
+		waitForSettingsWriter();
 		if (m_transformation_chain != nullptr)
 			delete m_transformation_chain;
 		if (m_color_list != nullptr)
@@ -87,27 +146,82 @@ struct GlobalState::Impl
 		if (m_screen_reader != nullptr)
 			screen_reader_destroy(m_screen_reader);
 	}
+	void waitForSettingsWriter() {
+		if (m_settingsWriter.joinable())
+			m_settingsWriter.join();
+	}
 	bool writeSettings() {
-		auto configFile = buildConfigPath("settings.xml");
-		std::ofstream settingsFile(configFile.c_str());
-		if (!settingsFile.is_open()){
+		waitForSettingsWriter();
+		auto revision = m_settings.treeChangeRevision();
+		if (revision == m_writtenRevision)
+			return true;
+		if (!writeSettingsFiles(m_settings, buildConfigPath("settings.xml"), buildConfigPath("settings.cache")))
 			return false;
-		}
-		if (!m_settings.serializeXml(settingsFile))
+		m_writtenRevision = revision;
+		return true;
+	}
+	// Writes a snapshot of settings in a background thread when settings have changed, but stayed the same since the previous call
+	bool writeSettingsInBackground() {
+		auto revision = m_settings.treeChangeRevision();
+		bool settled = revision == m_idleRevision;
+		m_idleRevision = revision;
+		if (!settled || revision == m_writtenRevision)
 			return false;
-		settingsFile.close();
-		return settingsFile.good();
+		if (m_settingsWriterBusy)
+			return false;
+		waitForSettingsWriter();
+		auto snapshot = m_settings.clone();
+		auto configFile = buildConfigPath("settings.xml");
+		auto cacheFile = buildConfigPath("settings.cache");
+		m_settingsWriterBusy = true;
+		m_settingsWriter = std::thread([this, revision, snapshot = std::move(snapshot), configFile, cacheFile]() {
+			if (writeSettingsFiles(*snapshot, configFile, cacheFile))
+				m_writtenRevision = revision;
+			m_settingsWriterBusy = false;
+		});
+		return true;
 	}
-	bool loadSettings() {
+	// Binary settings cache is only written when writeCache is set, so that headless conversion does not write to configuration directory
+	bool loadSettings(bool writeCache = true) {
 		auto configFile = buildConfigPath("settings.xml");
-		std::ifstream settingsFile(configFile.c_str());
+		std::ifstream settingsFile(configFile.c_str(), std::ios::binary);
 		if (!settingsFile.is_open()){
 			return false;
 		}
-		if (!m_settings.deserializeXml(settingsFile)) {
+		std::string data((std::istreambuf_iterator<char>(settingsFile)), std::istreambuf_iterator<char>());
+		settingsFile.close();
+		if (!loadSettingsCache(data)) {
+			std::istringstream settingsData(data);
+			if (!m_settings.deserializeXml(settingsData)) {
+				return false;
+			}
+			if (writeCache)
+				writeSettingsCache(m_settings, buildConfigPath("settings.cache"), data);
+		}
+		m_writtenRevision = m_idleRevision = m_settings.treeChangeRevision();
+		return true;
+	}
+	// Loads settings from the binary cache, if it was written for the same XML file
+	bool loadSettingsCache(const std::string &xmlData) {
+		auto cacheFile = buildConfigPath("settings.cache");
+		std::ifstream file(cacheFile.c_str(), std::ios::binary);
+		if (!file.is_open())
+			return false;
+		char magic[sizeof(SettingsCacheMagic)];
+		uint32_t version;
+		uint64_t size, hash;
+		file.read(magic, sizeof(magic));
+		file.read(reinterpret_cast<char *>(&version), sizeof(version));
+		file.read(reinterpret_cast<char *>(&size), sizeof(size));
+		file.read(reinterpret_cast<char *>(&hash), sizeof(hash));
+		if (!file.good() || memcmp(magic, SettingsCacheMagic, sizeof(magic)) != 0 || boost::endian::little_to_native(version) != SettingsCacheVersion)
+			return false;
+		if (boost::endian::little_to_native(size) != xmlData.length() || boost::endian::little_to_native(hash) != common::hash(xmlData.c_str(), xmlData.length()))
+			return false;
+		if (!m_settings.deserializeTree(file)) {
+			m_settings.removeAll();
 			return false;
 		}
-		settingsFile.close();
 		return true;
 	}
 	// Creates configuration directory if it doesn't exist
@@ -152,18 +266,41 @@ struct GlobalState::Impl
 		m_color_list = color_list_new();
 		return true;
 	}
-	bool initializeLua()
+	std::vector<std::string> getScriptPaths()
 	{
-		lua_State *L = m_script;
-		lua::registerAll(L, *m_decl);
 		std::vector<std::string> paths;
 		paths.push_back(buildFilename());
 		paths.push_back(buildConfigPath());
-		m_script.setPaths(paths);
+		return paths;
+	}
+	// Returns compiled script cache directory, or empty string if directory can not be created
+	std::string getScriptCachePath()
+	{
+		namespace fs = boost::filesystem;
+		auto cachePath = fs::path(buildConfigPath("script_cache"));
+		boost::system::error_code ec;
+		fs::create_directories(cachePath, ec);
+		if (ec)
+			return std::string();
+		return cachePath.string();
+	}
+	bool initializeLua(bool useCache = true)
+	{
+		auto start = std::chrono::steady_clock::now();
+		lua_State *L = m_script;
+		lua::registerAll(L, *m_decl);
+		m_script.setPaths(getScriptPaths());
+		auto cachePath = useCache ? getScriptCachePath() : std::string();
+		if (!cachePath.empty())
+			m_script.setCachePath(cachePath);
 		bool result = m_script.load("init");
 		if (!result){
 			std::cerr << "Lua load error: " << m_script.getLastError() << "\n";
 		}
+		if (getenv("GPICK_STARTUP_TIMER") != nullptr) {
+			auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			std::cerr << "Lua initialized in " << duration.count() / 1000.0 << " ms, script cache hits: " << m_script.getCacheHits() << ", misses: " << m_script.getCacheMisses() << "\n";
+		}
 		return result;
 	}
 	bool loadConverters()
@@ -201,6 +338,18 @@ struct GlobalState::Impl
 		m_converters.rebuildCopyPasteArrays();
 		m_converters.display(m_settings.getString("gpick.converters.display", "color_web_hex"));
 		m_converters.colorList(m_settings.getString("gpick.converters.color_list", "color_web_hex"));
+		m_converters.builtinOptions().upperCase = m_settings.getString("gpick.options.hex_case", "upper") == "upper";
+		return true;
+	}
+	bool createScriptPool()
+	{
+		if (m_script_pool)
+			return false;
+		// Layouts are only used by the main state
+		auto register_extensions = [this](lua_State *L, Converters &converters, lua::Callbacks &callbacks) {
+			lua::registerAll(L, *m_decl, converters, callbacks, nullptr);
+		};
+		m_script_pool = std::make_unique<lua::ScriptPool>(register_extensions, getScriptPaths(), m_script.getCachePath(), &m_profiler, m_settings);
 		return true;
 	}
 	bool loadTransformationChain()
@@ -234,11 +383,27 @@ struct GlobalState::Impl
 		loadSettings();
 		loadColorNames();
 		createColorList();
+		m_converters.profiler(&m_profiler);
+		m_callbacks.profiler(&m_profiler);
 		initializeLua();
 		loadConverters();
+		createScriptPool();
 		loadTransformationChain();
 		return true;
 	}
+	// Loads everything needed for palette conversion, without touching the display or writing to configuration directory.
+	// Script pool is created by GlobalState::scriptPool() when it is first needed.
+	bool loadHeadless()
+	{
+		loadSettings(false);
+		loadColorNames();
+		createColorList();
+		m_converters.profiler(&m_profiler);
+		m_callbacks.profiler(&m_profiler);
+		bool result = initializeLua(false);
+		loadConverters();
+		return result;
+	}
 };
 
 GlobalState::GlobalState()
@@ -256,10 +421,18 @@ bool GlobalState::loadAll()
 {
 	return m_impl->loadAll();
 }
+bool GlobalState::loadHeadless()
+{
+	return m_impl->loadHeadless();
+}
 bool GlobalState::writeSettings()
 {
 	return m_impl->writeSettings();
 }
+bool GlobalState::writeSettingsInBackground()
+{
+	return m_impl->writeSettingsInBackground();
+}
 ColorNames *GlobalState::getColorNames()
 {
 	return m_impl->m_color_names;
@@ -288,6 +461,15 @@ lua::Callbacks &GlobalState::callbacks()
 {
 	return m_impl->m_callbacks;
 }
+lua::ScriptPool &GlobalState::scriptPool()
+{
+	m_impl->createScriptPool();
+	return *m_impl->m_script_pool;
+}
+lua::Profiler &GlobalState::profiler()
+{
+	return m_impl->m_profiler;
+}
 Random *GlobalState::getRandom()
 {
 	return m_impl->m_random;
@@ -39,6 +39,8 @@ namespace transformation {
 namespace lua {
 	struct Script;
 	struct Callbacks;
+	struct ScriptPool;
+	struct Profiler;
 }
 struct GlobalState
 {
@@ -46,7 +48,10 @@ struct GlobalState
 	~GlobalState();
 	bool loadSettings();
 	bool loadAll();
+	// Loads settings, color names, Lua and converters only. Screen reader and sampler are not created, so no display is needed.
+	bool loadHeadless();
 	bool writeSettings();
+	bool writeSettingsInBackground();
 	ColorNames *getColorNames();
 	Sampler *getSampler();
 	ScreenReader *getScreenReader();
@@ -54,6 +59,9 @@ struct GlobalState
 	dynv::Map &settings();
 	lua::Script &script();
 	lua::Callbacks &callbacks();
+	// Created on first use if it was not created by load()
+	lua::ScriptPool &scriptPool();
+	lua::Profiler &profiler();
 	Converters &converters();
 	Random *getRandom();
 	layout::Layouts &layouts();
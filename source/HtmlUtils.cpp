@@ -18,8 +18,10 @@
 
 #include "HtmlUtils.h"
 #include "Color.h"
+#include "common/FileWriter.h"
 #include <algorithm>
 #include <iterator>
+#include <cstring>
 #include <boost/math/special_functions/round.hpp>
 using namespace std;
 
@@ -99,3 +101,48 @@ std::ostream& operator<<(std::ostream& os, const HtmlHSL color)
 	os.setf(flags);
 	return os;
 }
+common::FileWriter &operator<<(common::FileWriter &writer, const HtmlRGB color)
+{
+	using boost::math::iround;
+	return writer << "rgb(" << iround(color.color->rgb.red * 255) << ", " << iround(color.color->rgb.green * 255) << ", " << iround(color.color->rgb.blue * 255) << ")";
+}
+static uint8_t clampComponent(int value)
+{
+	return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+common::FileWriter &operator<<(common::FileWriter &writer, const HtmlHEX color)
+{
+	using boost::math::iround;
+	writer << '#';
+	writer.writeHex(clampComponent(iround(color.color->rgb.red * 255)));
+	writer.writeHex(clampComponent(iround(color.color->rgb.green * 255)));
+	return writer.writeHex(clampComponent(iround(color.color->rgb.blue * 255)));
+}
+common::FileWriter &operator<<(common::FileWriter &writer, const HtmlHSL color)
+{
+	using boost::math::iround;
+	return writer << "hsl(" << iround(color.color->hsl.hue * 360) << ", " << iround(color.color->hsl.saturation * 100) << "%, " << iround(color.color->hsl.lightness * 100) << "%)";
+}
+common::FileWriter &operator<<(common::FileWriter &writer, const HtmlEscaped text)
+{
+	const char *value = text.text.c_str(), *end = value + text.text.length();
+	while (value < end){
+		size_t length = strcspn(value, "&\"'<>");
+		if (value + length > end)
+			length = end - value;
+		writer.write(value, length);
+		value += length;
+		if (value >= end)
+			break;
+		switch (*value){
+			case '&': writer << "&amp;"; break;
+			case '"': writer << "&quot;"; break;
+			case '\'': writer << "&apos;"; break;
+			case '<': writer << "&lt;"; break;
+			case '>': writer << "&gt;"; break;
+			default: writer << *value;
+		}
+		value++;
+	}
+	return writer;
+}
@@ -23,6 +23,9 @@
 #include <iostream>
 std::string &escapeHtmlInplace(std::string &str);
 std::string escapeHtml(const std::string &str);
+namespace common {
+struct FileWriter;
+}
 
 struct Color;
 struct HtmlRGB
@@ -37,8 +40,16 @@ struct HtmlHSL
 {
 	Color *color;
 };
+struct HtmlEscaped
+{
+	const std::string &text;
+};
 std::ostream& operator<<(std::ostream& os, const HtmlRGB color);
 std::ostream& operator<<(std::ostream& os, const HtmlHEX color);
 std::ostream& operator<<(std::ostream& os, const HtmlHSL color);
+common::FileWriter &operator<<(common::FileWriter &writer, const HtmlRGB color);
+common::FileWriter &operator<<(common::FileWriter &writer, const HtmlHEX color);
+common::FileWriter &operator<<(common::FileWriter &writer, const HtmlHSL color);
+common::FileWriter &operator<<(common::FileWriter &writer, const HtmlEscaped text);
 
 #endif /* GPICK_HTML_UTILS_H_ */
@@ -23,20 +23,25 @@
 #include "Converters.h"
 #include "Converter.h"
 #include "I18N.h"
-#include "StringUtils.h"
 #include "HtmlUtils.h"
-#include "GlobalState.h"
+#include "AdobeSwatchExchange.h"
 #include "dynv/Map.h"
 #include "version/Version.h"
 #include "parser/TextFile.h"
-#include <glib.h>
+#include "common/LineReader.h"
+#include "common/FileWriter.h"
+#include "common/MappedFile.h"
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
 #include <boost/math/special_functions/round.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
-#include <boost/endian/conversion.hpp>
 using namespace std;
 
 static bool getOrderedColors(ColorList *color_list, vector<ColorObject*> &ordered)
@@ -66,14 +71,14 @@ static bool getOrderedColors(ColorList *color_list, vector<ColorObject*> &ordere
 		return true;
 	}
 }
-ImportExport::ImportExport(ColorList *color_list, const char* filename, GlobalState *gs):
+ImportExport::ImportExport(ColorList *color_list, const char* filename, const dynv::Map *settings):
 	m_color_list(color_list),
 	m_converter(nullptr),
 	m_converters(nullptr),
 	m_filename(filename),
 	m_item_size(ItemSize::medium),
 	m_background(Background::none),
-	m_gs(gs),
+	m_settings(settings),
 	m_include_color_names(true),
 	m_last_error(Error::none)
 {
@@ -104,6 +109,10 @@ void ImportExport::setConverter(Converter *converter)
 {
 	m_converter = converter;
 }
+void ImportExport::setSerializer(const Serializer &serializer)
+{
+	m_serializer = serializer;
+}
 void ImportExport::setConverters(Converters *converters)
 {
 	m_converters = converters;
@@ -154,88 +163,182 @@ void ImportExport::setIncludeColorNames(bool include_color_names)
 {
 	m_include_color_names = include_color_names;
 }
-static void gplColor(ColorObject* color_object, ostream &stream)
+void ImportExport::setProgressCallback(const std::function<bool(float progress)> &progress_callback)
+{
+	m_progress_callback = progress_callback;
+}
+// Streams lines of a text file and adds imported colors to the color list in batches.
+// Batches added before the import is cancelled stay in the color list, so that large imports show colors as they are read.
+struct LineImport
+{
+	static const size_t batch_size = 4096;
+	LineImport(ColorList *color_list, const std::string &filename, const std::function<bool(float)> &progress_callback):
+		m_color_list(color_list),
+		m_file(filename, ios::in | ios::binary),
+		m_reader(m_file),
+		m_progress_callback(progress_callback),
+		m_size(0),
+		m_lines(0),
+		m_cancelled(false)
+	{
+		m_colors.reserve(batch_size);
+		if (m_file.is_open() && m_progress_callback){
+			boost::system::error_code ec;
+			m_size = boost::filesystem::file_size(filename, ec);
+			if (ec) m_size = 0;
+		}
+	}
+	~LineImport()
+	{
+		for (auto color_object: m_colors)
+			color_object->release();
+	}
+	bool isOpen() const
+	{
+		return m_file.is_open();
+	}
+	// Returns false at the end of file, on read error or when import is cancelled
+	bool next(char *&line, size_t &length)
+	{
+		if (m_cancelled)
+			return false;
+		if ((++m_lines % batch_size) == 0 && !flush())
+			return false;
+		if (!m_reader.next(line, length))
+			return false;
+		trim(line, length);
+		return true;
+	}
+	// Colors are flushed by next() every batch_size lines, so that cancellation is noticed before the next line is parsed
+	void add(ColorObject *color_object)
+	{
+		m_colors.push_back(color_object);
+	}
+	// Adds remaining colors and reports progress, returns false if import was cancelled
+	bool flush()
+	{
+		if (m_cancelled)
+			return false;
+		color_list_add(m_color_list, m_colors, true);
+		for (auto color_object: m_colors)
+			color_object->release();
+		m_colors.clear();
+		if (m_progress_callback && m_size > 0 && !m_progress_callback(std::min(1.0f, static_cast<float>(m_reader.position()) / m_size)))
+			m_cancelled = true;
+		return !m_cancelled;
+	}
+	bool failed() const
+	{
+		return m_reader.failed();
+	}
+	bool cancelled() const
+	{
+		return m_cancelled;
+	}
+	static void trim(char *&line, size_t &length)
+	{
+		while (length > 0 && (line[0] == ' ' || line[0] == '\t')){
+			line++;
+			length--;
+		}
+		while (length > 0 && (line[length - 1] == ' ' || line[length - 1] == '\t'))
+			length--;
+		line[length] = 0;
+	}
+	private:
+	ColorList *m_color_list;
+	ifstream m_file;
+	common::LineReader m_reader;
+	std::function<bool(float)> m_progress_callback;
+	vector<ColorObject*> m_colors;
+	uint64_t m_size;
+	size_t m_lines;
+	bool m_cancelled;
+};
+static void gplColor(ColorObject* color_object, common::FileWriter &writer)
 {
 	using boost::math::iround;
-	Color color = color_object->getColor();
-	stream
-		<< iround(color.rgb.red * 255) << "\t"
-		<< iround(color.rgb.green * 255) << "\t"
-		<< iround(color.rgb.blue * 255) << "\t" << color_object->getName() << endl;
+	const Color &color = color_object->getColor();
+	writer
+		<< iround(color.rgb.red * 255) << '\t'
+		<< iround(color.rgb.green * 255) << '\t'
+		<< iround(color.rgb.blue * 255) << '\t' << color_object->getName() << '\n';
 }
 bool ImportExport::exportGPL()
 {
-	ofstream f(m_filename, ios::out | ios::trunc);
-	if (!f.is_open()){
+	common::FileWriter f(m_filename.c_str());
+	if (!f.isOpen()){
 		m_last_error = Error::could_not_open_file;
 		return false;
 	}
 	boost::filesystem::path path(m_filename);
-	f << "GIMP Palette" << endl;
-	f << "Name: " << path.filename().string() << endl;
-	f << "Columns: 1" << endl;
-	f << "#" << endl;
+	f << "GIMP Palette\n";
+	f << "Name: " << path.filename().string() << '\n';
+	f << "Columns: 1\n";
+	f << "#\n";
 	vector<ColorObject*> ordered;
 	getOrderedColors(m_color_list, ordered);
 	for (auto color: ordered){
 		gplColor(color, f);
-		if (!f.good()){
-			f.close();
-			m_last_error = Error::file_write_error;
-			return false;
-		}
+		if (!f.good())
+			break;
+	}
+	if (!f.close()){
+		m_last_error = Error::file_write_error;
+		return false;
 	}
-	f.close();
 	return true;
 }
 bool ImportExport::importGPL()
 {
-	ifstream f(m_filename, ios::in);
-	if (!f.is_open()){
+	LineImport import(m_color_list, m_filename, m_progress_callback);
+	if (!import.isOpen()){
 		m_last_error = Error::could_not_open_file;
 		return false;
 	}
-	string line;
-	getline(f, line);
-	if (f.good() && line != "GIMP Palette"){
-		f.close();
+	char *line;
+	size_t length;
+	if (import.next(line, length) && strcmp(line, "GIMP Palette") != 0){
 		m_last_error = Error::file_read_error;
 		return false;
 	}
-	do{
-		getline(f, line);
-	}while (f.good() && ((line.size() < 1) || (((line[0] > '9') || (line[0] < '0')) && line[0] != ' ')));
-	int r, g, b;
+	bool header = true;
 	Color c;
-	ColorObject* color_object;
-	string strip_chars = " \t";
-	for(;;){
-		if (!f.good()) break;
-		stripLeadingTrailingChars(line, strip_chars);
-		if (line.length() > 0 && line[0] == '#'){ // skip comment lines
-			getline(f, line);
+	while (import.next(line, length)){
+		if (length == 0 || line[0] == '#') // skip empty and comment lines
 			continue;
+		if (header){ // skip header lines like "Name:" and "Columns:"
+			if (line[0] < '0' || line[0] > '9')
+				continue;
+			header = false;
 		}
-		stringstream ss(line);
-		ss >> r >> g >> b;
-		getline(ss, line);
-		if (!f.good()) line = "";
-		c.rgb.red = r / 255.0;
-		c.rgb.green = g / 255.0;
-		c.rgb.blue = b / 255.0;
-		color_object = color_list_new_color_object(m_color_list, &c);
-		stripLeadingTrailingChars(line, strip_chars);
-		color_object->setName(line);
-		color_list_add_color_object(m_color_list, color_object, true);
-		color_object->release();
-		getline(f, line);
+		char *start = line, *end;
+		long rgb[3];
+		bool valid = true;
+		for (int i = 0; i < 3 && valid; i++){
+			rgb[i] = strtol(line, &end, 10);
+			valid = end != line;
+			line = end;
+		}
+		if (!valid)
+			continue;
+		length -= line - start;
+		c.rgb.red = rgb[0] / 255.0;
+		c.rgb.green = rgb[1] / 255.0;
+		c.rgb.blue = rgb[2] / 255.0;
+		auto color_object = color_list_new_color_object(m_color_list, &c);
+		LineImport::trim(line, length);
+		color_object->setName(string(line, length));
+		import.add(color_object);
+	}
+	if (!import.flush()){
+		m_last_error = Error::cancelled;
+		return false;
 	}
-	if (!f.eof()) {
-		f.close();
+	if (import.failed()){
 		m_last_error = Error::file_read_error;
 		return false;
 	}
-	f.close();
 	return true;
 }
 bool ImportExport::importGPA()
@@ -244,143 +347,146 @@ bool ImportExport::importGPA()
 }
 bool ImportExport::exportGPA()
 {
-	return palette_file_save(m_filename.c_str(), m_color_list) == 0;
+	int compression_level = m_settings ? m_settings->getInt32("gpick.main.palette_compression_level", 0) : 0;
+	bool compatible = m_settings ? m_settings->getBool("gpick.main.palette_compatible", true) : true;
+	return palette_file_save(m_filename.c_str(), m_color_list, compression_level, compatible) == 0;
 }
 bool ImportExport::exportTXT()
 {
-	ofstream f(m_filename.c_str(), ios::out | ios::trunc);
-	if (!f.is_open()){
+	common::FileWriter f(m_filename.c_str());
+	if (!f.isOpen()){
 		m_last_error = Error::could_not_open_file;
 		return false;
 	}
 	vector<ColorObject*> ordered;
 	getOrderedColors(m_color_list, ordered);
-	ConverterSerializePosition position(ordered.size());
-	for (auto color: ordered){
-		string line = m_converter->serialize(color, position);
-		f << line << endl;
-		position.incrementIndex();
-		if (position.index() + 1 == position.count()){
-			position.last(true);
-		}
-		if (position.first())
+	if (m_converter->builtin()){
+		// Builtin converters append to a reused line, so nothing is allocated per color
+		string line;
+		ConverterSerializePosition position(ordered.size());
+		for (auto color: ordered){
+			if (position.index() + 1 == position.count())
+				position.last(true);
+			line.clear();
+			m_converter->serialize(*color, position, line);
+			f << line << '\n';
+			if (!f.good())
+				break;
 			position.first(false);
-		if (!f.good()){
-			f.close();
-			m_last_error = Error::file_write_error;
-			return false;
+			position.incrementIndex();
+		}
+	}else{
+		vector<string> lines;
+		// Plain Lua converters are the slow case, so large palettes are split between pooled Lua states
+		bool parallel = ordered.size() >= 1024 && m_serializer && !m_converter->hasSerializeMany();
+		if (!parallel || !m_serializer(*m_converter, ordered, lines))
+			lines = m_converter->serialize(ordered);
+		for (auto &line: lines){
+			f << line << '\n';
+			if (!f.good())
+				break;
 		}
 	}
-	f.close();
+	if (!f.close()){
+		m_last_error = Error::file_write_error;
+		return false;
+	}
 	return true;
 }
 bool ImportExport::importTXT()
 {
-	ifstream f(m_filename.c_str(), ios::in);
-	if (!f.is_open()){
+	LineImport import(m_color_list, m_filename, m_progress_callback);
+	if (!import.isOpen()){
 		m_last_error = Error::could_not_open_file;
 		return false;
 	}
-	ColorObject *color_object;
 	Color dummy_color;
-	multimap<float, ColorObject*, greater<float>> valid_converters;
-	string line;
-	string strip_chars = " \t";
+	auto &converters = m_converters->allPaste();
+	char *line;
+	size_t length;
 	bool imported = false;
-	for(;;){
-		getline(f, line);
-		stripLeadingTrailingChars(line, strip_chars);
-		if (!line.empty()){
-			for (auto &converter: m_converters->allPaste()){
-				if (!converter->hasDeserialize())
-					continue;
-				color_object = color_list_new_color_object(m_color_list, &dummy_color);
-				float quality;
-				if (converter->deserialize(line.c_str(), color_object, quality)){
-					if (quality > 0){
-						valid_converters.insert(make_pair(quality, color_object));
-					}else{
-						color_object->release();
-					}
-				}else{
-					color_object->release();
-				}
-			}
-			bool first = true;
-			for (auto result: valid_converters){
-				if (first){
-					first = false;
-					color_list_add_color_object(m_color_list, result.second, true);
-					imported = true;
-				}
-				result.second->release();
+	while (import.next(line, length)){
+		if (length == 0)
+			continue;
+		ColorObject *best = nullptr;
+		float best_quality = 0;
+		for (auto &converter: converters){
+			if (!converter->hasDeserialize())
+				continue;
+			auto color_object = color_list_new_color_object(m_color_list, &dummy_color);
+			float quality;
+			if (converter->deserialize(line, color_object, quality) && quality > best_quality){
+				if (best)
+					best->release();
+				best = color_object;
+				best_quality = quality;
+			}else{
+				color_object->release();
 			}
-			valid_converters.clear();
 		}
-		if (!f.good()) {
-			if (f.eof()) break;
-			f.close();
-			m_last_error = Error::file_read_error;
-			return false;
+		if (best){
+			import.add(best);
+			imported = true;
 		}
 	}
-	f.close();
+	if (!import.flush()){
+		m_last_error = Error::cancelled;
+		return false;
+	}
+	if (import.failed()){
+		m_last_error = Error::file_read_error;
+		return false;
+	}
 	if (!imported){
 		m_last_error = Error::no_colors_imported;
 	}
 	return imported;
 }
-static void cssColor(ColorObject* color_object, ostream &stream)
+static void cssColor(ColorObject* color_object, common::FileWriter &writer)
 {
 	Color color, hsl;
 	color = color_object->getColor();
 	color_rgb_to_hsl(&color, &hsl);
-	stream << " * " << color_object->getName()
+	writer << " * " << color_object->getName()
 		<< ": " << HtmlHEX{&color}
 		<< ", " << HtmlRGB{&color}
 		<< ", " << HtmlHSL{&color}
-		<< endl;
+		<< '\n';
 }
 bool ImportExport::exportCSS()
 {
-	ofstream f(m_filename.c_str(), ios::out | ios::trunc);
-	if (!f.is_open()){
+	common::FileWriter f(m_filename.c_str());
+	if (!f.isOpen()){
 		m_last_error = Error::could_not_open_file;
 		return false;
 	}
-	f << "/**" << endl << " * Generated by Gpick " << gpick_build_version << endl;
+	f << "/**\n * Generated by Gpick " << gpick_build_version << '\n';
 	vector<ColorObject*> ordered;
 	getOrderedColors(m_color_list, ordered);
 	for (auto color: ordered){
 		cssColor(color, f);
-		if (!f.good()){
-			f.close();
-			m_last_error = Error::file_write_error;
-			return false;
-		}
+		if (!f.good())
+			break;
 	}
-	f << " */" << endl;
-	if (!f.good()){
-		f.close();
+	f << " */\n";
+	if (!f.close()){
 		m_last_error = Error::file_write_error;
 		return false;
 	}
-	f.close();
 	return true;
 }
-static void htmlColor(ColorObject* color_object, bool include_color_name, ostream &stream)
+static void htmlColor(ColorObject* color_object, bool include_color_name, common::FileWriter &writer)
 {
 	Color color, text_color;
 	color = color_object->getColor();
 	color_get_contrasting(&color, &text_color);
-	stream << "<div style=\"background-color:" << HtmlRGB{&color} << "; color:" << HtmlRGB{&text_color} << "\">";
+	writer << "<div style=\"background-color:" << HtmlRGB{&color} << "; color:" << HtmlRGB{&text_color} << "\">";
 	if (include_color_name){
-		string name = color_object->getName();
-		escapeHtmlInplace(name);
+		const string &name = color_object->getName();
 		if (!name.empty())
-			stream << name << ":<br/>";
+			writer << HtmlEscaped{name} << ":<br/>";
 	}
-	stream << "<span>" << HtmlHEX{&color} << "</span>" << "</div>";
+	writer << "<span>" << HtmlHEX{&color} << "</span></div>";
 }
 static string getHtmlColor(ColorObject* color_object)
 {
@@ -391,8 +497,8 @@ static string getHtmlColor(ColorObject* color_object)
 }
 bool ImportExport::exportHTML()
 {
-	ofstream f(m_filename.c_str(), ios::out | ios::trunc);
-	if (!f.is_open()){
+	common::FileWriter f(m_filename.c_str());
+	if (!f.isOpen()){
 		m_last_error = Error::could_not_open_file;
 		return false;
 	}
@@ -438,54 +544,44 @@ bool ImportExport::exportHTML()
 			break;
 	}
 	f << "<!DOCTYPE html><html lang=\"en\"><head><meta charset=\"utf-8\"><title>"
-		<< path.filename().string() << "</title>" << endl
-		<< "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">" << endl
-		<< "<style>" << endl
-		<< "div#colors div{float: left; width: " << item_size << "px; height: " << item_size << "px; margin: 2px; text-align: center; font-size: 12px; font-family: Arial, Helvetica, sans-serif}" << endl
-		<< "div#colors div span{font-weight: bold; cursor: pointer}" << endl
-		<< "div#colors div span:hover{text-decoration: underline}" << endl
-		<< "html{" << background << "}" << endl
-		<< "input{margin-left: 1em;}" << endl
-		<< "</style>"
-		<< "</head>" << endl
-		<< "<body>" << endl;
+		<< path.filename().string() << "</title>\n"
+		"<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
+		"<style>\n"
+		"div#colors div{float: left; width: " << item_size << "px; height: " << item_size << "px; margin: 2px; text-align: center; font-size: 12px; font-family: Arial, Helvetica, sans-serif}\n"
+		"div#colors div span{font-weight: bold; cursor: pointer}\n"
+		"div#colors div span:hover{text-decoration: underline}\n"
+		"html{" << background << "}\n"
+		"input{margin-left: 1em;}\n"
+		"</style></head>\n"
+		"<body>\n";
 	if (m_item_size == ItemSize::controllable || m_background == Background::controllable){
-		f << "<form>" << endl;
+		f << "<form>\n";
 		if (m_item_size == ItemSize::controllable){
-			f << "<div>" << _("Item size") << ":<input type=\"range\" id=\"item_size\" min=\"16\" max=\"128\" value=\"64\" oninput=\"var elements = document.querySelectorAll('div#colors div'); for (var i = 0; i < elements.length; i++){ elements[i].style.width = this.value + 'px'; elements[i].style.height = this.value + 'px'; }\" />" << "</div>" << endl;
+			f << "<div>" << _("Item size") << ":<input type=\"range\" id=\"item_size\" min=\"16\" max=\"128\" value=\"64\" oninput=\"var elements = document.querySelectorAll('div#colors div'); for (var i = 0; i < elements.length; i++){ elements[i].style.width = this.value + 'px'; elements[i].style.height = this.value + 'px'; }\" /></div>\n";
 		}
 		if (m_background == Background::controllable){
-			f << "<div>" << _("Background color") << ":<input type=\"color\" id=\"background\" oninput=\"document.body.style.backgroundColor = this.value;\" />" << "</div>" << endl;
+			f << "<div>" << _("Background color") << ":<input type=\"color\" id=\"background\" oninput=\"document.body.style.backgroundColor = this.value;\" /></div>\n";
 		}
-		f << "</form>" << endl;
-	}
-	f << "<div id=\"colors\">" << endl;
-	string hex_case = m_gs->settings().getString("gpick.options.hex_case", "upper");
-	if (hex_case == "upper"){
-		f << uppercase;
-	}else{
-		f << nouppercase;
+		f << "</form>\n";
 	}
+	f << "<div id=\"colors\">\n";
+	string hex_case = m_settings ? m_settings->getString("gpick.options.hex_case", "upper") : "upper";
+	f.uppercase(hex_case == "upper");
 	for (auto color: ordered){
 		htmlColor(color, m_include_color_names, f);
-		if (!f.good()){
-			f.close();
-			m_last_error = Error::file_write_error;
-			return false;
-		}
+		if (!f.good())
+			break;
 	}
-	f << "</div>" << endl;
-	f << "<script>" << endl
-		<< "function selectText(element){ if (document.selection){ var range = document.body.createTextRange(); range.moveToElementText(element); range.select(); }else if (window.getSelection){ var range = document.createRange(); range.selectNode(element); window.getSelection().addRange(range); } }" << endl
-		<< "document.getElementById('colors').addEventListener('click', function(event){ if (event.target.tagName.toLowerCase() == 'span'){ event.preventDefault(); selectText(event.target); document.execCommand('copy'); }});" << endl
-		<< "</script>";
-	f << "</body></html>" << endl;
-	if (!f.good()){
-		f.close();
+	f << "</div>\n";
+	f << "<script>\n"
+		"function selectText(element){ if (document.selection){ var range = document.body.createTextRange(); range.moveToElementText(element); range.select(); }else if (window.getSelection){ var range = document.createRange(); range.selectNode(element); window.getSelection().addRange(range); } }\n"
+		"document.getElementById('colors').addEventListener('click', function(event){ if (event.target.tagName.toLowerCase() == 'span'){ event.preventDefault(); selectText(event.target); document.execCommand('copy'); }});\n"
+		"</script>";
+	f << "</body></html>\n";
+	if (!f.close()){
 		m_last_error = Error::file_write_error;
 		return false;
 	}
-	f.close();
 	return true;
 }
 
@@ -541,192 +637,44 @@ bool ImportExport::exportMTL()
 	f.close();
 	return true;
 }
-typedef union FloatInt
-{
-	float f;
-	uint32_t i;
-}FloatInt;
-static void aseColor(ColorObject* color_object, ostream &stream)
-{
-	Color color = color_object->getColor();
-	string name = color_object->getName();
-	glong name_u16_len = 0;
-	gunichar2 *name_u16 = g_utf8_to_utf16(name.c_str(), -1, 0, &name_u16_len, 0);
-	for (glong i = 0; i < name_u16_len; ++i){
-		name_u16[i] = boost::endian::native_to_big<uint16_t>(name_u16[i]);
-	}
-	uint16_t color_entry = boost::endian::native_to_big<uint16_t>(0x0001);
-	stream.write((char*)&color_entry, 2);
-	int32_t block_size = 2 + (name_u16_len + 1) * 2 + 4 + (3 * 4) + 2; //name length + name (zero terminated and 2 bytes per char wide) + color name + 3 float values + color type
-	block_size = boost::endian::native_to_big<uint32_t>(block_size);
-	stream.write((char*)&block_size, 4);
-	uint16_t name_length = boost::endian::native_to_big<uint16_t>(uint16_t(name_u16_len + 1));
-	stream.write((char*)&name_length, 2);
-	stream.write((char*)name_u16, (name_u16_len + 1) * 2);
-	stream << "RGB ";
-	FloatInt r, g, b;
-	r.f = color.rgb.red;
-	g.f = color.rgb.green;
-	b.f = color.rgb.blue;
-	r.i = boost::endian::native_to_big<uint32_t>(r.i);
-	g.i = boost::endian::native_to_big<uint32_t>(g.i);
-	b.i = boost::endian::native_to_big<uint32_t>(b.i);
-	stream.write((char*)&r, 4);
-	stream.write((char*)&g, 4);
-	stream.write((char*)&b, 4);
-	int16_t color_type = boost::endian::native_to_big<uint16_t>(0);
-	stream.write((char*)&color_type, 2);
-	g_free(name_u16);
-}
 bool ImportExport::exportASE()
 {
-	ofstream f(m_filename.c_str(), ios::out | ios::trunc | ios::binary);
-	if (!f.is_open()){
+	vector<ColorObject*> ordered;
+	getOrderedColors(m_color_list, ordered);
+	string data;
+	ase::encode(ordered, data);
+	common::FileWriter f(m_filename.c_str());
+	if (!f.isOpen()){
 		m_last_error = Error::could_not_open_file;
 		return false;
 	}
-	f << "ASEF"; //magic header
-	uint32_t version = boost::endian::native_to_big<uint32_t>(0x00010000);
-	f.write((char*)&version, 4);
-	vector<ColorObject*> ordered;
-	getOrderedColors(m_color_list, ordered);
-	uint32_t blocks = ordered.size();
-	blocks = boost::endian::native_to_big<uint32_t>(blocks);
-	f.write((char*)&blocks, 4);
-	for (auto color: ordered){
-		aseColor(color, f);
-		if (!f.good()){
-			f.close();
-			m_last_error = Error::file_write_error;
-			return false;
-		}
+	f.write(data.data(), data.size());
+	if (!f.close()){
+		m_last_error = Error::file_write_error;
+		return false;
 	}
-	f.close();
 	return true;
 }
 bool ImportExport::importASE()
 {
-	ifstream f(m_filename.c_str(), ios::binary);
-	if (!f.is_open()){
+	common::MappedFile file(m_filename.c_str());
+	if (!file.valid()){
 		m_last_error = Error::could_not_open_file;
 		return false;
 	}
-	char magic[4];
-	f.read(magic, 4);
-	if (memcmp(magic, "ASEF", 4) != 0){
-		f.close();
+	vector<ColorObject*> color_objects;
+	bool decoded = ase::decode(file.data(), file.size(), [this, &color_objects](const string &name, const Color &color){
+		ColorObject *color_object = color_list_new_color_object(m_color_list, &color);
+		color_object->setName(name);
+		color_objects.push_back(color_object);
+	});
+	if (decoded)
+		color_list_add(m_color_list, color_objects, true);
+	else
 		m_last_error = Error::file_read_error;
-		return false;
-	}
-	uint32_t version;
-	f.read((char*)&version, 4);
-	version = boost::endian::big_to_native<uint32_t>(version);
-	uint32_t blocks;
-	f.read((char*)&blocks, 4);
-	blocks = boost::endian::big_to_native<uint32_t>(blocks);
-	uint16_t block_type;
-	uint32_t block_size;
-	int color_supported;
-	for (uint32_t i = 0; i < blocks; ++i){
-		f.read((char*)&block_type, 2);
-		block_type = boost::endian::big_to_native<uint16_t>(block_type);
-		f.read((char*)&block_size, 4);
-		block_size = boost::endian::big_to_native<uint32_t>(block_size);
-		switch (block_type){
-		case 0x0001: //color block
-			{
-				uint16_t name_length;
-				f.read((char*)&name_length, 2);
-				name_length = boost::endian::big_to_native<uint16_t>(name_length);
-
-				gunichar2 *name_u16 = (gunichar2*)g_malloc(name_length*2);
-				f.read((char*)name_u16, name_length*2);
-				for (uint32_t j = 0; j < name_length; ++j){
-					name_u16[j] = boost::endian::big_to_native<uint16_t>(name_u16[j]);
-				}
-				gchar *name = g_utf16_to_utf8(name_u16, name_length, 0, 0, 0);
-				g_free(name_u16);
-				Color c;
-				char color_space[4];
-				f.read(color_space, 4);
-				color_supported = 0;
-				if (memcmp(color_space, "RGB ", 4) == 0){
-					FloatInt rgb[3];
-					f.read((char*)&rgb[0], 4);
-					f.read((char*)&rgb[1], 4);
-					f.read((char*)&rgb[2], 4);
-					rgb[0].i = boost::endian::big_to_native<uint32_t>(rgb[0].i);
-					rgb[1].i = boost::endian::big_to_native<uint32_t>(rgb[1].i);
-					rgb[2].i = boost::endian::big_to_native<uint32_t>(rgb[2].i);
-					c.rgb.red = rgb[0].f;
-					c.rgb.green = rgb[1].f;
-					c.rgb.blue = rgb[2].f;
-					color_supported = 1;
-				}else if (memcmp(color_space, "CMYK", 4) == 0){
-					Color c2;
-					FloatInt cmyk[4];
-					f.read((char*)&cmyk[0], 4);
-					f.read((char*)&cmyk[1], 4);
-					f.read((char*)&cmyk[2], 4);
-					f.read((char*)&cmyk[3], 4);
-					cmyk[0].i = boost::endian::big_to_native<uint32_t>(cmyk[0].i);
-					cmyk[1].i = boost::endian::big_to_native<uint32_t>(cmyk[1].i);
-					cmyk[2].i = boost::endian::big_to_native<uint32_t>(cmyk[2].i);
-					cmyk[3].i = boost::endian::big_to_native<uint32_t>(cmyk[3].i);
-					c2.cmyk.c = cmyk[0].f;
-					c2.cmyk.m = cmyk[1].f;
-					c2.cmyk.y = cmyk[2].f;
-					c2.cmyk.k = cmyk[3].f;
-					color_cmyk_to_rgb(&c2, &c);
-					color_supported = 1;
-				}else if (memcmp(color_space, "Gray", 4) == 0){
-					FloatInt gray;
-					f.read((char*)&gray, 4);
-					gray.i = boost::endian::big_to_native<uint32_t>(gray.i);
-					c.rgb.red = c.rgb.green = c.rgb.blue = gray.f;
-					color_supported = 1;
-				}else if (memcmp(color_space, "LAB ", 4) == 0){
-					Color c2;
-					FloatInt lab[3];
-					f.read((char*)&lab[0], 4);
-					f.read((char*)&lab[1], 4);
-					f.read((char*)&lab[2], 4);
-					lab[0].i = boost::endian::big_to_native<uint32_t>(lab[0].i);
-					lab[1].i = boost::endian::big_to_native<uint32_t>(lab[1].i);
-					lab[2].i = boost::endian::big_to_native<uint32_t>(lab[2].i);
-					c2.lab.L = lab[0].f*100;
-					c2.lab.a = lab[1].f;
-					c2.lab.b = lab[2].f;
-					color_lab_to_rgb_d50(&c2, &c);
-					c.rgb.red = clamp_float(c.rgb.red, 0, 1);
-					c.rgb.green = clamp_float(c.rgb.green, 0, 1);
-					c.rgb.blue = clamp_float(c.rgb.blue, 0, 1);
-					color_supported = 1;
-				}
-				if (color_supported){
-					ColorObject* color_object;
-					color_object = color_list_new_color_object(m_color_list, &c);
-					color_object->setName(name);
-					color_list_add_color_object(m_color_list, color_object, true);
-					color_object->release();
-				}
-				uint16_t color_type;
-				f.read((char*)&color_type, 2);
-				g_free(name);
-			}
-			break;
-		default:
-			f.seekg(block_size, ios::cur);
-		}
-	}
-	f.close();
-	return true;
-}
-static string::size_type rfind_first_of_not(string const& str, string::size_type const pos, string const& chars)
-{
-	auto start = str.rend() - pos - 1;
-	auto found = std::find_first_of(start, str.rend(), chars.begin(), chars.end());
-	return found == str.rend() ? string::npos : pos - (found - start);
+	for (auto color_object: color_objects)
+		color_object->release();
+	return decoded;
 }
 static int hexToInt(char hex)
 {
@@ -741,44 +689,38 @@ static int hexPairToInt(const char *hex_pair)
 }
 bool ImportExport::importRGBTXT()
 {
-	ifstream f(m_filename.c_str(), ios::in);
-	if (!f.is_open()){
+	LineImport import(m_color_list, m_filename, m_progress_callback);
+	if (!import.isOpen()){
 		m_last_error = Error::could_not_open_file;
 		return false;
 	}
-	string line;
 	Color c;
-	ColorObject* color_object;
-	string strip_chars = " \t";
-	for(;;){
-		getline(f, line);
-		if (!f.good()) break;
-		stripLeadingTrailingChars(line, strip_chars);
-		if (line.length() > 0 && line[0] == '#'){ // skip comment lines
+	char *line;
+	size_t length;
+	while (import.next(line, length)){
+		if (length == 0 || line[0] == '#') // skip empty and comment lines
 			continue;
-		}
-		size_t hash_position = line.find('#');
-		if (hash_position != string::npos){
-			size_t last_non_space = rfind_first_of_not(line, hash_position, " \t");
-
-			c.rgb.red = hexPairToInt(&line.at(hash_position + 1)) / 255.0;
-			c.rgb.green = hexPairToInt(&line.at(hash_position + 3)) / 255.0;
-			c.rgb.blue = hexPairToInt(&line.at(hash_position + 5)) / 255.0;
-
-			color_object = color_list_new_color_object(m_color_list, &c);
-			if (last_non_space != string::npos){
-				color_object->setName(line.substr(0, last_non_space));
-			}
-			color_list_add_color_object(m_color_list, color_object, true);
-			color_object->release();
-		}
+		auto hash = reinterpret_cast<char *>(memchr(line, '#', length));
+		if (hash == nullptr || hash + 7 > line + length)
+			continue;
+		c.rgb.red = hexPairToInt(hash + 1) / 255.0;
+		c.rgb.green = hexPairToInt(hash + 3) / 255.0;
+		c.rgb.blue = hexPairToInt(hash + 5) / 255.0;
+		auto color_object = color_list_new_color_object(m_color_list, &c);
+		size_t name_length = hash - line;
+		LineImport::trim(line, name_length);
+		if (name_length > 0)
+			color_object->setName(string(line, name_length));
+		import.add(color_object);
+	}
+	if (!import.flush()){
+		m_last_error = Error::cancelled;
+		return false;
 	}
-	if (!f.eof()) {
-		f.close();
+	if (import.failed()){
 		m_last_error = Error::file_read_error;
 		return false;
 	}
-	f.close();
 	return true;
 }
 static bool compareChunkType(const char *chunk_type, const char *data)
@@ -848,6 +790,102 @@ FileType ImportExport::getFileType(const char *filename)
 	}
 	return getFileTypeByContent(filename);
 }
+static void expandDirectories(const vector<string> &filenames, vector<string> &result)
+{
+	namespace fs = boost::filesystem;
+	for (auto &filename: filenames){
+		boost::system::error_code ec;
+		if (!fs::is_directory(filename, ec)){
+			result.push_back(filename);
+			continue;
+		}
+		vector<string> directory_files;
+		for (fs::directory_iterator i(filename, ec), end; !ec && i != end; i.increment(ec)){
+			if (fs::is_regular_file(i->path(), ec))
+				directory_files.push_back(i->path().string());
+		}
+		sort(directory_files.begin(), directory_files.end());
+		result.insert(result.end(), directory_files.begin(), directory_files.end());
+	}
+}
+bool ImportExport::importFiles(ColorList *color_list, const std::vector<std::string> &filenames, Converters *converters, std::vector<std::string> *failed_filenames)
+{
+	vector<string> files;
+	expandDirectories(filenames, files);
+	vector<ColorList*> results(files.size(), nullptr);
+	// Not vector<bool>, because workers set flags of different files concurrently
+	vector<char> text_files(files.size(), false);
+	atomic<size_t> next_file(0);
+	size_t thread_count = std::min<size_t>(std::max(1u, thread::hardware_concurrency()), files.size());
+	auto worker = [&files, &results, &text_files, &next_file, thread_count](){
+		for (;;){
+			size_t index = next_file++;
+			if (index >= files.size())
+				break;
+			auto result = color_list_new();
+			ImportExport import_export(result, files[index].c_str(), nullptr);
+			bool imported = false;
+			switch (getFileType(files[index].c_str())){
+				case FileType::gpa:
+					// Files are already decoded in parallel, so each file is decoded on a single thread
+					imported = palette_file_load(files[index].c_str(), result, thread_count > 1 ? 1 : 0) == 0;
+					break;
+				case FileType::gpl:
+					imported = import_export.importGPL();
+					break;
+				case FileType::ase:
+					imported = import_export.importASE();
+					break;
+				case FileType::rgbtxt:
+					imported = import_export.importRGBTXT();
+					break;
+				case FileType::txt: // converters can only be used from the calling thread
+					text_files[index] = true;
+					break;
+				default:
+					break;
+			}
+			if (imported)
+				results[index] = result;
+			else
+				color_list_destroy(result);
+		}
+	};
+	vector<thread> threads;
+	for (size_t i = 1; i < thread_count; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto &thread: threads)
+		thread.join();
+	for (size_t i = 0; i < files.size(); i++){
+		if (!text_files[i] || !converters)
+			continue;
+		auto result = color_list_new();
+		ImportExport import_export(result, files[i].c_str(), nullptr);
+		import_export.setConverters(converters);
+		if (import_export.importTXT())
+			results[i] = result;
+		else
+			color_list_destroy(result);
+	}
+	vector<ColorObject*> color_objects;
+	bool imported = false;
+	for (size_t i = 0; i < files.size(); i++){
+		if (!results[i]){
+			if (failed_filenames)
+				failed_filenames->push_back(files[i]);
+			continue;
+		}
+		color_objects.insert(color_objects.end(), results[i]->colors.begin(), results[i]->colors.end());
+		imported = true;
+	}
+	color_list_add(color_list, color_objects, true);
+	for (auto result: results){
+		if (result)
+			color_list_destroy(result);
+	}
+	return imported;
+}
 FileType ImportExport::getFileTypeByExtension(const char *extension)
 {
 	string extension_lowercase = extension;
@@ -19,11 +19,16 @@
 #ifndef GPICK_IMPORT_EXPORT_H_
 #define GPICK_IMPORT_EXPORT_H_
 #include <string>
+#include <functional>
+#include <vector>
 
 struct ColorList;
+struct ColorObject;
 struct Converter;
 struct Converters;
-struct GlobalState;
+namespace dynv {
+struct Map;
+}
 namespace text_file_parser {
 struct Configuration;
 }
@@ -49,6 +54,7 @@ struct ImportExport
 		file_write_error,
 		no_colors_imported,
 		parsing_failed,
+		cancelled,
 	};
 	enum class ItemSize
 	{
@@ -67,14 +73,22 @@ struct ImportExport
 		last_color,
 		controllable,
 	};
-	ImportExport(ColorList *color_list, const char* filename, GlobalState *gs);
+	// Serializes colors with a Lua converter, possibly on several threads. Returns false if colors were not serialized.
+	typedef std::function<bool(const Converter &converter, const std::vector<ColorObject*> &color_objects, std::vector<std::string> &lines)> Serializer;
+	// Settings provide palette compression level and hex case, defaults are used when settings are not set
+	ImportExport(ColorList *color_list, const char* filename, const dynv::Map *settings = nullptr);
 	void setConverter(Converter *converter);
+	// Used by TXT export for large palettes and Lua converters without serializeMany
+	void setSerializer(const Serializer &serializer);
 	void setConverters(Converters *converters);
 	void setItemSize(ItemSize item_size);
 	void setItemSize(const char *item_size);
 	void setBackground(Background background);
 	void setBackground(const char *background);
 	void setIncludeColorNames(bool include_color_names);
+	// Called with import progress from 0 to 1 while text files are imported. Returning false cancels the import.
+	// Colors of a cancelled import, which were already added to the color list in batches, are kept.
+	void setProgressCallback(const std::function<bool(float progress)> &progress_callback);
 	bool exportGPL();
 	bool importGPL();
 	bool exportASE();
@@ -91,6 +105,10 @@ struct ImportExport
 	bool importType(FileType type);
 	bool exportType(FileType type);
 	Error getLastError() const;
+	// Imports GPA, GPL, ASE and rgb.txt files on worker threads, each into its own color list, then adds all colors to color_list in the order of filenames.
+	// Plain text files need converters, so they are imported on the calling thread after workers finish. Without converters they are reported as failed.
+	// Directories are replaced by the files they contain, sorted by name. Returns false if no file was imported.
+	static bool importFiles(ColorList *color_list, const std::vector<std::string> &filenames, Converters *converters, std::vector<std::string> *failed_filenames = nullptr);
 	static FileType getFileType(const char *filename);
 	static FileType getFileTypeByExtension(const char *extension);
 	static FileType getFileTypeByContent(const char *filename);
@@ -103,9 +121,11 @@ struct ImportExport
 	std::string m_filename;
 	ItemSize m_item_size;
 	Background m_background;
-	GlobalState *m_gs;
+	const dynv::Map *m_settings;
+	Serializer m_serializer;
 	bool m_include_color_names;
 	Error m_last_error;
+	std::function<bool(float)> m_progress_callback;
 };
 
 #endif /* GPICK_IMPORT_EXPORT_H_ */
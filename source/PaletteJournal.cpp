@@ -0,0 +1,595 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PaletteJournal.h"
+#include "FileFormat.h"
+#include "ColorList.h"
+#include "ColorObject.h"
+#include "common/MappedFile.h"
+#include "common/Hash.h"
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <boost/endian/conversion.hpp>
+#include <boost/filesystem.hpp>
+namespace {
+// Journal header: 16 byte magic, uint32 version and uint64 hash of snapshot file the journal applies to.
+// Each record: uint32 payload length, uint32 payload checksum and payload starting with record type.
+const char Magic[16] = "GPICK-JOURNAL";
+const uint32_t Version = 1;
+const size_t HeaderSize = sizeof(Magic) + sizeof(uint32_t) + sizeof(uint64_t);
+enum class RecordType : uint8_t {
+	insert = 1, // uint32 id, uint32 previous id or 0, uint8 visible, color, name
+	remove = 2, // uint32 id
+	change = 3, // uint32 id, uint8 visible, color, name
+	order = 4, // uint32 count, count * uint32 id
+};
+uint32_t checksum(const uint8_t *data, size_t size) {
+	uint32_t result = 0x811c9dc5u;
+	for (size_t i = 0; i < size; i++) {
+		result ^= data[i];
+		result *= 0x01000193u;
+	}
+	return result;
+}
+struct RecordWriter {
+	void begin(RecordType type) {
+		m_start = m_data.length();
+		write(uint32_t(0));
+		write(uint32_t(0));
+		write(static_cast<uint8_t>(type));
+	}
+	void end() {
+		size_t payload = m_start + sizeof(uint32_t) * 2;
+		uint32_t length = boost::endian::native_to_little<uint32_t>(static_cast<uint32_t>(m_data.length() - payload));
+		uint32_t sum = boost::endian::native_to_little<uint32_t>(checksum(reinterpret_cast<const uint8_t *>(m_data.data() + payload), m_data.length() - payload));
+		memcpy(&m_data[m_start], &length, sizeof(length));
+		memcpy(&m_data[m_start + sizeof(length)], &sum, sizeof(sum));
+	}
+	void write(uint8_t value) {
+		m_data.push_back(static_cast<char>(value));
+	}
+	void write(uint32_t value) {
+		value = boost::endian::native_to_little<uint32_t>(value);
+		m_data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	void write(const Color &color) {
+		for (int i = 0; i < 4; i++) {
+			uint32_t value;
+			memcpy(&value, &color.ma[i], sizeof(value));
+			write(value);
+		}
+	}
+	void write(const std::string &value) {
+		write(static_cast<uint32_t>(value.length()));
+		m_data.append(value);
+	}
+	const std::string &data() const {
+		return m_data;
+	}
+private:
+	std::string m_data;
+	size_t m_start;
+};
+struct RecordReader {
+	RecordReader(const uint8_t *data, size_t size):
+		m_data(data),
+		m_size(size),
+		m_offset(0) {
+	}
+	bool read(uint8_t &value) {
+		if (m_size - m_offset < 1)
+			return false;
+		value = m_data[m_offset++];
+		return true;
+	}
+	bool read(uint32_t &value) {
+		if (m_size - m_offset < sizeof(value))
+			return false;
+		memcpy(&value, m_data + m_offset, sizeof(value));
+		m_offset += sizeof(value);
+		value = boost::endian::little_to_native<uint32_t>(value);
+		return true;
+	}
+	bool read(uint64_t &value) {
+		if (m_size - m_offset < sizeof(value))
+			return false;
+		memcpy(&value, m_data + m_offset, sizeof(value));
+		m_offset += sizeof(value);
+		value = boost::endian::little_to_native<uint64_t>(value);
+		return true;
+	}
+	bool read(Color &color) {
+		for (int i = 0; i < 4; i++) {
+			uint32_t value;
+			if (!read(value))
+				return false;
+			memcpy(&color.ma[i], &value, sizeof(value));
+		}
+		return true;
+	}
+	bool read(std::string &value) {
+		uint32_t length;
+		if (!read(length) || m_size - m_offset < length)
+			return false;
+		value.assign(reinterpret_cast<const char *>(m_data + m_offset), length);
+		m_offset += length;
+		return true;
+	}
+	bool view(const uint8_t *&value, size_t length) {
+		if (m_size - m_offset < length)
+			return false;
+		value = m_data + m_offset;
+		m_offset += length;
+		return true;
+	}
+	bool end() const {
+		return m_offset == m_size;
+	}
+	size_t offset() const {
+		return m_offset;
+	}
+private:
+	const uint8_t *m_data;
+	size_t m_size, m_offset;
+};
+// Name and color are kept only as a hash, as color objects are changed in place
+struct Entry {
+	ColorObject *colorObject;
+	uint32_t id;
+	uint64_t hash;
+	bool visible;
+};
+uint64_t hashValues(const ColorObject &colorObject) {
+	auto &name = colorObject.getName();
+	auto &color = colorObject.getColor();
+	return common::hash(name.data(), name.length()) * 31 + common::hash(color.ma, sizeof(color.ma));
+}
+std::vector<ColorObject *> getSequence(ColorList *colorList) {
+	std::vector<ColorObject *> result;
+	color_list_get_palette_order(colorList, result);
+	return result;
+}
+bool renameFile(const std::string &from, const std::string &to) {
+	boost::system::error_code error;
+	boost::filesystem::rename(boost::filesystem::path(from), boost::filesystem::path(to), error);
+	if (error) {
+		std::cerr << "failed to rename \"" << from << "\": " << error.message() << std::endl;
+		return false;
+	}
+	return true;
+}
+}
+// Color objects with their journal ids during replay
+typedef std::list<std::pair<uint32_t, ColorObject *>> Sequence;
+// Journal ids are assigned sequentially, so they are used as vector indices
+struct SequenceIds {
+	SequenceIds():
+		m_count(0) {
+	}
+	void reserve(size_t count) {
+		m_items.reserve(count + 1);
+		m_present.reserve(count + 1);
+	}
+	bool has(uint32_t id) const {
+		return id < m_present.size() && m_present[id];
+	}
+	Sequence::iterator get(uint32_t id) const {
+		return m_items[id];
+	}
+	void set(uint32_t id, Sequence::iterator item) {
+		if (id >= m_items.size()) {
+			m_items.resize(id + 1);
+			m_present.resize(id + 1, false);
+		}
+		if (!m_present[id])
+			m_count++;
+		m_items[id] = item;
+		m_present[id] = true;
+	}
+	void erase(uint32_t id) {
+		m_present[id] = false;
+		m_count--;
+	}
+	size_t size() const {
+		return m_count;
+	}
+private:
+	std::vector<Sequence::iterator> m_items;
+	std::vector<bool> m_present;
+	size_t m_count;
+};
+struct PaletteJournal::Impl {
+	std::string m_snapshotFilename, m_journalFilename;
+	int m_compressionLevel;
+	uint64_t m_minimumCompactionSize, m_snapshotHash, m_snapshotSize, m_journalSize;
+	bool m_valid;
+	uint32_t m_nextId;
+	// Color list and its revision at the last load or save
+	const ColorList *m_colorList;
+	size_t m_revision;
+	// Last saved state in palette order, each entry holds a color object reference
+	std::vector<Entry> m_entries;
+	Impl(const std::string &snapshotFilename, const std::string &journalFilename):
+		m_snapshotFilename(snapshotFilename),
+		m_journalFilename(journalFilename),
+		m_compressionLevel(0),
+		m_minimumCompactionSize(64 * 1024),
+		m_snapshotHash(0),
+		m_snapshotSize(0),
+		m_journalSize(0),
+		m_valid(false),
+		m_nextId(1),
+		m_colorList(nullptr),
+		m_revision(0) {
+	}
+	~Impl() {
+		clear();
+	}
+	void clear() {
+		for (auto &entry: m_entries)
+			entry.colorObject->release();
+		m_entries.clear();
+		m_nextId = 1;
+		m_valid = false;
+	}
+	// Takes ownership of one reference
+	void track(ColorObject *colorObject, uint32_t id, bool visible) {
+		m_entries.push_back(Entry { colorObject, id, hashValues(*colorObject), visible });
+	}
+	bool readJournal(Sequence &sequence, SequenceIds &ids, uint32_t &nextId) {
+		common::MappedFile file(m_journalFilename.c_str());
+		if (!file.valid())
+			return false;
+		RecordReader reader(file.data(), file.size());
+		const uint8_t *magic;
+		uint32_t version;
+		uint64_t snapshotHash;
+		if (!reader.view(magic, sizeof(Magic)) || memcmp(magic, Magic, sizeof(Magic)) != 0 || !reader.read(version) || version != Version || !reader.read(snapshotHash) || snapshotHash != m_snapshotHash)
+			return false;
+		m_journalSize = reader.offset();
+		while (!reader.end()) {
+			uint32_t length, sum;
+			const uint8_t *payload;
+			if (!reader.read(length) || !reader.read(sum) || !reader.view(payload, length) || checksum(payload, length) != sum)
+				return false; // incomplete record at the end of journal, written records are kept
+			if (!applyRecord(RecordReader(payload, length), sequence, ids, nextId))
+				return false;
+			m_journalSize = reader.offset();
+		}
+		return true;
+	}
+	bool applyRecord(RecordReader reader, Sequence &sequence, SequenceIds &ids, uint32_t &nextId) {
+		uint8_t type;
+		if (!reader.read(type))
+			return false;
+		switch (static_cast<RecordType>(type)) {
+		case RecordType::insert: {
+			uint32_t id, previousId;
+			uint8_t visible;
+			Color color;
+			std::string name;
+			if (!reader.read(id) || !reader.read(previousId) || !reader.read(visible) || !reader.read(color) || !reader.read(name))
+				return false;
+			if (id != nextId)
+				return false;
+			auto position = sequence.begin();
+			if (previousId != 0) {
+				if (!ids.has(previousId))
+					return false;
+				position = std::next(ids.get(previousId));
+			}
+			auto colorObject = new ColorObject(name, color);
+			colorObject->setVisible(visible != 0);
+			ids.set(id, sequence.insert(position, std::make_pair(id, colorObject)));
+			nextId++;
+		} break;
+		case RecordType::remove: {
+			uint32_t id;
+			if (!reader.read(id))
+				return false;
+			if (!ids.has(id))
+				return false;
+			auto item = ids.get(id);
+			item->second->release();
+			sequence.erase(item);
+			ids.erase(id);
+		} break;
+		case RecordType::change: {
+			uint32_t id;
+			uint8_t visible;
+			Color color;
+			std::string name;
+			if (!reader.read(id) || !reader.read(visible) || !reader.read(color) || !reader.read(name))
+				return false;
+			if (!ids.has(id))
+				return false;
+			auto colorObject = ids.get(id)->second;
+			colorObject->setName(name);
+			colorObject->setColor(color);
+			colorObject->setVisible(visible != 0);
+		} break;
+		case RecordType::order: {
+			uint32_t count;
+			if (!reader.read(count) || count != ids.size())
+				return false;
+			Sequence reordered;
+			std::unordered_set<uint32_t> seen;
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t id;
+				if (!reader.read(id) || seen.count(id) != 0)
+					return false;
+				if (!ids.has(id))
+					return false;
+				seen.insert(id);
+				reordered.splice(reordered.end(), sequence, ids.get(id));
+			}
+			sequence.splice(sequence.end(), reordered);
+		} break;
+		default:
+			return false;
+		}
+		return reader.end();
+	}
+	bool load(ColorList *colorList) {
+		clear();
+		m_snapshotHash = 0;
+		m_snapshotSize = 0;
+		m_journalSize = 0;
+		ColorList *snapshot = color_list_new();
+		bool loaded = palette_file_load(m_snapshotFilename.c_str(), snapshot) == 0;
+		Sequence sequence;
+		SequenceIds ids;
+		uint32_t nextId = 1;
+		if (loaded) {
+			ids.reserve(snapshot->colors.size());
+			for (auto colorObject: snapshot->colors) {
+				ids.set(nextId, sequence.insert(sequence.end(), std::make_pair(nextId, colorObject->reference())));
+				nextId++;
+			}
+			color_list_destroy(snapshot);
+			m_valid = hashSnapshot() && readJournal(sequence, ids, nextId);
+		} else {
+			color_list_destroy(snapshot);
+		}
+		m_entries.reserve(sequence.size());
+		for (auto &item: sequence) {
+			auto colorObject = item.second;
+			color_list_add_color_object(colorList, colorObject, colorObject->isVisible());
+			track(colorObject, item.first, colorObject->isVisible());
+		}
+		m_nextId = nextId;
+		saved(colorList);
+		return loaded;
+	}
+	void saved(const ColorList *colorList) {
+		m_colorList = colorList;
+		m_revision = colorList->revision;
+	}
+	bool isSaved(const ColorList *colorList) const {
+		return m_valid && colorList == m_colorList && colorList->revision == m_revision;
+	}
+	bool hashSnapshot() {
+		common::MappedFile file(m_snapshotFilename.c_str());
+		if (!file.valid())
+			return false;
+		m_snapshotHash = common::hash(file.data(), file.size());
+		m_snapshotSize = file.size();
+		return true;
+	}
+	// Journal could have been replaced by another instance since it was last written
+	bool journalMatches() {
+		if (!m_valid)
+			return false;
+		std::ifstream file(m_journalFilename, std::ios::binary | std::ios::ate);
+		if (!file.is_open() || static_cast<uint64_t>(file.tellg()) != m_journalSize)
+			return false;
+		uint8_t header[HeaderSize];
+		file.seekg(0);
+		file.read(reinterpret_cast<char *>(header), sizeof(header));
+		if (!file.good())
+			return false;
+		RecordReader reader(header, sizeof(header));
+		const uint8_t *magic;
+		uint32_t version;
+		uint64_t snapshotHash;
+		return reader.view(magic, sizeof(Magic)) && memcmp(magic, Magic, sizeof(Magic)) == 0 && reader.read(version) && version == Version && reader.read(snapshotHash) && snapshotHash == m_snapshotHash;
+	}
+	void diff(const std::vector<ColorObject *> &sequence, RecordWriter &writer) {
+		// Usually colors are only changed or appended, so unchanged prefix is compared without building maps
+		size_t common = 0;
+		while (common < m_entries.size() && common < sequence.size() && m_entries[common].colorObject == sequence[common])
+			common++;
+		std::unordered_map<ColorObject *, Entry> moved;
+		if (common < m_entries.size()) {
+			std::unordered_set<ColorObject *> current(sequence.begin() + common, sequence.end());
+			std::vector<uint32_t> kept, known;
+			for (size_t i = common; i < m_entries.size(); i++) {
+				auto &entry = m_entries[i];
+				if (current.count(entry.colorObject) == 0) {
+					writer.begin(RecordType::remove);
+					writer.write(entry.id);
+					writer.end();
+					entry.colorObject->release();
+				} else {
+					kept.push_back(entry.id);
+					moved.emplace(entry.colorObject, entry);
+				}
+			}
+			for (size_t i = common; i < sequence.size(); i++) {
+				auto entry = moved.find(sequence[i]);
+				if (entry != moved.end())
+					known.push_back(entry->second.id);
+			}
+			if (kept != known) {
+				writer.begin(RecordType::order);
+				writer.write(static_cast<uint32_t>(common + known.size()));
+				for (size_t i = 0; i < common; i++)
+					writer.write(m_entries[i].id);
+				for (auto id: known)
+					writer.write(id);
+				writer.end();
+			}
+			m_entries.resize(common);
+		}
+		m_entries.reserve(sequence.size());
+		uint32_t previousId = 0;
+		for (size_t i = 0; i < sequence.size(); i++) {
+			auto colorObject = sequence[i];
+			bool visible = colorObject->isPositionSet();
+			if (i >= common) {
+				auto entry = moved.find(colorObject);
+				if (entry == moved.end()) {
+					m_entries.push_back(Entry { colorObject->reference(), m_nextId++, hashValues(*colorObject), visible });
+					auto &added = m_entries.back();
+					writer.begin(RecordType::insert);
+					writer.write(added.id);
+					writer.write(previousId);
+					writer.write(static_cast<uint8_t>(added.visible));
+					writer.write(colorObject->getColor());
+					writer.write(colorObject->getName());
+					writer.end();
+					previousId = added.id;
+					continue;
+				}
+				m_entries.push_back(entry->second);
+			}
+			auto &entry = m_entries[i];
+			auto hash = hashValues(*colorObject);
+			if (entry.visible != visible || entry.hash != hash) {
+				entry.visible = visible;
+				entry.hash = hash;
+				writer.begin(RecordType::change);
+				writer.write(entry.id);
+				writer.write(static_cast<uint8_t>(entry.visible));
+				writer.write(colorObject->getColor());
+				writer.write(colorObject->getName());
+				writer.end();
+			}
+			previousId = entry.id;
+		}
+	}
+	bool save(ColorList *colorList) {
+		if (!journalMatches())
+			return compact(colorList);
+		// Palette order is only walked when colors were added, removed or changed since the last save
+		if (isSaved(colorList))
+			return true;
+		auto sequence = getSequence(colorList);
+		RecordWriter writer;
+		diff(sequence, writer);
+		saved(colorList);
+		if (writer.data().empty())
+			return true;
+		std::ofstream file(m_journalFilename, std::ios::binary | std::ios::app);
+		if (file.is_open()) {
+			file.write(writer.data().data(), writer.data().length());
+			file.close();
+		}
+		if (!file.good()) {
+			std::cerr << "failed to append palette journal \"" << m_journalFilename << "\"" << std::endl;
+			m_valid = false;
+			return false;
+		}
+		m_journalSize += writer.data().length();
+		if (m_journalSize > std::max(m_snapshotSize, m_minimumCompactionSize))
+			return compact(colorList);
+		return true;
+	}
+	bool compact(ColorList *colorList) {
+		auto sequence = getSequence(colorList);
+		clear();
+		for (auto colorObject: sequence) {
+			track(colorObject->reference(), m_nextId++, colorObject->isPositionSet());
+		}
+		auto snapshotTmp = m_snapshotFilename + ".tmp";
+		{
+			std::ofstream file(snapshotTmp, std::ios::binary);
+			if (!file.is_open())
+				return false;
+			// Releases without journal support would ignore the journal anyway, so snapshot does not need color_list chunks
+			PaletteFileWriter writer(file, sequence.size(), m_compressionLevel, false);
+			size_t position = 0;
+			for (auto colorObject: sequence) {
+				if (!writer.add(*colorObject, colorObject->isPositionSet() ? position++ : ~(size_t)0))
+					return false;
+			}
+			if (!writer.finish())
+				return false;
+			file.close();
+			if (!file.good())
+				return false;
+		}
+		if (!renameFile(snapshotTmp, m_snapshotFilename) || !hashSnapshot())
+			return false;
+		auto journalTmp = m_journalFilename + ".tmp";
+		{
+			std::ofstream file(journalTmp, std::ios::binary);
+			if (!file.is_open())
+				return false;
+			file.write(Magic, sizeof(Magic));
+			uint32_t version = boost::endian::native_to_little<uint32_t>(Version);
+			uint64_t snapshotHash = boost::endian::native_to_little<uint64_t>(m_snapshotHash);
+			file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+			file.write(reinterpret_cast<const char *>(&snapshotHash), sizeof(snapshotHash));
+			file.close();
+			if (!file.good())
+				return false;
+		}
+		if (!renameFile(journalTmp, m_journalFilename))
+			return false;
+		m_journalSize = HeaderSize;
+		m_valid = true;
+		saved(colorList);
+		return true;
+	}
+};
+PaletteJournal::PaletteJournal(const std::string &snapshotFilename, const std::string &journalFilename) {
+	m_impl = std::make_unique<Impl>(snapshotFilename, journalFilename);
+}
+PaletteJournal::~PaletteJournal() {
+}
+bool PaletteJournal::load(ColorList *colorList) {
+	return m_impl->load(colorList);
+}
+bool PaletteJournal::save(ColorList *colorList) {
+	return m_impl->save(colorList);
+}
+bool PaletteJournal::compact(ColorList *colorList) {
+	return m_impl->compact(colorList);
+}
+bool PaletteJournal::isSaved(const ColorList *colorList) const {
+	return m_impl->isSaved(colorList);
+}
+void PaletteJournal::setCompressionLevel(int compressionLevel) {
+	m_impl->m_compressionLevel = compressionLevel;
+}
+void PaletteJournal::setMinimumCompactionSize(uint64_t size) {
+	m_impl->m_minimumCompactionSize = size;
+}
+uint64_t PaletteJournal::journalSize() const {
+	return m_impl->m_journalSize;
+}
+uint64_t PaletteJournal::snapshotSize() const {
+	return m_impl->m_snapshotSize;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_PALETTE_JOURNAL_H_
+#define GPICK_PALETTE_JOURNAL_H_
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+struct ColorList;
+// Stores palette as a GPA snapshot and an append-only journal of insertions, removals, changes and reordering made after the snapshot was written.
+// Saving appends only the differences since the last load or save. Journal is compacted into a new snapshot when it grows larger than the snapshot.
+struct PaletteJournal {
+	PaletteJournal(const std::string &snapshotFilename, const std::string &journalFilename);
+	~PaletteJournal();
+	// Loads snapshot and replays journal on top of it. Colors are added to the list in palette order.
+	bool load(ColorList *colorList);
+	// Appends differences between color list and the last loaded or saved state, compacts journal if needed.
+	// Nothing is compared if color list revision has not changed since the last load or save.
+	bool save(ColorList *colorList);
+	// Returns true if color list revision has not changed since it was last loaded or saved
+	bool isSaved(const ColorList *colorList) const;
+	// Writes full snapshot and starts an empty journal
+	bool compact(ColorList *colorList);
+	void setCompressionLevel(int compressionLevel);
+	// Journal is not compacted until it is larger than this size
+	void setMinimumCompactionSize(uint64_t size);
+	uint64_t journalSize() const;
+	uint64_t snapshotSize() const;
+private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+};
+
+#endif /* GPICK_PALETTE_JOURNAL_H_ */
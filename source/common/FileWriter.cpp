@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FileWriter.h"
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+namespace common {
+#ifdef _WIN32
+FileWriter::FileWriter(const char *filename, size_t bufferSize):
+	m_buffer(bufferSize > 64 ? bufferSize : 64),
+	m_used(0),
+	m_good(false),
+	m_uppercase(false),
+	m_file(INVALID_HANDLE_VALUE) {
+	int length = MultiByteToWideChar(CP_UTF8, 0, filename, -1, nullptr, 0);
+	if (length <= 0)
+		return;
+	std::vector<wchar_t> wideFilename(length);
+	MultiByteToWideChar(CP_UTF8, 0, filename, -1, wideFilename.data(), length);
+	m_file = CreateFileW(wideFilename.data(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	m_good = m_file != INVALID_HANDLE_VALUE;
+}
+bool FileWriter::isOpen() const {
+	return m_file != INVALID_HANDLE_VALUE;
+}
+void FileWriter::writeFile(const char *data, size_t length) {
+	while (length > 0) {
+		DWORD written = 0;
+		DWORD chunk = length > 0x40000000 ? 0x40000000 : static_cast<DWORD>(length);
+		if (!WriteFile(m_file, data, chunk, &written, nullptr) || written == 0) {
+			m_good = false;
+			return;
+		}
+		data += written;
+		length -= written;
+	}
+}
+void FileWriter::closeFile() {
+	if (m_file == INVALID_HANDLE_VALUE)
+		return;
+	CloseHandle(m_file);
+	m_file = INVALID_HANDLE_VALUE;
+}
+#else
+FileWriter::FileWriter(const char *filename, size_t bufferSize):
+	m_buffer(bufferSize > 64 ? bufferSize : 64),
+	m_used(0),
+	m_good(false),
+	m_uppercase(false) {
+	m_file = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	m_good = m_file >= 0;
+}
+bool FileWriter::isOpen() const {
+	return m_file >= 0;
+}
+void FileWriter::writeFile(const char *data, size_t length) {
+	while (length > 0) {
+		ssize_t written = ::write(m_file, data, length);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0) {
+			m_good = false;
+			return;
+		}
+		data += written;
+		length -= written;
+	}
+}
+void FileWriter::closeFile() {
+	if (m_file < 0)
+		return;
+	if (::close(m_file) != 0)
+		m_good = false;
+	m_file = -1;
+}
+#endif
+FileWriter::~FileWriter() {
+	close();
+}
+bool FileWriter::good() const {
+	return m_good;
+}
+bool FileWriter::flush() {
+	if (m_good && m_used > 0)
+		writeFile(m_buffer.data(), m_used);
+	m_used = 0;
+	return m_good;
+}
+bool FileWriter::close() {
+	if (!isOpen())
+		return m_good;
+	flush();
+	closeFile();
+	return m_good;
+}
+char *FileWriter::reserve(size_t length) {
+	if (m_used + length > m_buffer.size())
+		flush();
+	char *result = m_buffer.data() + m_used;
+	m_used += length;
+	return result;
+}
+FileWriter &FileWriter::write(const char *data, size_t length) {
+	if (length >= m_buffer.size()) {
+		// Large blocks go straight to the file
+		flush();
+		if (m_good)
+			writeFile(data, length);
+		return *this;
+	}
+	std::memcpy(reserve(length), data, length);
+	return *this;
+}
+FileWriter &FileWriter::operator<<(const char *value) {
+	return write(value, std::strlen(value));
+}
+FileWriter &FileWriter::operator<<(const std::string &value) {
+	return write(value.data(), value.length());
+}
+FileWriter &FileWriter::operator<<(char value) {
+	*reserve(1) = value;
+	return *this;
+}
+FileWriter &FileWriter::operator<<(int32_t value) {
+	char digits[12];
+	char *end = digits + sizeof(digits), *start = end;
+	uint32_t magnitude = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+	do {
+		*--start = static_cast<char>('0' + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+	if (value < 0)
+		*--start = '-';
+	return write(start, end - start);
+}
+FileWriter &FileWriter::writeHex(uint8_t value) {
+	const char *digits = m_uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+	char *target = reserve(2);
+	target[0] = digits[value >> 4];
+	target[1] = digits[value & 0xf];
+	return *this;
+}
+FileWriter &FileWriter::uppercase(bool enable) {
+	m_uppercase = enable;
+	return *this;
+}
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_COMMON_FILE_WRITER_H_
+#define GPICK_COMMON_FILE_WRITER_H_
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+namespace common {
+// Writes a new file through a large reusable buffer. Numbers are formatted directly into the buffer, without iostreams or temporary strings.
+struct FileWriter {
+	FileWriter(const char *filename, size_t bufferSize = 256 * 1024);
+	FileWriter(const FileWriter &) = delete;
+	FileWriter &operator=(const FileWriter &) = delete;
+	~FileWriter();
+	bool isOpen() const;
+	// False after the file could not be opened or any write failed
+	bool good() const;
+	FileWriter &write(const char *data, size_t length);
+	FileWriter &operator<<(const char *value);
+	FileWriter &operator<<(const std::string &value);
+	FileWriter &operator<<(char value);
+	FileWriter &operator<<(int32_t value);
+	// Writes value as two hexadecimal digits
+	FileWriter &writeHex(uint8_t value);
+	// Selects digit case used by writeHex
+	FileWriter &uppercase(bool enable);
+	bool flush();
+	// Flushes buffer and closes file. Returns false if any write failed.
+	bool close();
+private:
+	std::vector<char> m_buffer;
+	size_t m_used;
+	bool m_good, m_uppercase;
+#ifdef _WIN32
+	void *m_file;
+#else
+	int m_file;
+#endif
+	char *reserve(size_t length);
+	void writeFile(const char *data, size_t length);
+	void closeFile();
+};
+}
+#endif /* GPICK_COMMON_FILE_WRITER_H_ */
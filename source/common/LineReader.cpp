@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LineReader.h"
+#include <cstring>
+namespace common {
+LineReader::LineReader(std::istream &stream, size_t chunkSize):
+	m_stream(stream),
+	m_chunkSize(chunkSize > 0 ? chunkSize : 1),
+	m_start(0),
+	m_end(0),
+	m_searchFrom(0),
+	m_position(0),
+	m_eof(false),
+	m_failed(false) {
+}
+bool LineReader::next(char *&line, size_t &length) {
+	for (;;) {
+		if (m_searchFrom < m_end) {
+			auto newline = reinterpret_cast<char *>(std::memchr(&m_buffer[m_searchFrom], '\n', m_end - m_searchFrom));
+			if (newline) {
+				size_t lineLength = newline - &m_buffer[m_start];
+				returnLine(line, length, lineLength, lineLength + 1);
+				return true;
+			}
+			m_searchFrom = m_end;
+		}
+		if (m_eof) {
+			if (m_start == m_end)
+				return false;
+			// Last line without line ending. Buffer always has one spare byte for the terminator.
+			size_t lineLength = m_end - m_start;
+			returnLine(line, length, lineLength, lineLength);
+			return true;
+		}
+		fill();
+	}
+}
+void LineReader::returnLine(char *&line, size_t &length, size_t lineLength, size_t consumed) {
+	line = &m_buffer[m_start];
+	if (lineLength > 0 && line[lineLength - 1] == '\r')
+		lineLength--;
+	line[lineLength] = 0;
+	length = lineLength;
+	m_start += consumed;
+	m_searchFrom = m_start;
+	m_position += consumed;
+}
+void LineReader::fill() {
+	size_t remaining = m_end - m_start;
+	if (m_start > 0 && remaining > 0)
+		std::memmove(&m_buffer[0], &m_buffer[m_start], remaining);
+	m_searchFrom -= m_start;
+	m_start = 0;
+	m_end = remaining;
+	if (m_buffer.size() < remaining + m_chunkSize + 1)
+		m_buffer.resize(remaining + m_chunkSize + 1);
+	m_stream.read(&m_buffer[m_end], m_chunkSize);
+	size_t bytes = static_cast<size_t>(m_stream.gcount());
+	m_end += bytes;
+	if (m_stream.eof()) {
+		m_eof = true;
+	} else if (!m_stream.good() || bytes == 0) {
+		m_failed = true;
+		m_eof = true;
+	}
+}
+bool LineReader::failed() const {
+	return m_failed;
+}
+uint64_t LineReader::position() const {
+	return m_position;
+}
+}
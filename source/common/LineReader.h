@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_COMMON_LINE_READER_H_
+#define GPICK_COMMON_LINE_READER_H_
+#include <istream>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+namespace common {
+// Reads text from a stream in fixed size chunks and returns lines in place, without copying each line
+struct LineReader {
+	LineReader(std::istream &stream, size_t chunkSize = 1024 * 1024);
+	LineReader(const LineReader &) = delete;
+	LineReader &operator=(const LineReader &) = delete;
+	// Returns line without line ending. Line is null terminated, can be modified, and stays valid until the next call.
+	bool next(char *&line, size_t &length);
+	// True when reading stopped because of a stream error instead of the end of stream
+	bool failed() const;
+	// Number of bytes consumed by returned lines
+	uint64_t position() const;
+private:
+	std::istream &m_stream;
+	std::vector<char> m_buffer;
+	size_t m_chunkSize, m_start, m_end, m_searchFrom;
+	uint64_t m_position;
+	bool m_eof, m_failed;
+	void fill();
+	void returnLine(char *&line, size_t &length, size_t lineLength, size_t consumed);
+};
+}
+#endif /* GPICK_COMMON_LINE_READER_H_ */
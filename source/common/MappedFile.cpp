@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <vector>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+namespace common {
+#ifdef _WIN32
+MappedFile::MappedFile(const char *filename):
+	m_data(nullptr),
+	m_size(0),
+	m_valid(false),
+	m_file(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr) {
+	int length = MultiByteToWideChar(CP_UTF8, 0, filename, -1, nullptr, 0);
+	if (length <= 0)
+		return;
+	std::vector<wchar_t> wideFilename(length);
+	MultiByteToWideChar(CP_UTF8, 0, filename, -1, wideFilename.data(), length);
+	m_file = CreateFileW(wideFilename.data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || static_cast<uint64_t>(size.QuadPart) > SIZE_MAX)
+		return;
+	m_size = static_cast<size_t>(size.QuadPart);
+	if (m_size == 0) {
+		m_valid = true;
+		return;
+	}
+	m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+		return;
+	m_data = reinterpret_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	m_valid = m_data != nullptr;
+}
+MappedFile::~MappedFile() {
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+}
+#else
+MappedFile::MappedFile(const char *filename):
+	m_data(nullptr),
+	m_size(0),
+	m_valid(false) {
+	int file = open(filename, O_RDONLY);
+	if (file < 0)
+		return;
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+		close(file);
+		return;
+	}
+	m_size = static_cast<size_t>(fileStat.st_size);
+	if (m_size == 0) {
+		close(file);
+		m_valid = true;
+		return;
+	}
+	void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+		return;
+	m_data = reinterpret_cast<const uint8_t *>(data);
+	m_valid = true;
+}
+MappedFile::~MappedFile() {
+	if (m_data)
+		munmap(const_cast<uint8_t *>(m_data), m_size);
+}
+#endif
+bool MappedFile::valid() const {
+	return m_valid;
+}
+const uint8_t *MappedFile::data() const {
+	return m_data;
+}
+size_t MappedFile::size() const {
+	return m_size;
+}
+}
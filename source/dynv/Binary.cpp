@@ -20,6 +20,8 @@
 #include "Map.h"
 #include "Types.h"
 #include "Variable.h"
+#include <memory>
+#include <algorithm>
 namespace dynv {
 namespace binary {
 using ValueType = types::ValueType;
@@ -125,5 +127,138 @@ bool deserialize(std::istream &stream, Map &map, const std::unordered_map<uint8_
 	}
 	return true;
 }
+// Tree format: uint32 variable count, then for each variable uint8 value type, uint8 list flag, name and value.
+// Lists start with uint32 item count. Maps are written recursively in the same format.
+struct TreeSerializeVisitor: public boost::static_visitor<bool> {
+	TreeSerializeVisitor(std::ostream &stream, const std::string &name):
+		stream(stream),
+		name(name) {
+	}
+	template<typename T>
+	bool operator()(const T &value) const {
+		return writeHeader(types::typeHandler<T>().type, false) && writeValue(value);
+	}
+	template<typename T>
+	bool operator()(const std::vector<T> &values) const {
+		using namespace types::binary;
+		if (!writeHeader(types::typeHandler<T>().type, true) || !write(stream, static_cast<uint32_t>(values.size())))
+			return false;
+		for (const auto &value: values) {
+			if (!writeValue(static_cast<const T &>(value)))
+				return false;
+		}
+		return true;
+	}
+	bool writeHeader(ValueType type, bool list) const {
+		using namespace types::binary;
+		return write(stream, static_cast<uint8_t>(type)) && write(stream, static_cast<uint8_t>(list ? 1 : 0)) && write(stream, name);
+	}
+	template<typename T>
+	bool writeValue(const T &value) const {
+		using namespace types::binary;
+		return write(stream, value);
+	}
+	bool writeValue(const Ref &value) const {
+		using namespace types::binary;
+		if (!value)
+			return write(stream, static_cast<uint32_t>(0));
+		return serializeTree(stream, *value);
+	}
+	std::ostream &stream;
+	const std::string &name;
+};
+bool serializeTree(std::ostream &stream, const Map &map) {
+	using namespace types::binary;
+	if (!write(stream, static_cast<uint32_t>(map.size())))
+		return false;
+	return map.visit([&stream](const Variable &value) -> bool {
+		return boost::apply_visitor(TreeSerializeVisitor(stream, value.name()), value.data());
+	});
+}
+// Limits recursion when reading broken files
+const int MaxTreeDepth = 64;
+static bool deserializeTree(std::istream &stream, Map &map, int depth);
+template<typename T>
+static bool readValue(std::istream &stream, T &value, int) {
+	using namespace types::binary;
+	value = read<T>(stream);
+	return stream.good();
+}
+static bool readValue(std::istream &stream, bool &value, int) {
+	using namespace types::binary;
+	value = read<uint8_t>(stream) != 0;
+	return stream.good();
+}
+static bool readValue(std::istream &stream, Ref &value, int depth) {
+	value = Map::create();
+	return deserializeTree(stream, *value, depth + 1);
+}
+template<typename T>
+static std::unique_ptr<Variable> readVariable(std::istream &stream, const std::string &name, bool list, int depth) {
+	using namespace types::binary;
+	if (!list) {
+		T value;
+		if (!readValue(stream, value, depth))
+			return std::unique_ptr<Variable>();
+		return std::make_unique<Variable>(name, value);
+	}
+	uint32_t count = read<uint32_t>(stream);
+	if (!stream.good())
+		return std::unique_ptr<Variable>();
+	std::vector<T> values;
+	values.reserve(std::min<uint32_t>(count, 1024));
+	for (uint32_t i = 0; i < count; i++) {
+		T value;
+		if (!readValue(stream, value, depth))
+			return std::unique_ptr<Variable>();
+		values.push_back(std::move(value));
+	}
+	return std::make_unique<Variable>(name, values);
+}
+static bool deserializeTree(std::istream &stream, Map &map, int depth) {
+	using namespace types::binary;
+	if (depth > MaxTreeDepth)
+		return false;
+	uint32_t count = read<uint32_t>(stream);
+	if (!stream.good())
+		return false;
+	for (uint32_t i = 0; i < count; i++) {
+		auto type = static_cast<ValueType>(read<uint8_t>(stream));
+		bool list = read<uint8_t>(stream) != 0;
+		auto name = read<std::string>(stream);
+		if (!stream.good())
+			return false;
+		std::unique_ptr<Variable> variable;
+		switch (type) {
+		case ValueType::basicBool:
+			variable = readVariable<bool>(stream, name, list, depth);
+			break;
+		case ValueType::basicFloat:
+			variable = readVariable<float>(stream, name, list, depth);
+			break;
+		case ValueType::basicInt32:
+			variable = readVariable<int32_t>(stream, name, list, depth);
+			break;
+		case ValueType::string:
+			variable = readVariable<std::string>(stream, name, list, depth);
+			break;
+		case ValueType::color:
+			variable = readVariable<Color>(stream, name, list, depth);
+			break;
+		case ValueType::map:
+			variable = readVariable<Ref>(stream, name, list, depth);
+			break;
+		case ValueType::unknown:
+			return false;
+		}
+		if (!variable)
+			return false;
+		map.set(std::move(variable));
+	}
+	return true;
+}
+bool deserializeTree(std::istream &stream, Map &map) {
+	return deserializeTree(stream, map, 0);
+}
 }
 }
@@ -27,6 +27,9 @@ struct Map;
 namespace binary {
 bool serialize(std::ostream &stream, const Map &map, const std::unordered_map<types::ValueType, uint8_t> &typeMap, bool firstLevel = true);
 bool deserialize(std::istream &stream, Map &map, const std::unordered_map<uint8_t, types::ValueType> &typeMap);
+// Self-describing format containing nested maps and lists
+bool serializeTree(std::ostream &stream, const Map &map);
+bool deserializeTree(std::istream &stream, Map &map);
 }
 }
 #endif /* GPICK_DYNV_BINARY_H_ */
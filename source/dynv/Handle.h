@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_DYNV_HANDLE_H_
+#define GPICK_DYNV_HANDLE_H_
+#include "Map.h"
+#include "Variable.h"
+#include <string>
+#include <cstdint>
+namespace dynv {
+// Typed reference to a value in a map. Path is resolved once and resolved again only when structure revision of a map on the path changes, so reading a value does not split path or compare strings.
+template<typename T>
+struct Handle {
+	Handle():
+		m_variable(nullptr),
+		m_resolved(false) {
+	}
+	Handle(const Ref &map, const std::string &path, const T &defaultValue = T()):
+		m_map(map),
+		m_path(path),
+		m_defaultValue(defaultValue),
+		m_variable(nullptr),
+		m_resolved(false) {
+	}
+	Handle(const Handle &) = delete;
+	Handle &operator=(const Handle &) = delete;
+	void bind(const Ref &map, const std::string &path, const T &defaultValue = T()) {
+		m_map = map;
+		m_path = path;
+		m_defaultValue = defaultValue;
+		m_resolved = false;
+	}
+	// Returns default value if value does not exist or has a different type
+	const T &get() const {
+		auto variable = resolve();
+		if (!variable)
+			return m_defaultValue;
+		auto value = boost::get<T>(&variable->data());
+		return value ? *value : m_defaultValue;
+	}
+	const T &operator()() const {
+		return get();
+	}
+	Handle &set(const T &value) {
+		if (m_map)
+			m_map->set(m_path, value);
+		return *this;
+	}
+	bool exists() const {
+		return resolve() != nullptr;
+	}
+private:
+	Ref m_map;
+	std::string m_path;
+	T m_defaultValue;
+	mutable const Variable *m_variable;
+	mutable Map::PathRevisions m_maps;
+	mutable bool m_resolved;
+	// Maps are checked starting from the root. While a map has not changed, the next map on the path is still owned by it, so it is safe to access.
+	bool pathChanged() const {
+		for (const auto &map: m_maps) {
+			if (map.first->structureRevision() != map.second)
+				return true;
+		}
+		return false;
+	}
+	const Variable *resolve() const {
+		if (!m_map)
+			return nullptr;
+		if (!m_resolved || pathChanged()) {
+			m_maps.clear();
+			m_variable = m_map->find(m_path, m_maps);
+			m_resolved = true;
+		}
+		return m_variable;
+	}
+};
+}
+#endif /* GPICK_DYNV_HANDLE_H_ */
@@ -25,7 +25,11 @@
 #include <queue>
 #include <iostream>
 #include <type_traits>
+#include <atomic>
+#include <algorithm>
 namespace dynv {
+// Shared by all maps, so that change revisions of different maps can be compared
+static std::atomic<uint64_t> changeClock(0);
 template<typename T, typename std::enable_if_t<!std::is_reference<T>::value, int> = 0>
 auto get(const Map &map, const std::string &name, T defaultValue) {
 	bool valid;
@@ -125,19 +129,24 @@ Ref Map::getMap(const std::string &name) {
 Ref Map::getOrCreateMap(const std::string &name) {
 	bool valid;
 	std::string fieldName;
-	auto &values = valuesForPath(name, valid, fieldName, true);
+	auto map = mapForPath(name, valid, fieldName, true);
 	if (!valid)
 		return Ref();
+	auto &values = map->m_values;
 	auto i = values.find(fieldName);
 	if (i == values.end()) {
 		Ref result;
 		values.emplace(new Variable(fieldName, (result = create())));
+		map->changed();
+		map->structureChanged();
 		return result;
 	}
 	auto &data = (*i)->data();
 	if (data.type() != typeid(Ref)) {
 		Ref result;
 		(*i)->assign((result = create()));
+		map->changed();
+		map->structureChanged();
 		return result;
 	}
 	return boost::get<Ref &>(data);
@@ -192,7 +201,7 @@ struct IsMap: public boost::static_visitor<bool> {
 		return true;
 	}
 };
-const Map::Set &Map::valuesForPath(const std::string &path, bool &valid, std::string &name) const {
+const Map::Values &Map::valuesForPath(const std::string &path, bool &valid, std::string &name) const {
 	size_t position = path.find('.');
 	if (position == std::string::npos) {
 		name = path;
@@ -243,187 +252,225 @@ const Map::Set &Map::valuesForPath(const std::string &path, bool &valid, std::st
 		}
 	}
 }
-Map::Set &Map::valuesForPath(const std::string &path, bool &valid, std::string &name, bool createMissing) {
-	size_t position = path.find('.');
-	if (position == std::string::npos) {
-		name = path;
-		valid = true;
-		return m_values;
-	}
-	size_t from = 0;
-	auto pathPart = path.substr(from, position);
-	Ref next;
-	auto i = m_values.find(pathPart);
-	if (i == m_values.end()) {
-		if (!createMissing) {
-			valid = false;
-			return m_values;
-		}
-		m_values.emplace(new Variable(pathPart, (next = create())));
-	} else {
-		if (!boost::apply_visitor(IsMap(), (*i)->data())) {
-			valid = false;
-			return m_values;
-		}
-		next = boost::get<Ref &>((*i)->data());
-		if (!next) {
-			if (!createMissing) {
+Map *Map::mapForPath(const std::string &path, bool &valid, std::string &name, bool createMissing) {
+	Map *map = this;
+	size_t from = 0, position;
+	while ((position = path.find('.', from)) != std::string::npos) {
+		auto pathPart = path.substr(from, position - from);
+		auto i = map->m_values.find(pathPart);
+		Map *next = nullptr;
+		if (i != map->m_values.end()) {
+			if (!boost::apply_visitor(IsMap(), (*i)->data())) {
 				valid = false;
-				return m_values;
+				return this;
 			}
-			m_values.emplace(new Variable(pathPart, (next = create())));
-		}
-	}
-	for (;;) {
-		from = position + 1;
-		position = path.find('.', from);
-		if (position == std::string::npos) {
-			name = path.substr(from);
-			valid = true;
-			return next->m_values;
+			auto &value = boost::get<Ref &>((*i)->data());
+			if (value)
+				next = &*value;
 		}
-		pathPart = path.substr(from, position - from);
-		i = next->m_values.find(pathPart);
-		if (i == next->m_values.end()) {
+		if (!next) {
 			if (!createMissing) {
 				valid = false;
-				return m_values;
-			}
-			next->m_values.emplace(new Variable(pathPart, (next = create())));
-		} else {
-			if (!boost::apply_visitor(IsMap(), (*i)->data())) {
-				valid = false;
-				return m_values;
-			}
-			next = boost::get<Ref &>((*i)->data());
-			if (!next) {
-				if (!createMissing) {
-					valid = false;
-					return m_values;
-				}
-				next->m_values.emplace(new Variable(pathPart, (next = create())));
+				return this;
 			}
+			auto child = create();
+			if (i == map->m_values.end())
+				map->m_values.emplace(new Variable(pathPart, child));
+			else
+				(*i)->assign(child);
+			map->changed();
+			map->structureChanged();
+			next = &*child;
 		}
+		map = next;
+		from = position + 1;
 	}
+	name = path.substr(from);
+	valid = true;
+	return map;
 }
+Map::Values &Map::valuesForPath(const std::string &path, bool &valid, std::string &name, bool createMissing) {
+	return mapForPath(path, valid, name, createMissing)->m_values;
+}
+// Type of the value stored in a variable when a value of type T is set
+template<typename T>
+struct StoredType {
+	using type = T;
+};
+template<>
+struct StoredType<const char *> {
+	using type = std::string;
+};
 template<typename T>
-Map &setByPath(Map &map, const std::string &name, T value) {
+struct StoredType<std::vector<T>> {
+	using type = std::vector<typename StoredType<T>::type>;
+};
+template<typename Stored, typename T>
+static bool equalValues(const Stored &current, const T &value) {
+	return current == value;
+}
+template<typename Stored, typename T>
+static bool equalValues(const std::vector<Stored> &current, const T &values) {
+	return std::equal(current.begin(), current.end(), values.begin(), values.end(), [](const Stored &a, const auto &b) {
+		return a == b;
+	});
+}
+// Setting the same value again is not a change
+template<typename Stored, typename T>
+static bool isSameValue(const Variable &variable, const T &value) {
+	auto current = boost::get<Stored>(&variable.data());
+	return current && equalValues(*current, value);
+}
+template<typename T>
+Map &Map::setByPath(const std::string &name, T value) {
 	bool valid;
 	std::string fieldName;
-	auto &values = map.valuesForPath(name, valid, fieldName, true);
+	auto map = mapForPath(name, valid, fieldName, true);
 	if (valid) {
+		auto &values = map->m_values;
 		auto i = values.find(fieldName);
-		if (i == values.end())
+		if (i == values.end()) {
 			values.emplace(new Variable(fieldName, value));
-		else {
+			map->structureChanged();
+		} else {
+			if (isSameValue<typename StoredType<T>::type>(**i, value))
+				return *this;
+			// Replacing a map or setting a new one changes paths under this variable
+			bool replacesMap = std::is_same<T, Ref>::value || boost::apply_visitor(IsMap(), (*i)->data());
 			(*i)->assign(value);
+			if (replacesMap)
+				map->structureChanged();
 		}
+		map->changed();
 	}
-	return map;
+	return *this;
 }
 template<typename T>
-Map &setByPath(Map &map, const std::string &name, common::Span<T> value) {
+Map &Map::setByPath(const std::string &name, common::Span<T> value) {
 	bool valid;
 	std::string fieldName;
-	auto &values = map.valuesForPath(name, valid, fieldName, true);
+	auto map = mapForPath(name, valid, fieldName, true);
 	if (valid) {
+		auto &values = map->m_values;
 		auto i = values.find(fieldName);
-		if (i == values.end())
+		if (i == values.end()) {
 			values.emplace(new Variable(fieldName, std::vector<T>(value.begin(), value.end())));
-		else {
+			map->structureChanged();
+		} else {
+			if (isSameValue<typename StoredType<std::vector<T>>::type>(**i, value))
+				return *this;
+			bool replacesMap = boost::apply_visitor(IsMap(), (*i)->data());
 			(*i)->assign(std::vector<T>(value.begin(), value.end()));
+			if (replacesMap)
+				map->structureChanged();
 		}
+		map->changed();
 	}
-	return map;
+	return *this;
 }
 Map &Map::set(const std::string &name, bool value) {
-	return setByPath(*this, name, value);
+	return setByPath(name, value);
 }
 Map &Map::set(const std::string &name, float value) {
-	return setByPath(*this, name, value);
+	return setByPath(name, value);
 }
 Map &Map::set(const std::string &name, int32_t value) {
-	return setByPath(*this, name, value);
+	return setByPath(name, value);
 }
 Map &Map::set(const std::string &name, const Color &value) {
-	return setByPath(*this, name, value);
+	return setByPath(name, value);
 }
 Map &Map::set(const std::string &name, const std::string &value) {
-	return setByPath(*this, name, value);
+	return setByPath(name, value);
 }
 Map &Map::set(const std::string &name, const char *value) {
-	return setByPath(*this, name, value);
+	return setByPath(name, value);
 }
 Map &Map::set(const std::string &name, Ref value) {
-	return setByPath(*this, name, value);
+	return setByPath(name, value);
 }
 Map &Map::set(const std::string &name, const std::vector<bool> &values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const std::vector<float> &values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const std::vector<int32_t> &values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const std::vector<Color> &values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const std::vector<std::string> &values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const std::vector<const char *> &values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const std::vector<Ref> &values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const common::Span<bool> values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const common::Span<float> values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const common::Span<int32_t> values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const common::Span<Color> values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const common::Span<std::string> values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const common::Span<const char *> values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(const std::string &name, const common::Span<Ref> values) {
-	return setByPath(*this, name, values);
+	return setByPath(name, values);
 }
 Map &Map::set(std::unique_ptr<Variable> &&value) {
 	if (!value)
 		return *this;
 	auto i = m_values.find(value->name());
-	if (i == m_values.end())
+	if (i == m_values.end()) {
 		m_values.emplace(std::move(value));
-	else
+	} else {
+		bool replacesMap = boost::apply_visitor(IsMap(), (*i)->data()) || boost::apply_visitor(IsMap(), value->data());
 		(*i)->data() = std::move(value->data());
+		if (!replacesMap) {
+			changed();
+			return *this;
+		}
+	}
+	changed();
+	structureChanged();
 	return *this;
 }
 bool Map::remove(const std::string &name) {
 	bool valid;
 	std::string fieldName;
-	auto &values = valuesForPath(name, valid, fieldName, false);
+	auto map = mapForPath(name, valid, fieldName, false);
 	if (!valid)
 		return false;
+	auto &values = map->m_values;
 	auto i = values.find(fieldName);
 	if (i == values.end())
 		return false;
 	values.erase(i);
+	map->changed();
+	map->structureChanged();
 	return true;
 }
 bool Map::removeAll() {
 	bool result = !m_values.empty();
 	m_values.clear();
+	if (result) {
+		changed();
+		structureChanged();
+	}
 	return result;
 }
 size_t Map::size() const {
@@ -437,6 +484,108 @@ bool Map::contains(const std::string &name) const {
 		return false;
 	return values.find(fieldName) != values.end();
 }
+Variable *Map::find(const std::string &path) {
+	bool valid;
+	std::string fieldName;
+	auto &values = valuesForPath(path, valid, fieldName, false);
+	if (!valid)
+		return nullptr;
+	auto i = values.find(fieldName);
+	if (i == values.end())
+		return nullptr;
+	return i->get();
+}
+const Variable *Map::find(const std::string &path) const {
+	bool valid;
+	std::string fieldName;
+	auto &values = valuesForPath(path, valid, fieldName);
+	if (!valid)
+		return nullptr;
+	auto i = values.find(fieldName);
+	if (i == values.end())
+		return nullptr;
+	return i->get();
+}
+const Variable *Map::find(const std::string &path, PathRevisions &maps) const {
+	const Map *map = this;
+	size_t from = 0, position;
+	for (;;) {
+		maps.emplace_back(map, map->m_structureRevision);
+		position = path.find('.', from);
+		auto i = map->m_values.find(path.substr(from, position == std::string::npos ? std::string::npos : position - from));
+		if (i == map->m_values.end())
+			return nullptr;
+		if (position == std::string::npos)
+			return i->get();
+		if (!boost::apply_visitor(IsMap(), (*i)->data()))
+			return nullptr;
+		auto &next = boost::get<const Ref &>((*i)->data());
+		if (!next)
+			return nullptr;
+		map = &*next;
+		from = position + 1;
+	}
+}
+uint64_t Map::structureRevision() const {
+	return m_structureRevision;
+}
+void Map::structureChanged() {
+	++m_structureRevision;
+}
+void Map::changed() {
+	m_changeRevision = ++changeClock;
+}
+uint64_t Map::changeRevision() const {
+	return m_changeRevision;
+}
+struct TreeChangeRevisionVisitor: public boost::static_visitor<uint64_t> {
+	template<typename T>
+	uint64_t operator()(const T &) const {
+		return 0;
+	}
+	uint64_t operator()(const Ref &value) const {
+		return value ? value->treeChangeRevision() : 0;
+	}
+	uint64_t operator()(const std::vector<Ref> &values) const {
+		uint64_t result = 0;
+		for (const auto &value: values)
+			result = std::max(result, (*this)(value));
+		return result;
+	}
+};
+uint64_t Map::treeChangeRevision() const {
+	uint64_t result = m_changeRevision;
+	for (const auto &value: m_values)
+		result = std::max(result, boost::apply_visitor(TreeChangeRevisionVisitor(), value->data()));
+	return result;
+}
+struct CloneVisitor: public boost::static_visitor<std::unique_ptr<Variable>> {
+	CloneVisitor(const Variable &variable):
+		variable(variable) {
+	}
+	template<typename T>
+	std::unique_ptr<Variable> operator()(const T &) const {
+		return std::make_unique<Variable>(variable);
+	}
+	std::unique_ptr<Variable> operator()(const Ref &value) const {
+		return std::make_unique<Variable>(variable.name(), value ? value->clone() : Map::create());
+	}
+	std::unique_ptr<Variable> operator()(const std::vector<Ref> &values) const {
+		std::vector<Ref> result;
+		result.reserve(values.size());
+		for (const auto &value: values)
+			result.push_back(value ? value->clone() : Map::create());
+		return std::make_unique<Variable>(variable.name(), result);
+	}
+	const Variable &variable;
+};
+Ref Map::clone() const {
+	auto result = create();
+	for (const auto &value: m_values)
+		result->m_values.emplace(boost::apply_visitor(CloneVisitor(*value), value->data()));
+	result->m_changeRevision = m_changeRevision;
+	return result;
+}
 struct TypeNameVisitor: public boost::static_visitor<std::string> {
 	template<typename T>
 	std::string operator()(const T &) const {
@@ -466,6 +615,13 @@ bool Map::deserializeXml(std::istream &stream) {
 	removeAll();
 	return xml::deserialize(stream, *this);
 }
+bool Map::serializeTree(std::ostream &stream) const {
+	return binary::serializeTree(stream, *this);
+}
+bool Map::deserializeTree(std::istream &stream) {
+	removeAll();
+	return binary::deserializeTree(stream, *this);
+}
 bool Map::visit(std::function<bool(const Variable &value)> visitor, bool recursive) const {
 	if (!recursive) {
 		for (const auto &value: m_values)
@@ -492,20 +648,118 @@ bool Map::visit(std::function<bool(const Variable &value)> visitor, bool recursi
 	}
 	return true;
 }
-Map::Map() {
+Map::Map():
+	m_changeRevision(0),
+	m_structureRevision(0) {
 }
 Map::~Map() {
 }
 Ref Map::create() {
 	return Ref(new Map());
 }
-bool Map::Compare::operator()(const std::unique_ptr<Variable> &a, const std::unique_ptr<Variable> &b) const {
-	return a->name() < b->name();
+// Maps up to this size are searched linearly, comparing hashes first
+static const size_t LinearSearchSize = 8;
+static uint32_t hashName(const std::string &name) {
+	return static_cast<uint32_t>(std::hash<std::string>()(name));
+}
+Map::Values::iterator Map::Values::begin() {
+	return m_variables.begin();
+}
+Map::Values::iterator Map::Values::end() {
+	return m_variables.end();
+}
+Map::Values::const_iterator Map::Values::begin() const {
+	return m_variables.begin();
+}
+Map::Values::const_iterator Map::Values::end() const {
+	return m_variables.end();
+}
+size_t Map::Values::size() const {
+	return m_variables.size();
 }
-bool Map::Compare::operator()(const std::string &name, const std::unique_ptr<Variable> &b) const {
-	return name < b->name();
+bool Map::Values::empty() const {
+	return m_variables.empty();
 }
-bool Map::Compare::operator()(const std::unique_ptr<Variable> &a, const std::string &name) const {
-	return a->name() < name;
+size_t Map::Values::findPosition(const std::string &name, uint32_t hash) const {
+	if (m_index.empty()) {
+		for (size_t i = 0; i < m_hashes.size(); i++) {
+			if (m_hashes[i] == hash && m_variables[i]->name() == name)
+				return i;
+		}
+		return m_variables.size();
+	}
+	size_t mask = m_index.size() - 1;
+	for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+		auto entry = m_index[slot];
+		if (entry == 0)
+			return m_variables.size();
+		if (m_hashes[entry - 1] == hash && m_variables[entry - 1]->name() == name)
+			return entry - 1;
+	}
+}
+Map::Values::iterator Map::Values::find(const std::string &name) {
+	return m_variables.begin() + findPosition(name, hashName(name));
+}
+Map::Values::const_iterator Map::Values::find(const std::string &name) const {
+	return m_variables.begin() + findPosition(name, hashName(name));
+}
+std::pair<Map::Values::iterator, bool> Map::Values::emplace(std::unique_ptr<Variable> &&variable) {
+	auto hash = hashName(variable->name());
+	auto position = findPosition(variable->name(), hash);
+	if (position != m_variables.size())
+		return std::make_pair(m_variables.begin() + position, false);
+	auto i = std::lower_bound(m_variables.begin(), m_variables.end(), variable->name(), [](const std::unique_ptr<Variable> &a, const std::string &name) {
+		return a->name() < name;
+	});
+	position = i - m_variables.begin();
+	m_variables.insert(i, std::move(variable));
+	m_hashes.insert(m_hashes.begin() + position, hash);
+	insertIndex(position);
+	return std::make_pair(m_variables.begin() + position, true);
+}
+std::pair<Map::Values::iterator, bool> Map::Values::emplace(Variable *variable) {
+	return emplace(std::unique_ptr<Variable>(variable));
+}
+Map::Values::iterator Map::Values::erase(const_iterator position) {
+	auto offset = position - m_variables.cbegin();
+	m_variables.erase(m_variables.begin() + offset);
+	m_hashes.erase(m_hashes.begin() + offset);
+	rebuildIndex();
+	return m_variables.begin() + offset;
+}
+void Map::Values::clear() {
+	m_variables.clear();
+	m_hashes.clear();
+	m_index.clear();
+}
+void Map::Values::insertIndex(size_t position) {
+	// Appending in name order is the common case when deserializing, and needs no renumbering
+	bool appended = position + 1 == m_variables.size();
+	if (!appended || m_index.empty() || m_variables.size() * 2 > m_index.size()) {
+		rebuildIndex();
+		return;
+	}
+	size_t mask = m_index.size() - 1;
+	size_t slot = m_hashes[position] & mask;
+	while (m_index[slot] != 0)
+		slot = (slot + 1) & mask;
+	m_index[slot] = static_cast<uint32_t>(position + 1);
+}
+void Map::Values::rebuildIndex() {
+	if (m_variables.size() <= LinearSearchSize) {
+		m_index.clear();
+		return;
+	}
+	size_t capacity = 16;
+	while (capacity < m_variables.size() * 4)
+		capacity *= 2;
+	m_index.assign(capacity, 0);
+	size_t mask = capacity - 1;
+	for (size_t i = 0; i < m_hashes.size(); i++) {
+		size_t slot = m_hashes[i] & mask;
+		while (m_index[slot] != 0)
+			slot = (slot + 1) & mask;
+		m_index[slot] = static_cast<uint32_t>(i + 1);
+	}
 }
 }
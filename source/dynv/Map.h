@@ -23,7 +23,6 @@
 #include "Types.h"
 #include "common/Ref.h"
 #include "common/Span.h"
-#include <set>
 #include <vector>
 #include <memory>
 #include <ostream>
@@ -35,13 +34,32 @@ namespace dynv {
 struct Variable;
 struct Map: public common::Ref<Map>::Counter {
 	using Ref = common::Ref<Map>;
-	struct Compare {
-		using is_transparent = void;
-		bool operator()(const std::unique_ptr<Variable> &a, const std::unique_ptr<Variable> &b) const;
-		bool operator()(const std::string &name, const std::unique_ptr<Variable> &b) const;
-		bool operator()(const std::unique_ptr<Variable> &a, const std::string &name) const;
+	// Variables sorted by name, so iteration and serialization order stay deterministic. Larger maps also have an open addressing hash index for lookups.
+	struct Values {
+		using iterator = std::vector<std::unique_ptr<Variable>>::iterator;
+		using const_iterator = std::vector<std::unique_ptr<Variable>>::const_iterator;
+		iterator begin();
+		iterator end();
+		const_iterator begin() const;
+		const_iterator end() const;
+		size_t size() const;
+		bool empty() const;
+		iterator find(const std::string &name);
+		const_iterator find(const std::string &name) const;
+		// Variable is destroyed if variable with the same name already exists
+		std::pair<iterator, bool> emplace(std::unique_ptr<Variable> &&variable);
+		std::pair<iterator, bool> emplace(Variable *variable);
+		iterator erase(const_iterator position);
+		void clear();
+	private:
+		std::vector<std::unique_ptr<Variable>> m_variables;
+		std::vector<uint32_t> m_hashes;
+		// Positions of variables plus one, zero marks an empty slot. Empty when map is small enough for linear search.
+		std::vector<uint32_t> m_index;
+		size_t findPosition(const std::string &name, uint32_t hash) const;
+		void insertIndex(size_t position);
+		void rebuildIndex();
 	};
-	using Set = std::set<std::unique_ptr<Variable>, Compare>;
 	Map();
 	virtual ~Map() override;
 	bool getBool(const std::string &name, bool defaultValue = false) const;
@@ -90,18 +108,45 @@ struct Map: public common::Ref<Map>::Counter {
 	bool removeAll();
 	size_t size() const;
 	bool contains(const std::string &name) const;
+	// Returns nullptr if path does not exist
+	Variable *find(const std::string &path);
+	const Variable *find(const std::string &path) const;
+	// Maps visited while resolving a path, each with its structure revision at that time
+	typedef std::vector<std::pair<const Map *, uint64_t>> PathRevisions;
+	// Same as find, but also records maps on the path, starting with this map. Result stays valid while structure revisions of recorded maps do not change.
+	const Variable *find(const std::string &path, PathRevisions &maps) const;
 	std::string type(const std::string &name) const;
 	bool serialize(std::ostream &stream, const std::unordered_map<types::ValueType, uint8_t> &typeMap) const;
 	bool serializeXml(std::ostream &stream) const;
 	bool deserialize(std::istream &stream, const std::unordered_map<uint8_t, types::ValueType> &typeMap);
 	bool deserializeXml(std::istream &stream);
+	// Binary format with nested maps and lists, used for fast loading of cached data
+	bool serializeTree(std::ostream &stream) const;
+	bool deserializeTree(std::istream &stream);
 	bool visit(std::function<bool(const Variable &value)> visitor, bool recursive = false) const;
 	static Ref create();
-	Set &valuesForPath(const std::string &path, bool &valid, std::string &name, bool createMissing);
-	const Set &valuesForPath(const std::string &path, bool &valid, std::string &name) const;
+	Values &valuesForPath(const std::string &path, bool &valid, std::string &name, bool createMissing);
+	const Values &valuesForPath(const std::string &path, bool &valid, std::string &name) const;
+	// Incremented every time a variable is added or removed, or a map value is replaced in this map. Pointers to variables of this map stay valid while revision does not change.
+	uint64_t structureRevision() const;
+	// Revision of the last change made through this map. Revisions come from a shared clock, so they can be compared between maps.
+	uint64_t changeRevision() const;
+	// Latest change revision of this map and all nested maps
+	uint64_t treeChangeRevision() const;
+	// Deep copy, nested maps are copied too
+	Ref clone() const;
 private:
-	Set m_values;
+	Values m_values;
+	uint64_t m_changeRevision;
+	uint64_t m_structureRevision;
 	static const std::string m_defaultString;
+	Map *mapForPath(const std::string &path, bool &valid, std::string &name, bool createMissing);
+	template<typename T>
+	Map &setByPath(const std::string &name, T value);
+	template<typename T>
+	Map &setByPath(const std::string &name, common::Span<T> value);
+	void changed();
+	void structureChanged();
 };
 }
 #endif /* GPICK_DYNV_MAP_H_ */
@@ -19,12 +19,11 @@
 #include "Types.h"
 #include "Map.h"
 #include "Color.h"
+#include "Xml.h"
+#include "XmlWriter.h"
 #include <algorithm>
 #include <boost/endian/conversion.hpp>
 namespace dynv {
-namespace xml {
-bool serialize(std::ostream &stream, const Map &map, bool addRootElement = true);
-}
 namespace types {
 static const KnownHandler knownHandlers[] = {
 	{ "bool", ValueType::basicBool },
@@ -60,50 +59,30 @@ template<> const KnownHandler &typeHandler<std::string>() { return knownHandlers
 template<> const KnownHandler &typeHandler<Color>() { return knownHandlers[4]; }
 template<> const KnownHandler &typeHandler<Ref>() { return knownHandlers[5]; }
 namespace xml {
-static std::string escapeXmlString(const std::string &value) {
-	std::string result;
-	result.reserve(value.length() + 64);
-	for (auto ch: value) {
-		switch (ch) {
-		case '&':
-			result += "&amp;";
-			break;
-		case '<':
-			result += "&lt;";
-			break;
-		case '>':
-			result += "&gt;";
-			break;
-		default:
-			result += ch;
-		}
-	}
-	return result;
+template<> bool write(dynv::xml::Writer &writer, bool value) {
+	writer.write(value ? "true" : "false");
+	return writer.good();
 }
-template<> bool write(std::ostream &stream, bool value) {
-	stream << (value ? "true" : "false");
-	return stream.good();
+template<> bool write(dynv::xml::Writer &writer, float value) {
+	writer.write(value);
+	return writer.good();
 }
-template<> bool write(std::ostream &stream, float value) {
-	stream << value;
-	return stream.good();
+template<> bool write(dynv::xml::Writer &writer, int32_t value) {
+	writer.write(value);
+	return writer.good();
 }
-template<> bool write(std::ostream &stream, int32_t value) {
-	stream << value;
-	return stream.good();
-}
-template<> bool write(std::ostream &stream, const std::string &value) {
-	stream << escapeXmlString(value);
-	return stream.good();
+template<> bool write(dynv::xml::Writer &writer, const std::string &value) {
+	writer.writeEscaped(value);
+	return writer.good();
 }
-template<> bool write(std::ostream &stream, const Color &value) {
-	stream << value.ma[0] << " " << value.ma[1] << " " << value.ma[2] << " " << value.ma[3];
-	return stream.good();
+template<> bool write(dynv::xml::Writer &writer, const Color &value) {
+	writer.write(value);
+	return writer.good();
 }
-template<> bool write(std::ostream &stream, const Ref &value) {
+template<> bool write(dynv::xml::Writer &writer, const Ref &value) {
 	if (value)
-		dynv::xml::serialize(stream, *value, false);
-	return stream.good();
+		dynv::xml::serialize(writer, *value, false);
+	return writer.good();
 }
 }
 namespace binary {
@@ -23,6 +23,9 @@
 #include <type_traits>
 namespace dynv {
 struct Map;
+namespace xml {
+struct Writer;
+}
 namespace types {
 enum class ValueType : uint8_t {
 	unknown,
@@ -39,8 +42,8 @@ struct KnownHandler {
 };
 template<typename T> const KnownHandler &typeHandler();
 namespace xml {
-template<typename T, typename std::enable_if_t<std::is_arithmetic<T>::value, int> = 0> bool write(std::ostream &stream, T value);
-template<typename T, typename std::enable_if_t<!std::is_arithmetic<T>::value, int> = 0> bool write(std::ostream &stream, const T &value);
+template<typename T, typename std::enable_if_t<std::is_arithmetic<T>::value, int> = 0> bool write(dynv::xml::Writer &writer, T value);
+template<typename T, typename std::enable_if_t<!std::is_arithmetic<T>::value, int> = 0> bool write(dynv::xml::Writer &writer, const T &value);
 }
 namespace binary {
 template<typename T, typename std::enable_if_t<std::is_arithmetic<T>::value, int> = 0> bool write(std::ostream &stream, T value);
@@ -20,6 +20,7 @@
 #include "Map.h"
 #include "Variable.h"
 #include "Types.h"
+#include "XmlWriter.h"
 #include "common/Scoped.h"
 #include <expat.h>
 #include <sstream>
@@ -27,24 +28,20 @@ using namespace std::string_literals;
 namespace dynv {
 namespace xml {
 using ValueType = types::ValueType;
-bool writeStart(std::ostream &stream, const std::string &name) {
-	stream << "<" << name << ">";
-	return stream.good();
+static bool writeStart(Writer &writer, const std::string &name, const std::string &type) {
+	writer.write("<").write(name).write(" type=\"").write(type).write("\">");
+	return writer.good();
 }
-bool writeStart(std::ostream &stream, const std::string &name, const std::string &type) {
-	stream << "<" << name << " type=\"" << type << "\">";
-	return stream.good();
+static bool writeEnd(Writer &writer, const std::string &name) {
+	writer.write("</").write(name).write(">");
+	return writer.good();
 }
-bool writeEnd(std::ostream &stream, const std::string &name) {
-	stream << "</" << name << ">";
-	return stream.good();
-}
-bool writeListStart(std::ostream &stream, const std::string &name, const std::string &type) {
-	stream << "<" << name << " type=\"" << type << "\" list=\"true\">";
-	return stream.good();
+static bool writeListStart(Writer &writer, const std::string &name, const std::string &type) {
+	writer.write("<").write(name).write(" type=\"").write(type).write("\" list=\"true\">");
+	return writer.good();
 }
 struct SerializeVisitor: public boost::static_visitor<bool> {
-	SerializeVisitor(std::ostream &stream, const std::string &name):
+	SerializeVisitor(Writer &stream, const std::string &name):
 		stream(stream),
 		name(name) {
 	}
@@ -69,20 +66,18 @@ struct SerializeVisitor: public boost::static_visitor<bool> {
 	}
 	template<typename T>
 	bool operator()(const std::vector<T> &values) const {
-		using namespace std::string_literals;
 		if (!writeListStart(stream, name, dynv::types::typeHandler<T>().name))
 			return false;
 		for (const auto &i: values) {
-			if (!writeStart(stream, "li"s))
-				return false;
+			stream.write("<li>");
 			if (!types::xml::write(stream, i))
 				return false;
-			if (!writeEnd(stream, "li"s))
+			if (!stream.write("</li>").good())
 				return false;
 		}
 		return writeEnd(stream, name);
 	}
-	std::ostream &stream;
+	Writer &stream;
 	const std::string &name;
 };
 static bool isTrue(const char *value) {
@@ -383,26 +378,30 @@ static void onEndElement(Context *context, const XML_Char *name) {
 		return;
 	}
 }
-bool serialize(std::ostream &stream, const Map &map, bool addRootElement) {
+bool serialize(Writer &writer, const Map &map, bool addRootElement) {
 	if (addRootElement) {
-		stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?><root>";
-		if (!stream.good())
+		if (!writer.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?><root>").good())
 			return false;
 	}
-	auto visitor = [&stream](const Variable &value) -> bool {
-		if (!boost::apply_visitor(SerializeVisitor(stream, value.name()), value.data()))
+	auto visitor = [&writer](const Variable &value) -> bool {
+		if (!boost::apply_visitor(SerializeVisitor(writer, value.name()), value.data()))
 			return false;
 		return true;
 	};
 	if (!map.visit(visitor))
 		return false;
 	if (addRootElement) {
-		stream << "</root>";
-		if (!stream.good())
+		if (!writer.write("</root>").good())
 			return false;
 	}
 	return true;
 }
+bool serialize(std::ostream &stream, const Map &map, bool addRootElement) {
+	Writer writer(stream);
+	if (!serialize(writer, map, addRootElement))
+		return false;
+	return writer.flush();
+}
 bool deserialize(std::istream &stream, Map &map) {
 	auto parser = XML_ParserCreate("UTF-8");
 	auto freeParser = common::makeScoped(XML_ParserFree, parser);
@@ -23,7 +23,9 @@
 namespace dynv {
 struct Map;
 namespace xml {
+struct Writer;
 bool serialize(std::ostream &stream, const Map &map, bool addRootElement = true);
+bool serialize(Writer &writer, const Map &map, bool addRootElement);
 bool deserialize(std::istream &stream, Map &map);
 }
 }
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "XmlWriter.h"
+#include <cstring>
+namespace dynv {
+namespace xml {
+static const size_t BufferSize = 64 * 1024;
+Writer::Buffer::Buffer(std::string &data):
+	data(data) {
+}
+Writer::Buffer::int_type Writer::Buffer::overflow(int_type value) {
+	if (!traits_type::eq_int_type(value, traits_type::eof()))
+		data.push_back(traits_type::to_char_type(value));
+	return traits_type::not_eof(value);
+}
+std::streamsize Writer::Buffer::xsputn(const char *value, std::streamsize length) {
+	data.append(value, length);
+	return length;
+}
+Writer::Writer(std::ostream &stream):
+	m_stream(stream),
+	m_buffer(m_data),
+	m_numberStream(&m_buffer),
+	m_good(stream.good()) {
+	m_data.reserve(BufferSize + 1024);
+	m_numberStream.flags(stream.flags());
+	m_numberStream.precision(stream.precision());
+	m_numberStream.imbue(stream.getloc());
+}
+Writer::~Writer() {
+	flush();
+}
+Writer &Writer::write(const char *value, size_t length) {
+	m_data.append(value, length);
+	flushIfFull();
+	return *this;
+}
+Writer &Writer::write(const char *value) {
+	return write(value, std::strlen(value));
+}
+Writer &Writer::write(const std::string &value) {
+	return write(value.c_str(), value.length());
+}
+Writer &Writer::writeEscaped(const std::string &value) {
+	auto data = value.c_str();
+	size_t length = value.length();
+	// strcspn is vectorized in most C libraries, so strings without special characters are copied as a whole
+	size_t position = std::strcspn(data, "&<>");
+	if (position >= length)
+		return write(data, length);
+	size_t from = 0;
+	for (; position < length; position++) {
+		const char *entity;
+		switch (data[position]) {
+		case '&':
+			entity = "&amp;";
+			break;
+		case '<':
+			entity = "&lt;";
+			break;
+		case '>':
+			entity = "&gt;";
+			break;
+		default:
+			continue;
+		}
+		m_data.append(data + from, position - from);
+		m_data.append(entity);
+		from = position + 1;
+	}
+	m_data.append(data + from, length - from);
+	flushIfFull();
+	return *this;
+}
+Writer &Writer::write(int32_t value) {
+	m_numberStream << value;
+	flushIfFull();
+	return *this;
+}
+Writer &Writer::write(float value) {
+	m_numberStream << value;
+	flushIfFull();
+	return *this;
+}
+Writer &Writer::write(const Color &value) {
+	m_numberStream << value.ma[0] << " " << value.ma[1] << " " << value.ma[2] << " " << value.ma[3];
+	flushIfFull();
+	return *this;
+}
+void Writer::flushIfFull() {
+	if (m_data.length() >= BufferSize)
+		flush();
+}
+bool Writer::flush() {
+	if (!m_data.empty()) {
+		if (m_good) {
+			m_stream.write(m_data.c_str(), m_data.length());
+			m_good = m_stream.good();
+		}
+		m_data.clear();
+	}
+	return m_good;
+}
+bool Writer::good() const {
+	return m_good;
+}
+}
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_DYNV_XML_WRITER_H_
+#define GPICK_DYNV_XML_WRITER_H_
+#include "Color.h"
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <cstdint>
+namespace dynv {
+namespace xml {
+// Collects XML output in a buffer and writes it to the stream in large blocks
+struct Writer {
+	Writer(std::ostream &stream);
+	Writer(const Writer &) = delete;
+	~Writer();
+	Writer &write(const char *value, size_t length);
+	Writer &write(const char *value);
+	Writer &write(const std::string &value);
+	// Replaces &, < and > with entities
+	Writer &writeEscaped(const std::string &value);
+	// Numbers are formatted exactly as the stream would format them
+	Writer &write(int32_t value);
+	Writer &write(float value);
+	Writer &write(const Color &value);
+	bool flush();
+	bool good() const;
+private:
+	struct Buffer: public std::streambuf {
+		Buffer(std::string &data);
+		virtual int_type overflow(int_type value) override;
+		virtual std::streamsize xsputn(const char *value, std::streamsize length) override;
+		std::string &data;
+	};
+	std::ostream &m_stream;
+	std::string m_data;
+	Buffer m_buffer;
+	std::ostream m_numberStream;
+	bool m_good;
+	void flushIfFull();
+};
+}
+}
+#endif /* GPICK_DYNV_XML_WRITER_H_ */
@@ -21,7 +21,9 @@
 using namespace std;
 namespace lua
 {
-Callbacks::Callbacks()
+Callbacks::Callbacks():
+	m_option_change_site(nullptr),
+	m_component_to_text_site(nullptr)
 {
 }
 Ref &Callbacks::optionChange()
@@ -40,4 +42,17 @@ void Callbacks::componentToText(Ref &&ref)
 {
 	m_component_to_text = move(ref);
 }
+void Callbacks::profiler(Profiler *profiler)
+{
+	m_option_change_site = profiler ? profiler->site("callbacks.optionChange") : nullptr;
+	m_component_to_text_site = profiler ? profiler->site("callbacks.componentToText") : nullptr;
+}
+Profiler::Site *Callbacks::optionChangeSite()
+{
+	return m_option_change_site;
+}
+Profiler::Site *Callbacks::componentToTextSite()
+{
+	return m_component_to_text_site;
+}
 }
@@ -19,6 +19,7 @@
 #ifndef GPICK_LUA_CALLBACKS_H_
 #define GPICK_LUA_CALLBACKS_H_
 #include "Ref.h"
+#include "Profiler.h"
 namespace lua
 {
 struct Callbacks
@@ -30,9 +31,14 @@ struct Callbacks
 	void optionChange(Ref &&ref);
 	Ref &componentToText();
 	void componentToText(Ref &&ref);
+	// Looks up profiler sites once, so callbacks can be measured without a name lookup per call.
+	void profiler(Profiler *profiler);
+	Profiler::Site *optionChangeSite();
+	Profiler::Site *componentToTextSite();
 	private:
 	Ref m_option_change;
 	Ref m_component_to_text;
+	Profiler::Site *m_option_change_site, *m_component_to_text_site;
 };
 }
 #endif /* GPICK_LUA_CALLBACKS_H_ */
@@ -30,6 +30,9 @@
 #include "../layout/Layout.h"
 #include "../Converters.h"
 #include "../Converter.h"
+#include "../ConverterSignature.h"
+#include "../BuiltinConverters.h"
+#include "../Paths.h"
 #include "../version/Version.h"
 extern "C"{
 #include <lualib.h>
@@ -49,40 +52,93 @@ static int addLayout(lua_State *L)
 	const char *label = luaL_checkstring(L, 3);
 	checkArgumentIsFunctionOrNil(L, 4);
 	int mask = luaL_optinteger(L, 5, 0);
-	getGlobalState(L).layouts().add(new layout::Layout(name, label, mask, Ref(L, 4)));
+	auto layouts = getLayouts(L);
+	if (layouts)
+		layouts->add(new layout::Layout(name, label, mask, Ref(L, 4)));
 	return 0;
 }
+static bool isFunctionFromFile(lua_State *L, int index, const std::string &source)
+{
+	if (lua_type(L, index) != LUA_TFUNCTION)
+		return true;
+	lua_Debug debug;
+	lua_pushvalue(L, index);
+	lua_getinfo(L, ">S", &debug);
+	return source == debug.source;
+}
 static int addConverter(lua_State *L)
 {
 	const char *name = luaL_checkstring(L, 2);
 	const char *label = luaL_checkstring(L, 3);
 	checkArgumentIsFunctionOrNil(L, 4);
 	if (lua_gettop(L) >= 5) checkArgumentIsFunctionOrNil(L, 5);
+	if (lua_gettop(L) >= 6) checkArgumentIsFunctionOrNil(L, 6);
+	Converter *converter = nullptr;
 	if (lua_gettop(L) == 4)
-		getGlobalState(L).converters().add(new Converter(name, label, Ref(L, 4), Ref()));
-	else if (lua_gettop(L) >= 5)
-		getGlobalState(L).converters().add(new Converter(name, label, Ref(L, 4), Ref(L, 5)));
+		converter = new Converter(name, label, Ref(L, 4), Ref());
+	else if (lua_gettop(L) == 5)
+		converter = new Converter(name, label, Ref(L, 4), Ref(L, 5));
+	else if (lua_gettop(L) >= 6)
+		converter = new Converter(name, label, Ref(L, 4), Ref(L, 5), lua_isnil(L, 6) ? Ref() : Ref(L, 6)); // nil serializeMany means per color calls
+	if (!converter)
+		return 0;
+	auto &converters = getConverters(L);
+	// Native implementations are used only while converter functions are the ones defined in bundled converters.lua
+	auto builtin = getBuiltinConverter(name);
+	if (builtin) {
+		std::string source = "@" + buildFilename() + "/converters.lua";
+		if (isFunctionFromFile(L, 4, source) && (lua_gettop(L) < 5 || isFunctionFromFile(L, 5, source)))
+			converter->builtin(builtin, &converters.builtinOptions());
+	}
+	converters.add(converter);
+	return 0;
+}
+static int setConverterSignature(lua_State *L)
+{
+	const char *name = luaL_checkstring(L, 2);
+	luaL_checktype(L, 3, LUA_TTABLE);
+	auto min_length = luaL_optinteger(L, 4, 0);
+	luaL_argcheck(L, min_length >= 0, 4, "non-negative length expected");
+	uint32_t features = 0;
+	for (int i = 1, end = static_cast<int>(lua_rawlen(L, 3)); i <= end; i++) {
+		lua_rawgeti(L, 3, i);
+		const char *feature_name = lua_tostring(L, -1);
+		uint32_t feature = feature_name ? ConverterSignature::featureByName(feature_name) : 0;
+		if (feature == 0)
+			return luaL_argerror(L, 3, lua_pushfstring(L, "unknown feature '%s'", feature_name ? feature_name : "?"));
+		features |= feature;
+		lua_pop(L, 1);
+	}
+	auto converter = getConverters(L).byName(name);
+	if (!converter)
+		return luaL_argerror(L, 2, "unknown converter");
+	converter->signature(ConverterSignature(features, static_cast<size_t>(min_length)));
 	return 0;
 }
 static int setOptionChangeCallback(lua_State *L)
 {
-	getGlobalState(L).callbacks().optionChange(Ref(L, 2));
+	getCallbacks(L).optionChange(Ref(L, 2));
 	return 0;
 }
 static int setComponentToTextCallback(lua_State *L)
 {
-	getGlobalState(L).callbacks().componentToText(Ref(L, 2));
+	getCallbacks(L).componentToText(Ref(L, 2));
 	return 0;
 }
 static const struct luaL_Reg functions[] =
 {
 	{"addLayout", addLayout},
 	{"addConverter", addConverter},
+	{"setConverterSignature", setConverterSignature},
 	{"setComponentToTextCallback", setComponentToTextCallback},
 	{"setOptionChangeCallback", setOptionChangeCallback},
 	{nullptr, nullptr}
 };
 void registerAll(lua_State *L, GlobalState &global_state)
+{
+	registerAll(L, global_state, global_state.converters(), global_state.callbacks(), &global_state.layouts());
+}
+void registerAll(lua_State *L, GlobalState &global_state, Converters &converters, Callbacks &callbacks, layout::Layouts *layouts)
 {
 	Script script(L);
 	script.registerExtension("color", registerColor);
@@ -100,5 +156,8 @@ void registerAll(lua_State *L, GlobalState &global_state)
 		return 1;
 	});
 	setGlobalState(L, global_state);
+	setConverters(L, converters);
+	setCallbacks(L, callbacks);
+	setLayouts(L, layouts);
 }
 }
@@ -20,8 +20,15 @@
 #define GPICK_LUA_EXTENSIONS_H_
 struct lua_State;
 struct GlobalState;
+struct Converters;
+namespace layout {
+	struct Layouts;
+}
 namespace lua
 {
+struct Callbacks;
 void registerAll(lua_State *L, GlobalState &global_state);
+// Layouts are not registered when layouts is nullptr.
+void registerAll(lua_State *L, GlobalState &global_state, Converters &converters, Callbacks &callbacks, layout::Layouts *layouts);
 }
 #endif /* GPICK_LUA_EXTENSIONS_H_ */
@@ -39,4 +39,43 @@ GlobalState &getGlobalState(lua_State *L)
 	lua_pop(L, 1);
 	return global_state;
 }
+static void setPointer(lua_State *L, const char *name, void *pointer)
+{
+	lua_pushglobaltable(L);
+	lua_pushlightuserdata(L, pointer);
+	lua_setfield(L, -2, name);
+	lua_pop(L, 1);
+}
+static void *getPointer(lua_State *L, const char *name)
+{
+	lua_pushglobaltable(L);
+	lua_getfield(L, -1, name);
+	void *pointer = lua_touserdata(L, -1);
+	lua_pop(L, 2);
+	return pointer;
+}
+Converters &getConverters(lua_State *L)
+{
+	return *static_cast<Converters*>(getPointer(L, "__converters"));
+}
+void setConverters(lua_State *L, Converters &converters)
+{
+	setPointer(L, "__converters", &converters);
+}
+Callbacks &getCallbacks(lua_State *L)
+{
+	return *static_cast<Callbacks*>(getPointer(L, "__callbacks"));
+}
+void setCallbacks(lua_State *L, Callbacks &callbacks)
+{
+	setPointer(L, "__callbacks", &callbacks);
+}
+layout::Layouts *getLayouts(lua_State *L)
+{
+	return static_cast<layout::Layouts*>(getPointer(L, "__layouts"));
+}
+void setLayouts(lua_State *L, layout::Layouts *layouts)
+{
+	setPointer(L, "__layouts", layouts);
+}
 }
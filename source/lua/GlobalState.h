@@ -20,9 +20,20 @@
 #define GPICK_LUA_GLOBAL_STATE_H_
 struct lua_State;
 struct GlobalState;
+struct Converters;
+namespace layout {
+	struct Layouts;
+}
 namespace lua
 {
+struct Callbacks;
 GlobalState &getGlobalState(lua_State *L);
 void setGlobalState(lua_State *L, GlobalState &global_state);
+Converters &getConverters(lua_State *L);
+void setConverters(lua_State *L, Converters &converters);
+Callbacks &getCallbacks(lua_State *L);
+void setCallbacks(lua_State *L, Callbacks &callbacks);
+layout::Layouts *getLayouts(lua_State *L);
+void setLayouts(lua_State *L, layout::Layouts *layouts);
 }
 #endif /* GPICK_LUA_GLOBAL_STATE_H_ */
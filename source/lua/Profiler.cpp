@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+extern "C"{
+#include <lua.h>
+}
+namespace lua
+{
+uint64_t Profiler::Statistics::average() const
+{
+	if (calls == 0)
+		return 0;
+	return total / calls;
+}
+Profiler::Site::Site(const std::string &name):
+	m_name(name)
+{
+	reset();
+}
+void Profiler::Site::reset()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_calls = m_errors = m_total = m_maximum = 0;
+	m_minimum = std::numeric_limits<uint64_t>::max();
+	m_memory = 0;
+	m_samples.clear();
+	m_next_sample = 0;
+}
+void Profiler::Site::record(uint64_t duration, int64_t memory, bool error)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_calls++;
+	if (error)
+		m_errors++;
+	m_total += duration;
+	m_minimum = std::min(m_minimum, duration);
+	m_maximum = std::max(m_maximum, duration);
+	m_memory += memory;
+	// Percentiles are calculated from the most recent samples only
+	if (m_samples.size() < SampleCount) {
+		m_samples.push_back(duration);
+	} else {
+		m_samples[m_next_sample] = duration;
+		m_next_sample = (m_next_sample + 1) % SampleCount;
+	}
+}
+static uint64_t percentile(const std::vector<uint64_t> &sorted, size_t percent)
+{
+	if (sorted.empty())
+		return 0;
+	size_t rank = (sorted.size() * percent + 99) / 100;
+	return sorted[rank > 0 ? rank - 1 : 0];
+}
+Profiler::Statistics Profiler::Site::statistics() const
+{
+	Statistics result;
+	std::vector<uint64_t> samples;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		result.name = m_name;
+		result.calls = m_calls;
+		result.errors = m_errors;
+		result.total = m_total;
+		result.minimum = m_calls > 0 ? m_minimum : 0;
+		result.maximum = m_maximum;
+		result.memory = m_memory;
+		samples = m_samples;
+	}
+	std::sort(samples.begin(), samples.end());
+	result.median = percentile(samples, 50);
+	result.percentile90 = percentile(samples, 90);
+	result.percentile99 = percentile(samples, 99);
+	return result;
+}
+static int64_t getMemoryUsage(lua_State *L)
+{
+	return static_cast<int64_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+}
+Profiler::Scope::Scope(Site *site, lua_State *L):
+	m_site(site),
+	m_state(L),
+	m_memory(0),
+	m_error(false)
+{
+	if (!m_site)
+		return;
+	m_memory = getMemoryUsage(L);
+	m_start = std::chrono::steady_clock::now();
+}
+Profiler::Scope::~Scope()
+{
+	if (!m_site)
+		return;
+	auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+	m_site->record(static_cast<uint64_t>(duration), getMemoryUsage(m_state) - m_memory, m_error);
+}
+void Profiler::Scope::error()
+{
+	m_error = true;
+}
+Profiler::Profiler()
+{
+}
+Profiler::Site *Profiler::site(const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto i = m_sites.find(name);
+	if (i != m_sites.end())
+		return i->second.get();
+	auto site = std::make_unique<Site>(name);
+	auto result = site.get();
+	m_sites.emplace(name, std::move(site));
+	return result;
+}
+std::vector<Profiler::Statistics> Profiler::statistics() const
+{
+	std::vector<Statistics> result;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	result.reserve(m_sites.size());
+	for (auto &site: m_sites)
+		result.push_back(site.second->statistics());
+	return result;
+}
+bool Profiler::statistics(const std::string &name, Statistics &result) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto i = m_sites.find(name);
+	if (i == m_sites.end())
+		return false;
+	result = i->second->statistics();
+	return true;
+}
+void Profiler::reset()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto &site: m_sites)
+		site.second->reset();
+}
+static double toMilliseconds(uint64_t duration)
+{
+	return static_cast<double>(duration) / 1000000.0;
+}
+void Profiler::dump(std::ostream &stream) const
+{
+	auto items = statistics();
+	std::sort(items.begin(), items.end(), [](const Statistics &a, const Statistics &b) {
+		return a.total > b.total;
+	});
+	stream << "# name\tcalls\terrors\ttotal ms\taverage ms\tmin ms\tmedian ms\t90% ms\t99% ms\tmax ms\tmemory bytes\n";
+	stream << std::fixed << std::setprecision(4);
+	for (auto &item: items) {
+		if (item.calls == 0)
+			continue;
+		stream << item.name << '\t' << item.calls << '\t' << item.errors << '\t'
+			<< toMilliseconds(item.total) << '\t' << toMilliseconds(item.average()) << '\t'
+			<< toMilliseconds(item.minimum) << '\t' << toMilliseconds(item.median) << '\t'
+			<< toMilliseconds(item.percentile90) << '\t' << toMilliseconds(item.percentile99) << '\t'
+			<< toMilliseconds(item.maximum) << '\t' << item.memory << '\n';
+	}
+}
+bool Profiler::dump(const std::string &filename) const
+{
+	std::ofstream file(filename, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+	dump(file);
+	file.close();
+	return file.good();
+}
+}
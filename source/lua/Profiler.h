@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_LUA_PROFILER_H_
+#define GPICK_LUA_PROFILER_H_
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <chrono>
+#include <cstdint>
+struct lua_State;
+namespace lua
+{
+// Collects call counts, latencies and Lua memory growth of converters and callbacks
+struct Profiler
+{
+	struct Statistics
+	{
+		std::string name;
+		uint64_t calls, errors;
+		// All durations are in nanoseconds
+		uint64_t total, minimum, maximum, median, percentile90, percentile99;
+		// Sum of Lua heap size changes in bytes
+		int64_t memory;
+		uint64_t average() const;
+	};
+	struct Site
+	{
+		Site(const std::string &name);
+		void record(uint64_t duration, int64_t memory, bool error);
+		void reset();
+		Statistics statistics() const;
+		private:
+		std::string m_name;
+		mutable std::mutex m_mutex;
+		uint64_t m_calls, m_errors, m_total, m_minimum, m_maximum;
+		int64_t m_memory;
+		std::vector<uint64_t> m_samples;
+		size_t m_next_sample;
+	};
+	// Measures a single call. Null site makes the scope a no-op.
+	struct Scope
+	{
+		Scope(Site *site, lua_State *L);
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+		~Scope();
+		void error();
+		private:
+		Site *m_site;
+		lua_State *m_state;
+		std::chrono::steady_clock::time_point m_start;
+		int64_t m_memory;
+		bool m_error;
+	};
+	static const size_t SampleCount = 1024;
+	Profiler();
+	Profiler(const Profiler &) = delete;
+	Profiler &operator=(const Profiler &) = delete;
+	// Returns site with a given name, creating it if needed. Returned pointer stays valid for profiler lifetime.
+	Site *site(const std::string &name);
+	std::vector<Statistics> statistics() const;
+	bool statistics(const std::string &name, Statistics &result) const;
+	void reset();
+	void dump(std::ostream &stream) const;
+	bool dump(const std::string &filename) const;
+	private:
+	mutable std::mutex m_mutex;
+	std::map<std::string, std::unique_ptr<Site>> m_sites;
+};
+}
+#endif /* GPICK_LUA_PROFILER_H_ */
@@ -18,6 +18,11 @@
 
 #include "Script.h"
 #include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/stat.h>
 extern "C"{
 #include <lualib.h>
 #include <lauxlib.h>
@@ -30,12 +35,14 @@ Script::Script()
 {
 	m_state = luaL_newstate();
 	m_state_owned = true;
+	m_cache_hits = m_cache_misses = 0;
 	luaL_openlibs(m_state);
 }
 Script::Script(lua_State *state)
 {
 	m_state = state;
 	m_state_owned = false;
+	m_cache_hits = m_cache_misses = 0;
 }
 Script::~Script()
 {
@@ -131,6 +138,164 @@ bool Script::registerExtension(const char *name, std::function<int(Script &)> ex
 	lua_pop(L, 1);
 	return true;
 }
+static const char CacheMagic[] = "GPICK-LUAC";
+static const uint32_t CacheVersion = 2;
+static uint64_t hashString(const std::string &value)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (auto c: value) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+static void writeString(std::string &output, const std::string &value)
+{
+	uint32_t length = static_cast<uint32_t>(value.length());
+	output.append(reinterpret_cast<const char *>(&length), sizeof(length));
+	output.append(value);
+}
+template<typename T>
+static bool readValue(const std::string &input, size_t &offset, T &value)
+{
+	if (offset + sizeof(T) > input.length())
+		return false;
+	std::copy(input.begin() + offset, input.begin() + offset + sizeof(T), reinterpret_cast<char *>(&value));
+	offset += sizeof(T);
+	return true;
+}
+static int writeChunk(lua_State *, const void *data, size_t size, void *userdata)
+{
+	reinterpret_cast<std::string *>(userdata)->append(reinterpret_cast<const char *>(data), size);
+	return 0;
+}
+// Cache file contains magic, cache version, Lua release, script path, modification time and size, followed by source hash, bytecode hash and bytecode.
+static std::string getCacheHeader(const std::string &filename, int64_t modified, int64_t size)
+{
+	std::string header(CacheMagic, sizeof(CacheMagic));
+	header.append(reinterpret_cast<const char *>(&CacheVersion), sizeof(CacheVersion));
+	writeString(header, LUA_RELEASE);
+	writeString(header, filename);
+	header.append(reinterpret_cast<const char *>(&modified), sizeof(modified));
+	header.append(reinterpret_cast<const char *>(&size), sizeof(size));
+	return header;
+}
+bool Script::loadCached(const std::string &filename)
+{
+	lua_State *L = m_state;
+	std::string chunk_name = "@" + filename;
+	struct stat file_stat;
+	if (stat(filename.c_str(), &file_stat) != 0)
+		return luaL_loadfile(L, filename.c_str()) == 0;
+	std::string header = getCacheHeader(filename, static_cast<int64_t>(file_stat.st_mtime), static_cast<int64_t>(file_stat.st_size));
+	std::stringstream cache_name;
+	cache_name << m_cache_path << "/" << std::hex << hashString(filename) << ".luac";
+	std::ifstream source_file(filename, std::ios::in | std::ios::binary);
+	if (!source_file.is_open())
+		return luaL_loadfile(L, filename.c_str()) == 0;
+	std::string source((std::istreambuf_iterator<char>(source_file)), std::istreambuf_iterator<char>());
+	source_file.close();
+	uint64_t source_hash = hashString(source);
+	std::ifstream cache_file(cache_name.str(), std::ios::in | std::ios::binary);
+	if (cache_file.is_open()) {
+		std::string data((std::istreambuf_iterator<char>(cache_file)), std::istreambuf_iterator<char>());
+		cache_file.close();
+		size_t offset = header.length();
+		uint64_t cached_source_hash, bytecode_hash;
+		if (data.compare(0, header.length(), header) == 0 && readValue(data, offset, cached_source_hash) && readValue(data, offset, bytecode_hash) && offset < data.length()) {
+			std::string bytecode = data.substr(offset);
+			if (cached_source_hash == source_hash && bytecode_hash == hashString(bytecode)) {
+				if (luaL_loadbufferx(L, bytecode.data(), bytecode.length(), chunk_name.c_str(), "b") == 0) {
+					m_cache_hits++;
+					return true;
+				}
+				lua_pop(L, 1);
+			}
+		}
+	}
+	m_cache_misses++;
+	// Skip first line starting with '#' like luaL_loadfile does, but keep line numbering.
+	size_t start = 0;
+	if (!source.empty() && source[0] == '#') {
+		start = source.find('\n');
+		if (start == std::string::npos)
+			start = source.length();
+	}
+	if (luaL_loadbufferx(L, source.data() + start, source.length() - start, chunk_name.c_str(), "t") != 0)
+		return false;
+	std::string bytecode;
+#if LUA_VERSION_NUM >= 503
+	int status = lua_dump(L, writeChunk, &bytecode, 0);
+#else
+	int status = lua_dump(L, writeChunk, &bytecode);
+#endif
+	if (status != 0)
+		return true;
+	uint64_t bytecode_hash = hashString(bytecode);
+	std::string output = header;
+	output.append(reinterpret_cast<const char *>(&source_hash), sizeof(source_hash));
+	output.append(reinterpret_cast<const char *>(&bytecode_hash), sizeof(bytecode_hash));
+	output.append(bytecode);
+	std::stringstream temporary_name;
+	temporary_name << cache_name.str() << "." << this << ".tmp";
+	std::ofstream output_file(temporary_name.str(), std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!output_file.is_open())
+		return true;
+	output_file.write(output.data(), output.length());
+	output_file.close();
+	if (!output_file.good()) {
+		std::remove(temporary_name.str().c_str());
+		return true;
+	}
+#ifdef _WIN32
+	std::remove(cache_name.str().c_str());
+#endif
+	if (std::rename(temporary_name.str().c_str(), cache_name.str().c_str()) != 0)
+		std::remove(temporary_name.str().c_str());
+	return true;
+}
+// Replaces standard Lua file searcher, so that modules can be loaded from bytecode cache.
+int cachedSearcher(lua_State *L)
+{
+	auto &script = *reinterpret_cast<Script *>(lua_touserdata(L, lua_upvalueindex(1)));
+	const char *name = luaL_checkstring(L, 1);
+	lua_getglobal(L, "package");
+	lua_getfield(L, -1, "searchpath");
+	lua_pushstring(L, name);
+	lua_getfield(L, -3, "path");
+	lua_call(L, 2, 2);
+	if (lua_isnil(L, -2))
+		return 1;
+	std::string filename = lua_tostring(L, -2);
+	lua_pop(L, 3);
+	if (!script.loadCached(filename))
+		return luaL_error(L, "error loading module '%s' from file '%s':\n\t%s", name, filename.c_str(), lua_tostring(L, -1));
+	lua_pushstring(L, filename.c_str());
+	return 2;
+}
+void Script::setCachePath(const std::string &cache_path)
+{
+	lua_State *L = m_state;
+	m_cache_path = cache_path;
+	lua_getglobal(L, "package");
+	lua_getfield(L, -1, "searchers");
+	lua_pushlightuserdata(L, this);
+	lua_pushcclosure(L, cachedSearcher, 1);
+	lua_rawseti(L, -2, 2);
+	lua_pop(L, 2);
+}
+const std::string &Script::getCachePath() const
+{
+	return m_cache_path;
+}
+size_t Script::getCacheHits() const
+{
+	return m_cache_hits;
+}
+size_t Script::getCacheMisses() const
+{
+	return m_cache_misses;
+}
 std::string Script::getString(int index)
 {
 	return lua_tostring(m_state, index);
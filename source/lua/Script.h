@@ -21,6 +21,7 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <cstddef>
 struct lua_State;
 struct luaL_Reg;
 namespace lua
@@ -32,6 +33,11 @@ struct Script
 	~Script();
 	operator lua_State*();
 	void setPaths(const std::vector<std::string> &include_paths);
+	// Enables bytecode cache for scripts loaded with require. Cache files are written to cache_path directory.
+	void setCachePath(const std::string &cache_path);
+	const std::string &getCachePath() const;
+	size_t getCacheHits() const;
+	size_t getCacheMisses() const;
 	bool load(const char *script_name);
 	bool loadCode(const char *script_code);
 	bool run(int arguments_on_stack, int results);
@@ -43,6 +49,10 @@ struct Script
 	lua_State *m_state;
 	bool m_state_owned;
 	std::string m_last_error;
+	std::string m_cache_path;
+	size_t m_cache_hits, m_cache_misses;
+	bool loadCached(const std::string &filename);
+	friend int cachedSearcher(lua_State *L);
 };
 }
 #endif /* GPICK_LUA_SCRIPT_H_ */
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ScriptPool.h"
+#include "Script.h"
+#include "Callbacks.h"
+#include "DynvSystem.h"
+#include "Profiler.h"
+#include "../Converters.h"
+#include "../Converter.h"
+#include "../ConverterSerializePosition.h"
+#include "../dynv/Map.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+extern "C"{
+#include <lualib.h>
+#include <lauxlib.h>
+}
+namespace lua
+{
+static const size_t MinColorsPerThread = 256;
+struct ScriptPool::Entry
+{
+	Script script;
+	Converters converters;
+	Callbacks callbacks;
+	dynv::Ref options;
+	uint64_t revision;
+	bool valid;
+	Entry():
+		revision(0),
+		valid(false)
+	{
+	}
+};
+// Settings copy shared by all states synchronized to the same revision
+struct OptionsSnapshot
+{
+	std::shared_ptr<const dynv::Ref> options;
+	uint64_t revision;
+};
+struct ScriptPool::Impl
+{
+	Register m_register;
+	std::vector<std::string> m_paths;
+	std::string m_cache_path;
+	Profiler *m_profiler;
+	size_t m_max_size;
+	std::mutex m_mutex;
+	std::condition_variable m_available;
+	std::vector<std::unique_ptr<Entry>> m_entries;
+	std::vector<Entry *> m_idle;
+	const dynv::Map &m_settings;
+	std::shared_ptr<const dynv::Ref> m_options;
+	uint64_t m_settings_revision, m_revision;
+	Impl(const Register &register_extensions, const std::vector<std::string> &paths, const std::string &cache_path, Profiler *profiler, const dynv::Map &settings, size_t max_size):
+		m_register(register_extensions),
+		m_paths(paths),
+		m_cache_path(cache_path),
+		m_profiler(profiler),
+		m_max_size(max_size),
+		m_settings(settings),
+		m_settings_revision(0),
+		m_revision(0)
+	{
+		if (m_max_size == 0)
+			m_max_size = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+	// Settings are only read here, so this must be called on the thread which modifies them. Settings are copied only if they changed since the last snapshot.
+	OptionsSnapshot snapshot()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		uint64_t settings_revision = m_settings.treeChangeRevision();
+		if (!m_options || settings_revision != m_settings_revision) {
+			m_options = std::make_shared<const dynv::Ref>(m_settings.clone());
+			m_settings_revision = settings_revision;
+			m_revision++;
+		}
+		return OptionsSnapshot { m_options, m_revision };
+	}
+	std::unique_ptr<Entry> create()
+	{
+		auto entry = std::make_unique<Entry>();
+		lua_State *L = entry->script;
+		entry->converters.profiler(m_profiler);
+		entry->callbacks.profiler(m_profiler);
+		m_register(L, entry->converters, entry->callbacks);
+		entry->script.setPaths(m_paths);
+		if (!m_cache_path.empty())
+			entry->script.setCachePath(m_cache_path);
+		entry->valid = entry->script.load("init");
+		if (!entry->valid)
+			std::cerr << "Lua load error: " << entry->script.getLastError() << "\n";
+		return entry;
+	}
+	void synchronize(Entry &entry, const OptionsSnapshot &snapshot)
+	{
+		if (entry.revision == snapshot.revision)
+			return;
+		entry.revision = snapshot.revision;
+		entry.options = (*snapshot.options)->clone();
+		if (!entry.valid || !entry.callbacks.optionChange().valid())
+			return;
+		lua_State *L = entry.script;
+		int stack_top = lua_gettop(L);
+		entry.callbacks.optionChange().get();
+		pushDynvSystem(L, entry.options);
+		Profiler::Scope scope(entry.callbacks.optionChangeSite(), L);
+		int status = lua_pcall(L, 1, 0, 0);
+		if (status == 0){
+			entry.converters.builtinOptions().upperCase = entry.options->getString("gpick.options.hex_case", "upper") == "upper";
+		}else{
+			scope.error();
+			std::cerr << "optionsUpdate: " << lua_tostring(L, -1) << std::endl;
+		}
+		lua_settop(L, stack_top);
+	}
+	Entry *acquire(const OptionsSnapshot &snapshot)
+	{
+		Entry *entry = nullptr;
+		bool create_entry = false;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_available.wait(lock, [this]() {
+				return !m_idle.empty() || m_entries.size() < m_max_size;
+			});
+			if (!m_idle.empty()) {
+				entry = m_idle.back();
+				m_idle.pop_back();
+			} else {
+				m_entries.emplace_back();
+				create_entry = true;
+			}
+		}
+		if (create_entry) {
+			auto new_entry = create();
+			entry = new_entry.get();
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto &slot: m_entries) {
+				if (!slot) {
+					slot = std::move(new_entry);
+					break;
+				}
+			}
+		}
+		synchronize(*entry, snapshot);
+		return entry;
+	}
+	void release(Entry *entry)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_idle.push_back(entry);
+		}
+		m_available.notify_one();
+	}
+};
+ScriptPool::Lease::Lease(ScriptPool &pool, Entry *entry):
+	m_pool(&pool),
+	m_entry(entry)
+{
+}
+ScriptPool::Lease::Lease(Lease &&lease):
+	m_pool(lease.m_pool),
+	m_entry(lease.m_entry)
+{
+	lease.m_entry = nullptr;
+}
+ScriptPool::Lease::~Lease()
+{
+	if (m_entry)
+		m_pool->m_impl->release(m_entry);
+}
+bool ScriptPool::Lease::valid() const
+{
+	return m_entry && m_entry->valid;
+}
+Script &ScriptPool::Lease::script()
+{
+	return m_entry->script;
+}
+Converters &ScriptPool::Lease::converters()
+{
+	return m_entry->converters;
+}
+ScriptPool::ScriptPool(const Register &register_extensions, const std::vector<std::string> &paths, const std::string &cache_path, Profiler *profiler, const dynv::Map &settings, size_t max_size):
+	m_impl(std::make_unique<Impl>(register_extensions, paths, cache_path, profiler, settings, max_size))
+{
+}
+ScriptPool::~ScriptPool()
+{
+}
+ScriptPool::Lease ScriptPool::acquire()
+{
+	return Lease(*this, m_impl->acquire(m_impl->snapshot()));
+}
+size_t ScriptPool::maxSize() const
+{
+	return m_impl->m_max_size;
+}
+bool ScriptPool::serialize(const std::string &converter_name, const std::vector<ColorObject *> &color_objects, std::vector<std::string> &result)
+{
+	size_t count = color_objects.size();
+	result.clear();
+	result.resize(count);
+	if (count == 0)
+		return true;
+	size_t threads = std::min(m_impl->m_max_size, (count + MinColorsPerThread - 1) / MinColorsPerThread);
+	size_t per_thread = (count + threads - 1) / threads;
+	std::atomic<bool> failed(false);
+	// Workers only use the snapshot taken here, they never read settings
+	auto snapshot = m_impl->snapshot();
+	auto work = [&](size_t from, size_t to) {
+		Lease lease(*this, m_impl->acquire(snapshot));
+		Converter *converter = lease.valid() ? lease.converters().byName(converter_name) : nullptr;
+		if (!converter || !converter->hasSerialize()) {
+			failed = true;
+			return;
+		}
+		ConverterSerializePosition position(count);
+		for (size_t i = from; i < to; i++) {
+			position.first(i == 0);
+			position.last(i + 1 == count);
+			position.index(i);
+			result[i] = converter->serialize(*color_objects[i], position);
+		}
+	};
+	std::vector<std::thread> workers;
+	for (size_t from = per_thread; from < count; from += per_thread)
+		workers.emplace_back(work, from, std::min(from + per_thread, count));
+	work(0, std::min(per_thread, count));
+	for (auto &worker: workers)
+		worker.join();
+	return !failed;
+}
+}
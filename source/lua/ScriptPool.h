@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GPICK_LUA_SCRIPT_POOL_H_
+#define GPICK_LUA_SCRIPT_POOL_H_
+#include <memory>
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstddef>
+struct lua_State;
+struct Converters;
+struct ColorObject;
+namespace dynv {
+struct Map;
+}
+namespace lua
+{
+struct Script;
+struct Profiler;
+struct Callbacks;
+// Independent Lua states loaded with the same scripts as the main state, so converters can run on worker threads.
+struct ScriptPool
+{
+	struct Entry;
+	struct Lease
+	{
+		Lease(ScriptPool &pool, Entry *entry);
+		Lease(Lease &&lease);
+		Lease(const Lease &) = delete;
+		Lease &operator=(const Lease &) = delete;
+		~Lease();
+		bool valid() const;
+		Script &script();
+		Converters &converters();
+		private:
+		ScriptPool *m_pool;
+		Entry *m_entry;
+	};
+	// Registers extensions into a new state before scripts are loaded, converters and callbacks belong to the state
+	typedef std::function<void(lua_State *L, Converters &converters, Callbacks &callbacks)> Register;
+	ScriptPool(const Register &register_extensions, const std::vector<std::string> &paths, const std::string &cache_path, Profiler *profiler, const dynv::Map &settings, size_t max_size = 0);
+	~ScriptPool();
+	// Blocks until a state is available. Calling thread must not hold another lease.
+	// Settings are copied if they changed since the last call, so this must be called on the thread which modifies settings.
+	Lease acquire();
+	size_t maxSize() const;
+	// Settings are copied on the calling thread, worker threads only use the copy. Must be called on the thread which modifies settings.
+	bool serialize(const std::string &converter_name, const std::vector<ColorObject *> &color_objects, std::vector<std::string> &result);
+	private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+};
+}
+#endif /* GPICK_LUA_SCRIPT_POOL_H_ */
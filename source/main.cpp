@@ -17,15 +17,17 @@
  */
 
 #include "main.h"
-#include "Paths.h"
 #include "uiAbout.h"
 #include "uiApp.h"
+#include "Convert.h"
 #include "I18N.h"
 #include "version/Version.h"
 #include "dynv/Map.h"
 #include <gtk/gtk.h>
 #include <string>
+#include <vector>
 #include <iostream>
+#include <cstring>
 using namespace std;
 
 static gchar **commandline_filename = nullptr;
@@ -37,6 +39,7 @@ static gboolean single_color_pick_mode = FALSE;
 static gboolean version_information = FALSE;
 static gboolean do_not_start = FALSE;
 static gchar *converter_name = nullptr;
+static gboolean convert_mode = FALSE;
 static GOptionEntry commandline_entries[] =
 {
 	{"geometry", 'g', 0, G_OPTION_ARG_STRING, &commandline_geometry, "Window geometry", "GEOMETRY"},
@@ -47,12 +50,64 @@ static GOptionEntry commandline_entries[] =
 	{"no-start", 0, 0, G_OPTION_ARG_NONE, &do_not_start, "Do not start Gpick if it is not already running", nullptr},
 	{"converter-name", 'c', 0, G_OPTION_ARG_STRING, &converter_name, "Converter name used for floating picker mode", nullptr},
 	{"version", 'v', 0, G_OPTION_ARG_NONE, &version_information, "Print version information", nullptr},
+	{"convert", 0, 0, G_OPTION_ARG_NONE, &convert_mode, "Convert palette file INPUT to OUTPUT without starting user interface", nullptr},
 	{G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &commandline_filename, nullptr, "[FILE...]"},
 	{nullptr}
 };
+static GOptionEntry convert_entries[] =
+{
+	{"convert", 0, 0, G_OPTION_ARG_NONE, &convert_mode, "Convert palette file INPUT to OUTPUT", nullptr},
+	{"converter", 0, 0, G_OPTION_ARG_STRING, &converter_name, "Write one color per line using this converter", "NAME"},
+	{"converter-name", 'c', G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_STRING, &converter_name, nullptr, "NAME"},
+	{G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &commandline_filename, nullptr, "INPUT OUTPUT"},
+	{nullptr}
+};
+static gchar **get_command_line(char **argv)
+{
+#ifdef WIN32
+	return g_win32_get_command_line();
+#else
+	return g_strdupv(argv);
+#endif
+}
+static bool has_convert_option(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "--convert") == 0)
+			return true;
+		if (strcmp(argv[i], "--") == 0)
+			break;
+	}
+	return false;
+}
+// Parses command line without GTK options and converts palette, so no display is needed
+static int run_convert(char **argv)
+{
+	GError *error = nullptr;
+	GOptionContext *context = g_option_context_new("--convert INPUT OUTPUT - convert palette file");
+	g_option_context_add_main_entries(context, convert_entries, 0);
+	gchar **argv_copy = get_command_line(argv);
+	int return_value = -1;
+	if (!g_option_context_parse_strv(context, &argv_copy, &error)){
+		g_printerr("option parsing failed: %s\n", error->message);
+		g_clear_error(&error);
+	}else if (!commandline_filename || !commandline_filename[0] || !commandline_filename[1] || commandline_filename[2]){
+		g_printerr("--convert requires input and output file names\n");
+	}else{
+		return_value = convert_palette(commandline_filename[0], commandline_filename[1], converter_name);
+	}
+	g_option_context_free(context);
+	g_strfreev(argv_copy);
+	return return_value;
+}
 int main(int argc, char **argv)
 {
 	setlocale(LC_ALL, "");
+	if (has_convert_option(argc, argv)){
+		initialize_i18n();
+		g_set_application_name(program_name);
+		return run_convert(argv);
+	}
 	gtk_init(&argc, &argv);
 	initialize_i18n();
 	g_set_application_name(program_name);
@@ -60,12 +115,7 @@ int main(int argc, char **argv)
 	GOptionContext *context = g_option_context_new("- advanced color picker");
 	g_option_context_add_main_entries(context, commandline_entries, 0);
 	g_option_context_add_group(context, gtk_get_option_group(TRUE));
-	gchar **argv_copy;
-#ifdef WIN32
-	argv_copy = g_win32_get_command_line();
-#else
-	argv_copy  = g_strdupv(argv);
-#endif
+	gchar **argv_copy = get_command_line(argv);
 	if (!g_option_context_parse_strv(context, &argv_copy, &error)){
 		g_print("option parsing failed: %s\n", error->message);
 		g_clear_error(&error);
@@ -95,12 +145,18 @@ int main(int argc, char **argv)
 	AppArgs *args = app_create_main(options, return_value);
 	if (args){
 		if (!single_color_pick_mode){
-			if (commandline_filename){
+			if (commandline_filename && commandline_filename[0] && commandline_filename[1]){
+				vector<string> filenames;
+				for (size_t i = 0; commandline_filename[i]; i++)
+					filenames.push_back(commandline_filename[i]);
+				app_load_files(args, filenames);
+			}else if (commandline_filename && commandline_filename[0] && g_file_test(commandline_filename[0], G_FILE_TEST_IS_DIR)){
+				app_load_files(args, vector<string>{commandline_filename[0]});
+			}else if (commandline_filename){
 				app_load_file(args, commandline_filename[0]);
 			}else{
 				if (app_is_autoload_enabled(args)){
-					auto autosaveFile = buildConfigPath("autosave.gpa");
-					app_load_file(args, autosaveFile, true);
+					app_load_autosave(args);
 				}
 			}
 		}
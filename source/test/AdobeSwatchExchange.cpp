@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "AdobeSwatchExchange.h"
+#include "ColorObject.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <cstring>
+namespace {
+struct Decoded {
+	std::vector<std::string> names;
+	std::vector<Color> colors;
+	bool decode(const std::string &data) {
+		names.clear();
+		colors.clear();
+		return ase::decode(reinterpret_cast<const uint8_t *>(data.data()), data.size(), [this](const std::string &name, const Color &color) {
+			names.push_back(name);
+			colors.push_back(color);
+		});
+	}
+};
+std::string colorBlock(const char *colorSpace, const std::vector<float> &values) {
+	std::string block("\x00\x01\x00\x00\x00\x00\x00\x02\x00\x41\x00\x00", 12);
+	block.append(colorSpace, 4);
+	for (float value: values) {
+		uint32_t intValue;
+		memcpy(&intValue, &value, sizeof(intValue));
+		for (int shift = 24; shift >= 0; shift -= 8)
+			block += static_cast<char>(intValue >> shift);
+	}
+	block.append(2, '\0');
+	uint32_t size = static_cast<uint32_t>(block.size() - 6);
+	block[4] = static_cast<char>(size >> 8);
+	block[5] = static_cast<char>(size);
+	return block;
+}
+std::string header(uint32_t blocks) {
+	std::string data("ASEF\x00\x01\x00\x00\x00\x00\x00", 11);
+	data += static_cast<char>(blocks);
+	return data;
+}
+}
+BOOST_AUTO_TEST_SUITE(adobeSwatchExchange);
+BOOST_AUTO_TEST_CASE(encodeLayout) {
+	ColorObject colorObject("A", Color(1.0f, 0.0f, 0.0f));
+	std::string data;
+	ase::encode({ &colorObject }, data);
+	std::string expected("ASEF\x00\x01\x00\x00\x00\x00\x00\x01" "\x00\x01\x00\x00\x00\x18\x00\x02\x00\x41\x00\x00" "RGB " "\x3f\x80\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00", 42);
+	BOOST_CHECK(data == expected);
+}
+BOOST_AUTO_TEST_CASE(roundTrip) {
+	std::vector<std::string> names = { "", "plain", "ąčę žalia", "\xf0\x9f\x8e\xa8 palette", "bad \xff utf-8", std::string(70000, 'x') };
+	std::vector<ColorObject> colorObjects;
+	for (size_t i = 0; i < names.size(); i++)
+		colorObjects.emplace_back(names[i], Color(i / 10.0f, 0.25f, 1.0f));
+	std::vector<ColorObject *> pointers;
+	for (auto &colorObject: colorObjects)
+		pointers.push_back(&colorObject);
+	std::string data;
+	ase::encode(pointers, data);
+	Decoded decoded;
+	BOOST_REQUIRE(decoded.decode(data));
+	BOOST_REQUIRE_EQUAL(decoded.names.size(), names.size());
+	for (size_t i = 0; i < 4; i++)
+		BOOST_CHECK_EQUAL(decoded.names[i], names[i]);
+	BOOST_CHECK_EQUAL(decoded.names[4], "bad \xef\xbf\xbd utf-8");
+	BOOST_CHECK_EQUAL(decoded.names[5].length(), 0xfffeu);
+	for (size_t i = 0; i < names.size(); i++)
+		BOOST_CHECK(decoded.colors[i] == colorObjects[i].getColor());
+}
+BOOST_AUTO_TEST_CASE(colorSpaces) {
+	color_init();
+	std::string data = header(5) + colorBlock("Gray", { 0.5f }) + colorBlock("CMYK", { 0, 1, 1, 0 }) + colorBlock("LAB ", { 1, 0, 0 }) + colorBlock("HSV ", { 0, 0, 0 });
+	data += std::string("\xc0\x01\x00\x00\x00\x00", 6); // empty group start
+	Decoded decoded;
+	BOOST_REQUIRE(decoded.decode(data));
+	BOOST_REQUIRE_EQUAL(decoded.colors.size(), 3u);
+	BOOST_CHECK_EQUAL(decoded.names[0], "A");
+	BOOST_CHECK_CLOSE(decoded.colors[0].rgb.green, 0.5f, 0.001f);
+	BOOST_CHECK_CLOSE(decoded.colors[1].rgb.red, 1.0f, 0.001f);
+	BOOST_CHECK_SMALL(decoded.colors[1].rgb.green, 0.001f);
+	BOOST_CHECK_CLOSE(decoded.colors[2].rgb.blue, 1.0f, 0.1f);
+}
+BOOST_AUTO_TEST_CASE(truncated) {
+	std::string data = header(3) + colorBlock("RGB ", { 1, 1, 1 }) + colorBlock("CMYK", { 0, 0, 0, 0 }) + colorBlock("Gray", { 0 });
+	Decoded decoded;
+	BOOST_CHECK(decoded.decode(data));
+	BOOST_CHECK_EQUAL(decoded.colors.size(), 3u);
+	for (size_t length = 0; length < data.size(); length++) {
+		bool blockBoundary = length == 12 || length == 12 + 30 || length == 12 + 30 + 34;
+		BOOST_CHECK_EQUAL(decoded.decode(data.substr(0, length)), blockBoundary);
+	}
+	BOOST_CHECK(!decoded.decode("ASEX" + data.substr(4)));
+}
+BOOST_AUTO_TEST_CASE(fuzz) {
+	std::vector<ColorObject> colorObjects;
+	for (int i = 0; i < 8; i++)
+		colorObjects.emplace_back("color \xc4\x85 " + std::to_string(i), Color(i / 8.0f));
+	std::vector<ColorObject *> pointers;
+	for (auto &colorObject: colorObjects)
+		pointers.push_back(&colorObject);
+	std::string valid;
+	ase::encode(pointers, valid);
+	valid += colorBlock("LAB ", { 0.5f, 10, -10 }) + colorBlock("CMYK", { 0.1f, 0.2f, 0.3f, 0.4f });
+	valid[11] = 10;
+	std::mt19937 generator(2020);
+	std::uniform_int_distribution<int> byte(0, 255);
+	Decoded decoded;
+	for (int i = 0; i < 20000; i++) {
+		std::string data = valid;
+		std::uniform_int_distribution<size_t> position(0, data.size() - 1);
+		for (int j = 1 + i % 8; j > 0; j--)
+			data[position(generator)] = static_cast<char>(byte(generator));
+		if (i % 3 == 0)
+			data.resize(position(generator));
+		// Decoder must stay inside data, only the result is not important
+		decoded.decode(data);
+		BOOST_REQUIRE_LE(decoded.names.size(), 10u);
+	}
+}
+BOOST_AUTO_TEST_SUITE_END()
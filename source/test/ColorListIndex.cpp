@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "ColorListIndex.h"
+#include "ColorObject.h"
+#include "Color.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+namespace {
+struct Objects {
+	std::vector<ColorObject *> colorObjects;
+	~Objects() {
+		for (auto colorObject: colorObjects)
+			colorObject->release();
+	}
+	ColorObject *add(ColorListIndex &index, const std::string &name, const Color &color) {
+		auto colorObject = new ColorObject(name, color);
+		colorObjects.push_back(colorObject);
+		index.add(colorObject);
+		return colorObject;
+	}
+};
+std::vector<ColorObject *> findByName(const ColorListIndex &index, const std::string &text) {
+	std::vector<ColorObject *> result;
+	index.findByName(text, [&result](ColorObject *colorObject) {
+		result.push_back(colorObject);
+		return true;
+	});
+	std::sort(result.begin(), result.end());
+	return result;
+}
+std::vector<ColorObject *> findByColor(const ColorListIndex &index, const Color &color, float distance) {
+	std::vector<ColorObject *> result;
+	index.findByColor(color, distance, [&result](ColorObject *colorObject, float) {
+		result.push_back(colorObject);
+		return true;
+	});
+	std::sort(result.begin(), result.end());
+	return result;
+}
+std::vector<ColorObject *> sorted(std::vector<ColorObject *> colorObjects) {
+	std::sort(colorObjects.begin(), colorObjects.end());
+	return colorObjects;
+}
+}
+BOOST_AUTO_TEST_SUITE(colorListIndex);
+BOOST_AUTO_TEST_CASE(nameTrigrams) {
+	color_init();
+	ColorListIndex index;
+	Objects objects;
+	auto red = objects.add(index, "Dark Red", Color(0.5f, 0.0f, 0.0f));
+	auto redder = objects.add(index, "redder", Color(1.0f, 0.0f, 0.0f));
+	auto blue = objects.add(index, "Blue", Color(0.0f, 0.0f, 1.0f));
+	BOOST_CHECK_EQUAL(index.size(), 3u);
+	BOOST_CHECK(findByName(index, "RED") == sorted({ red, redder }));
+	BOOST_CHECK(findByName(index, "k re") == std::vector<ColorObject *>{ red });
+	BOOST_CHECK(findByName(index, "reddest").empty());
+	// Queries shorter than a trigram are matched without the trigram table
+	BOOST_CHECK(findByName(index, "e") == sorted({ red, redder, blue }));
+	BOOST_CHECK(findByName(index, "").size() == 3u);
+	size_t calls = 0;
+	index.findByName("red", [&calls](ColorObject *) {
+		calls++;
+		return false;
+	});
+	BOOST_CHECK_EQUAL(calls, 1u);
+}
+BOOST_AUTO_TEST_CASE(labGrid) {
+	color_init();
+	ColorListIndex index;
+	Objects objects;
+	auto gray = objects.add(index, "gray", Color(0.5f));
+	auto lighterGray = objects.add(index, "lighter gray", Color(0.51f));
+	auto white = objects.add(index, "white", Color(1.0f));
+	auto black = objects.add(index, "black", Color(0.0f));
+	BOOST_CHECK(findByColor(index, Color(0.5f), 0.1f) == std::vector<ColorObject *>{ gray });
+	BOOST_CHECK(findByColor(index, Color(0.505f), 2.0f) == sorted({ gray, lighterGray }));
+	BOOST_CHECK(findByColor(index, Color(1.0f), 1.0f) == std::vector<ColorObject *>{ white });
+	BOOST_CHECK(findByColor(index, Color(0.0f), 1.0f) == std::vector<ColorObject *>{ black });
+	// Search range crosses many grid cells
+	BOOST_CHECK_EQUAL(findByColor(index, Color(0.5f), 200.0f).size(), 4u);
+	// Callback receives CIE76 distance
+	Color query(0.505f), queryLab, grayLab;
+	color_rgb_to_lab_d50(&query, &queryLab);
+	color_rgb_to_lab_d50(&gray->getColor(), &grayLab);
+	index.findByColor(query, 2.0f, [&](ColorObject *colorObject, float distance) {
+		if (colorObject == gray)
+			BOOST_CHECK_CLOSE(distance, std::abs(queryLab.lab.L - grayLab.lab.L), 1.0f);
+		return true;
+	});
+}
+BOOST_AUTO_TEST_CASE(update) {
+	color_init();
+	ColorListIndex index;
+	Objects objects;
+	auto colorObject = objects.add(index, "red", Color(1.0f, 0.0f, 0.0f));
+	colorObject->setName("green");
+	colorObject->setColor(Color(0.0f, 1.0f, 0.0f));
+	// Index keeps old values until it is told about the change
+	BOOST_CHECK(findByName(index, "red") == std::vector<ColorObject *>{ colorObject });
+	index.update(colorObject);
+	BOOST_CHECK(findByName(index, "red").empty());
+	BOOST_CHECK(findByName(index, "green") == std::vector<ColorObject *>{ colorObject });
+	BOOST_CHECK(findByColor(index, Color(1.0f, 0.0f, 0.0f), 5.0f).empty());
+	BOOST_CHECK(findByColor(index, Color(0.0f, 1.0f, 0.0f), 5.0f) == std::vector<ColorObject *>{ colorObject });
+	// Adding an indexed object again updates it
+	colorObject->setName("blue");
+	index.add(colorObject);
+	BOOST_CHECK_EQUAL(index.size(), 1u);
+	BOOST_CHECK(findByName(index, "blue") == std::vector<ColorObject *>{ colorObject });
+	BOOST_CHECK(findByName(index, "green").empty());
+}
+BOOST_AUTO_TEST_CASE(remove) {
+	color_init();
+	ColorListIndex index;
+	Objects objects;
+	auto first = objects.add(index, "first color", Color(0.2f));
+	auto second = objects.add(index, "second color", Color(0.2f));
+	BOOST_CHECK(index.contains(first));
+	index.remove(first);
+	BOOST_CHECK(!index.contains(first));
+	BOOST_CHECK_EQUAL(index.size(), 1u);
+	BOOST_CHECK(findByName(index, "color") == std::vector<ColorObject *>{ second });
+	BOOST_CHECK(findByColor(index, Color(0.2f), 1.0f) == std::vector<ColorObject *>{ second });
+	index.remove(first);
+	BOOST_CHECK_EQUAL(index.size(), 1u);
+	index.clear();
+	BOOST_CHECK_EQUAL(index.size(), 0u);
+	BOOST_CHECK(findByName(index, "color").empty());
+	BOOST_CHECK(findByColor(index, Color(0.2f), 1.0f).empty());
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "ConverterSignature.h"
+BOOST_AUTO_TEST_CASE(converter_signature_input_features) {
+	using Input = ConverterSignature::Input;
+	BOOST_CHECK(Input("").features() == 0);
+	BOOST_CHECK(Input("").length() == 0);
+	BOOST_CHECK(Input("#ff0000").features() == (ConverterSignature::hash3 | ConverterSignature::hash6 | ConverterSignature::hex3 | ConverterSignature::hex6 | ConverterSignature::digit));
+	BOOST_CHECK(Input("#ff0000").length() == 7);
+	BOOST_CHECK(Input("#abc").features() == (ConverterSignature::hash3 | ConverterSignature::hex3));
+	BOOST_CHECK(Input("# abcdef").features() == (ConverterSignature::hex3 | ConverterSignature::hex6));
+	BOOST_CHECK(Input("ab#12").features() == ConverterSignature::digit);
+	BOOST_CHECK(Input("rgb(1, 2, 3)").features() == (ConverterSignature::rgb | ConverterSignature::digit));
+	BOOST_CHECK(Input("x HSL(1, 2%, 3%)").features() == (ConverterSignature::hsl | ConverterSignature::digit));
+	BOOST_CHECK(Input("rgb (1)").features() == ConverterSignature::digit);
+	BOOST_CHECK(Input("rg").features() == 0);
+}
+BOOST_AUTO_TEST_CASE(converter_signature_matches) {
+	using Input = ConverterSignature::Input;
+	ConverterSignature any;
+	BOOST_CHECK(any.empty());
+	BOOST_CHECK(any.matches(Input("")));
+	ConverterSignature hex(ConverterSignature::featureByName("hash6"), 7);
+	BOOST_CHECK(!hex.empty());
+	BOOST_CHECK(hex.matches(Input("#123456")));
+	BOOST_CHECK(!hex.matches(Input("#12345")));
+	BOOST_CHECK(!hex.matches(Input("rgb(1, 2, 3)")));
+	ConverterSignature rgb(ConverterSignature::rgb | ConverterSignature::digit, 7);
+	BOOST_CHECK(rgb.matches(Input("rgb(1,2,3)")));
+	BOOST_CHECK(!rgb.matches(Input("rgb(")));
+	BOOST_CHECK(ConverterSignature::featureByName("unknown") == 0);
+}
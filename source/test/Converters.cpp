@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "lua/Script.h"
+#include "lua/Color.h"
+#include "lua/ColorObject.h"
+#include "lua/Ref.h"
+#include "BuiltinConverters.h"
+#include "Converter.h"
+#include "ConverterSerializePosition.h"
+#include "ConverterSignature.h"
+#include "ColorObject.h"
+#include "Color.h"
+#include <vector>
+#include <string>
+extern "C" {
+#include <lualib.h>
+#include <lauxlib.h>
+}
+using namespace lua;
+namespace {
+const char *converterNames[] = {
+	"color_web_hex",
+	"color_web_hex_3_digit",
+	"color_web_hex_no_hash",
+	"color_css_hsl",
+	"color_css_rgb",
+	"css_color_hex",
+	"css_background_color_hex",
+	"css_border_color_hex",
+	"css_border_top_color_hex",
+	"css_border_right_color_hex",
+	"css_border_bottom_color_hex",
+	"css_border_left_hex",
+	"color_csv",
+	"color_css_block",
+};
+const char *setupCode = R"(
+local converters = {}
+package.loaded['gpick'] = {
+	addConverter = function(self, name, label, serialize, deserialize)
+		converters[name] = { serialize = serialize, deserialize = deserialize }
+	end,
+	setConverterSignature = function(self, name, features, minLength)
+		converters[name].features = features
+		converters[name].minLength = minLength or 0
+	end,
+	_ = function(text) return text end,
+	version = 'test',
+}
+package.loaded['options'] = { upperCase = false }
+require('converters')
+return converters
+)";
+struct LuaConverters {
+	LuaConverters() {
+		script.registerExtension("color", registerColor);
+		script.registerExtension("colorObject", registerColorObject);
+		script.setPaths({ "share/gpick", "../share/gpick" });
+		valid = script.loadCode(setupCode) && script.run(0, 1);
+		if (valid)
+			converters = luaL_ref(script, LUA_REGISTRYINDEX);
+	}
+	void upperCase(bool value) {
+		lua_State *L = script;
+		lua_getglobal(L, "package");
+		lua_getfield(L, -1, "loaded");
+		lua_getfield(L, -1, "options");
+		lua_pushboolean(L, value);
+		lua_setfield(L, -2, "upperCase");
+		lua_pop(L, 3);
+	}
+	bool getFunction(const char *name, const char *type) {
+		lua_State *L = script;
+		lua_rawgeti(L, LUA_REGISTRYINDEX, converters);
+		lua_getfield(L, -1, name);
+		if (lua_type(L, -1) != LUA_TTABLE) {
+			lua_pop(L, 2);
+			return false;
+		}
+		lua_getfield(L, -1, type);
+		lua_remove(L, -2);
+		lua_remove(L, -2);
+		if (lua_type(L, -1) != LUA_TFUNCTION) {
+			lua_pop(L, 1);
+			return false;
+		}
+		return true;
+	}
+	bool serialize(const char *name, ColorObject &colorObject, const ConverterSerializePosition &position, std::string &result) {
+		lua_State *L = script;
+		int stackTop = lua_gettop(L);
+		if (!getFunction(name, "serialize"))
+			return false;
+		pushColorObject(L, &colorObject);
+		lua_newtable(L);
+		lua_pushboolean(L, position.first());
+		lua_setfield(L, -2, "first");
+		lua_pushboolean(L, position.last());
+		lua_setfield(L, -2, "last");
+		lua_pushinteger(L, position.index());
+		lua_setfield(L, -2, "index");
+		lua_pushinteger(L, position.count());
+		lua_setfield(L, -2, "count");
+		bool status = lua_pcall(L, 2, 1, 0) == 0 && lua_type(L, -1) == LUA_TSTRING;
+		if (status)
+			result = lua_tostring(L, -1);
+		lua_settop(L, stackTop);
+		return status;
+	}
+	bool signature(const char *name, ConverterSignature &result) {
+		lua_State *L = script;
+		int stackTop = lua_gettop(L);
+		lua_rawgeti(L, LUA_REGISTRYINDEX, converters);
+		lua_getfield(L, -1, name);
+		lua_getfield(L, -1, "features");
+		if (lua_type(L, -1) != LUA_TTABLE) {
+			lua_settop(L, stackTop);
+			return false;
+		}
+		uint32_t features = 0;
+		for (int i = 1, end = static_cast<int>(lua_rawlen(L, -1)); i <= end; i++) {
+			lua_rawgeti(L, -1, i);
+			features |= ConverterSignature::featureByName(lua_tostring(L, -1));
+			lua_pop(L, 1);
+		}
+		lua_getfield(L, -2, "minLength");
+		result = ConverterSignature(features, static_cast<size_t>(lua_tointeger(L, -1)));
+		lua_settop(L, stackTop);
+		return true;
+	}
+	bool deserialize(const char *name, const char *value, ColorObject &colorObject, float &quality) {
+		lua_State *L = script;
+		int stackTop = lua_gettop(L);
+		if (!getFunction(name, "deserialize"))
+			return false;
+		lua_pushstring(L, value);
+		pushColorObject(L, &colorObject);
+		bool status = lua_pcall(L, 2, 1, 0) == 0 && lua_type(L, -1) == LUA_TNUMBER;
+		if (status)
+			quality = static_cast<float>(lua_tonumber(L, -1));
+		lua_settop(L, stackTop);
+		return status;
+	}
+	Script script;
+	bool valid;
+	int converters;
+};
+const char *deserializeValues[] = {
+	"", "#", "abc", "#ff0000", "#FF00aa;", "color: #abc", "#abcd", "#12345", "x #123456 y", "#1234567", "123456", "ab12cd34ef",
+	"rgb(1, 2, 3)", "rgb( 1,2,3)", "rgb(1 ,\t2 ,3)", "rgb(,2,3)", "rgb(300, 20 , 1)", "rgb(1,2,3", "rgb(1 2 3)",
+	"x rgb(1, 2, 3) and rgb(4,5,6)", "rgb(0001, 0255, 99999999999999999999)", "#ABC", "RGB(1, 2, 3)",
+};
+bool inRange(const Color &color) {
+	for (int i = 0; i < 3; i++) {
+		if (color.ma[i] < 0 || color.ma[i] > 1)
+			return false;
+	}
+	return true;
+}
+std::vector<Color> getColors() {
+	std::vector<float> values = { 0.0f, 1.0f, 0.5f, 0.25f, 0.123456f, 0.999f, 1e-6f, -0.1f, 1.2f, 2.5f / 255, 127.5f / 255, 1.0f / 30, 0.5f / 15 };
+	for (int i = 0; i <= 255; i += 5)
+		values.push_back(i / 255.0f);
+	for (int i = 0; i < 255; i += 3)
+		values.push_back((i + 0.5f) / 255.0f);
+	std::vector<Color> result;
+	for (size_t i = 0; i < values.size(); i++)
+		result.emplace_back(values[i], values[(i * 7 + 3) % values.size()], values[(i * 13 + 5) % values.size()]);
+	return result;
+}
+}
+BOOST_AUTO_TEST_CASE(builtin_converters_serialize) {
+	LuaConverters luaConverters;
+	BOOST_REQUIRE(luaConverters.valid);
+	BuiltinConverterOptions options;
+	options.version = "test";
+	auto colors = getColors();
+	const char *names[] = { "", "red", "name with spaces" };
+	for (auto name: converterNames) {
+		auto builtin = getBuiltinConverter(name);
+		BOOST_REQUIRE(builtin != nullptr);
+		BOOST_REQUIRE(builtin->serialize != nullptr);
+		for (int upperCase = 0; upperCase < 2; upperCase++) {
+			options.upperCase = upperCase != 0;
+			luaConverters.upperCase(options.upperCase);
+			for (size_t i = 0; i < colors.size(); i++) {
+				ColorObject colorObject(names[i % 3], colors[i]);
+				ConverterSerializePosition position(3);
+				position.first(i % 2 == 0);
+				position.last(i % 3 == 0);
+				std::string luaResult, nativeResult;
+				BOOST_REQUIRE(luaConverters.serialize(name, colorObject, position, luaResult));
+				bool serialized = builtin->serialize(colorObject, position, options, nativeResult);
+				// Native converters may only leave colors outside of RGB range to Lua
+				BOOST_CHECK_MESSAGE(serialized || !inRange(colors[i]), name << ": native converter refused color " << i);
+				if (!serialized)
+					continue;
+				BOOST_CHECK_MESSAGE(luaResult == nativeResult, name << ": \"" << nativeResult << "\" != \"" << luaResult << "\"");
+			}
+		}
+	}
+}
+BOOST_AUTO_TEST_CASE(builtin_converters_deserialize) {
+	LuaConverters luaConverters;
+	BOOST_REQUIRE(luaConverters.valid);
+	for (auto name: converterNames) {
+		auto builtin = getBuiltinConverter(name);
+		BOOST_REQUIRE(builtin != nullptr);
+		if (!builtin->deserialize)
+			continue;
+		for (auto value: deserializeValues) {
+			ColorObject luaColorObject("", Color(0.1f, 0.2f, 0.3f)), nativeColorObject("", Color(0.1f, 0.2f, 0.3f));
+			float luaQuality = 0, nativeQuality = 0;
+			bool luaStatus = luaConverters.deserialize(name, value, luaColorObject, luaQuality);
+			bool nativeStatus = builtin->deserialize(value, nativeColorObject, nativeQuality);
+			BOOST_CHECK_MESSAGE(luaStatus == nativeStatus, name << ": status differs for \"" << value << "\"");
+			if (!luaStatus || !nativeStatus)
+				continue;
+			BOOST_CHECK_MESSAGE(luaQuality == nativeQuality, name << ": quality differs for \"" << value << "\"");
+			BOOST_CHECK_MESSAGE(luaColorObject.getColor() == nativeColorObject.getColor(), name << ": color differs for \"" << value << "\"");
+		}
+	}
+}
+BOOST_AUTO_TEST_CASE(converter_signatures_match_accepted_values) {
+	LuaConverters luaConverters;
+	BOOST_REQUIRE(luaConverters.valid);
+	for (auto name: converterNames) {
+		ConverterSignature signature;
+		if (!luaConverters.signature(name, signature))
+			continue;
+		BOOST_CHECK(!signature.empty());
+		for (auto value: deserializeValues) {
+			ColorObject colorObject;
+			float quality = 0;
+			if (!luaConverters.deserialize(name, value, colorObject, quality) || quality <= 0)
+				continue;
+			BOOST_CHECK_MESSAGE(signature.matches(ConverterSignature::Input(value)), name << ": signature rejects \"" << value << "\"");
+		}
+	}
+}
+namespace {
+const char *batchCode = R"(
+batches = 0
+local function serialize(colorObject, position)
+	local text = colorObject:getName() .. ' ' .. position.index .. '/' .. position.count
+	if position.first then text = text .. ' first' end
+	if position.last then text = text .. ' last' end
+	return text
+end
+local function serializeMany(colorObjects)
+	batches = batches + 1
+	local result = {}
+	for i, colorObject in ipairs(colorObjects) do
+		result[i] = serialize(colorObject, { index = i - 1, count = #colorObjects, first = i == 1, last = i == #colorObjects })
+	end
+	return result
+end
+local function shortSerializeMany(colorObjects)
+	batches = batches + 1
+	return { 'only one' }
+end
+return serialize, serializeMany, shortSerializeMany, nil
+)";
+// Lua serialize function with serializeMany variants at stack indices 1 to 4
+struct BatchConverter {
+	BatchConverter() {
+		script.registerExtension("color", registerColor);
+		script.registerExtension("colorObject", registerColorObject);
+		valid = script.loadCode(batchCode) && script.run(0, 4);
+		for (int i = 0; i < 3; i++)
+			colorObjects.push_back(new ColorObject("color " + std::to_string(i), Color(i / 3.0f)));
+	}
+	~BatchConverter() {
+		for (auto colorObject: colorObjects)
+			colorObject->release();
+	}
+	int batches() {
+		lua_State *L = script;
+		lua_getglobal(L, "batches");
+		int result = static_cast<int>(lua_tointeger(L, -1));
+		lua_pop(L, 1);
+		return result;
+	}
+	// Serializes each color separately with positions set the same way as for a batch
+	std::vector<std::string> serializeEach(Converter &converter) {
+		std::vector<std::string> result;
+		ConverterSerializePosition position(colorObjects.size());
+		for (size_t i = 0; i < colorObjects.size(); i++) {
+			position.first(i == 0);
+			position.last(i + 1 == colorObjects.size());
+			position.index(i);
+			result.push_back(converter.serialize(*colorObjects[i], position));
+		}
+		return result;
+	}
+	Script script;
+	bool valid;
+	std::vector<ColorObject *> colorObjects;
+};
+const std::vector<std::string> batchExpected = { "color 0 0/3 first", "color 1 1/3", "color 2 2/3 last" };
+}
+BOOST_AUTO_TEST_CASE(converter_serialize_many) {
+	BatchConverter batch;
+	BOOST_REQUIRE(batch.valid);
+	Converter converter("test", "test", Ref(batch.script, 1), Ref(), Ref(batch.script, 2));
+	BOOST_CHECK(converter.hasSerializeMany());
+	auto result = converter.serialize(batch.colorObjects);
+	BOOST_CHECK_EQUAL(batch.batches(), 1);
+	BOOST_CHECK(result == batch.serializeEach(converter));
+	BOOST_CHECK(result == batchExpected);
+	BOOST_CHECK(converter.serialize(std::vector<ColorObject *>()).empty());
+}
+BOOST_AUTO_TEST_CASE(converter_serialize_many_fallback) {
+	BatchConverter batch;
+	BOOST_REQUIRE(batch.valid);
+	// Without serializeMany, colors are serialized one by one
+	Converter converter("test", "test", Ref(batch.script, 1), Ref());
+	BOOST_CHECK(!converter.hasSerializeMany());
+	auto result = converter.serialize(batch.colorObjects);
+	BOOST_CHECK(result == batch.serializeEach(converter));
+	BOOST_CHECK(result == batchExpected);
+	// Result with wrong length is discarded
+	Converter shortConverter("test", "test", Ref(batch.script, 1), Ref(), Ref(batch.script, 3));
+	BOOST_CHECK(shortConverter.serialize(batch.colorObjects) == batchExpected);
+	BOOST_CHECK_EQUAL(batch.batches(), 1);
+	// Converters registered with nil serializeMany get an empty reference, but nil references must not break serialization either
+	Converter nilConverter("test", "test", Ref(batch.script, 1), Ref(), Ref(batch.script, 4));
+	BOOST_CHECK(nilConverter.serialize(batch.colorObjects) == batchExpected);
+}
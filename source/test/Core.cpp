@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "Core.h"
+#include "transformation/Quantization.h"
+#include <string>
+#include <memory>
+#include <cstdio>
+BOOST_AUTO_TEST_SUITE(coreLibrary);
+BOOST_AUTO_TEST_CASE(serializeColor) {
+	ColorObject colorObject("test", Color(1.0f, 0.5f, 0.0f));
+	std::string result = "color: ";
+	BOOST_CHECK(core::serializeColor("color_web_hex", colorObject, result));
+	BOOST_CHECK_EQUAL(result, "color: #ff8000");
+	result.clear();
+	BOOST_CHECK(core::serializeColor("color_web_hex", colorObject, result, true));
+	BOOST_CHECK_EQUAL(result, "#FF8000");
+	BOOST_CHECK(!core::serializeColor("unknown_converter", colorObject, result));
+	BOOST_CHECK_EQUAL(result, "#FF8000");
+}
+BOOST_AUTO_TEST_CASE(paletteRoundTrip) {
+	const char *filename = "core_test.gpl";
+	ColorList *colorList = color_list_new();
+	for (int i = 0; i < 10; i++) {
+		ColorObject colorObject("color " + std::to_string(i), Color(i / 9.0f));
+		color_list_add_color_object(colorList, colorObject, true);
+	}
+	BOOST_REQUIRE(core::exportPalette(colorList, filename));
+	ColorList *imported = color_list_new();
+	BOOST_REQUIRE(core::importPalette(imported, filename));
+	std::remove(filename);
+	BOOST_REQUIRE_EQUAL(imported->colors.size(), 10u);
+	BOOST_CHECK_EQUAL(imported->colors.back()->getName(), "color 9");
+	BOOST_CHECK(!core::exportPalette(colorList, "core_test.txt"));
+	color_list_destroy(imported);
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_CASE(transformColors) {
+	ColorList *colorList = color_list_new();
+	color_list_add_color_object(colorList, ColorObject("test", Color(0.3f)), true);
+	transformation::Chain chain;
+	chain.setEnabled(true);
+	chain.add(std::make_unique<transformation::Quantization>(2.0f));
+	core::transformColors(colorList, chain);
+	BOOST_CHECK_CLOSE(colorList->colors.front()->getColor().rgb.red, 0.0f, 0.001f);
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,7 +20,10 @@
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include "dynv/Map.h"
+#include "dynv/Variable.h"
+#include "dynv/Handle.h"
 #include "Color.h"
 using Map = dynv::Map;
 using Ref = dynv::Ref;
@@ -179,6 +182,53 @@ BOOST_AUTO_TEST_CASE(xmlSerializeDeserialize) {
 		BOOST_CHECK_EQUAL(resultItems[i]->getColor("color", nullColor), Color(static_cast<float>(1.0f / (10 - 1) * i)));
 	}
 }
+BOOST_AUTO_TEST_CASE(xmlSerializeExact) {
+	Map map;
+	map.set("a.bool", true);
+	map.set("a.int32", -15);
+	map.set("float", 0.125f);
+	map.set("plain", "text");
+	map.set("escaped", "<a & b>");
+	map.set("ints", std::vector<int32_t> { 1, 2 });
+	map.set("colors", std::vector<Color> { Color(0.5f, 0.25f, 1.0f) });
+	std::stringstream output;
+	BOOST_REQUIRE(map.serializeXml(output));
+	BOOST_CHECK_EQUAL(output.str(), "<?xml version=\"1.0\" encoding=\"UTF-8\"?><root>"
+		"<a type=\"dynv\"><bool type=\"bool\">true</bool><int32 type=\"int32\">-15</int32></a>"
+		"<colors type=\"color\" list=\"true\"><li>0.5 0.25 1 0</li></colors>"
+		"<escaped type=\"string\">&lt;a &amp; b&gt;</escaped>"
+		"<float type=\"float\">0.125</float>"
+		"<ints type=\"int32\" list=\"true\"><li>1</li><li>2</li></ints>"
+		"<plain type=\"string\">text</plain>"
+		"</root>");
+}
+BOOST_AUTO_TEST_CASE(xmlRoundTrip) {
+	Map map;
+	std::string longText(100000, 'x');
+	longText[500] = '&';
+	map.set("long", longText);
+	std::vector<Ref> items;
+	for (int i = 0; i < 1000; i++) {
+		auto item = Map::create();
+		item->set("name", "item <" + std::to_string(i) + ">");
+		item->set("value", i * 0.001f);
+		items.push_back(item);
+	}
+	map.set("items", items);
+	std::stringstream output;
+	BOOST_REQUIRE(map.serializeXml(output));
+	auto text = output.str();
+	std::stringstream input(text);
+	Map result;
+	BOOST_REQUIRE(result.deserializeXml(input));
+	BOOST_CHECK_EQUAL(result.getString("long", ""), longText);
+	auto resultItems = result.getMaps("items");
+	BOOST_REQUIRE_EQUAL(resultItems.size(), 1000);
+	BOOST_CHECK_EQUAL(resultItems[999]->getString("name", ""), "item <999>");
+	std::stringstream resultOutput;
+	BOOST_REQUIRE(result.serializeXml(resultOutput));
+	BOOST_CHECK(resultOutput.str() == text);
+}
 BOOST_AUTO_TEST_CASE(missingPathSegmentCreationOnSet) {
 	Map map;
 	map.set("values.bool", true);
@@ -244,4 +294,157 @@ BOOST_AUTO_TEST_CASE(spans) {
 	BOOST_CHECK_EQUAL(map.getInt32s("ints").size(), 3);
 	BOOST_CHECK_EQUAL(map.getStrings("strings").size(), 3);
 }
+BOOST_AUTO_TEST_CASE(treeSerializeDeserialize) {
+	Map map;
+	std::vector<Ref> items;
+	for (int i = 0; i < 3; i++) {
+		Ref item(new Map());
+		item->set("name", "item " + std::to_string(i));
+		item->set("color", Color(i / 3.0f));
+		items.push_back(item);
+	}
+	map.set("items", items);
+	map.set("a.b.bool", true);
+	map.set("a.b.float", 0.123456789f);
+	map.set("a.int32", -5);
+	map.set("string", "<value>");
+	map.set("strings", std::vector<std::string> { "a", "", "c" });
+	map.set("bools", std::vector<bool> { true, false });
+	map.set("colors", std::vector<Color> { Color(0.1f), Color(0.2f) });
+	std::stringstream output;
+	BOOST_REQUIRE(map.serializeTree(output));
+	auto data = output.str();
+	std::stringstream input(data);
+	Map result;
+	result.set("removed", 1);
+	BOOST_REQUIRE(result.deserializeTree(input));
+	std::stringstream expectedXml, resultXml;
+	map.serializeXml(expectedXml);
+	result.serializeXml(resultXml);
+	BOOST_CHECK_EQUAL(resultXml.str(), expectedXml.str());
+	BOOST_CHECK_EQUAL(result.getFloat("a.b.float", 0), 0.123456789f);
+	BOOST_CHECK(!result.contains("removed"));
+	for (size_t length: { size_t(0), size_t(3), data.length() / 2, data.length() - 1 }) {
+		std::stringstream truncated(data.substr(0, length));
+		Map broken;
+		BOOST_CHECK(!broken.deserializeTree(truncated));
+	}
+}
+BOOST_AUTO_TEST_CASE(handle) {
+	auto map = Map::create();
+	dynv::Handle<int32_t> handle(map, "a.b.value", 5);
+	BOOST_CHECK_EQUAL(handle(), 5);
+	BOOST_CHECK(!handle.exists());
+	map->set("a.b.value", 1);
+	BOOST_CHECK_EQUAL(handle(), 1);
+	auto nested = map->getMap("a.b");
+	auto revision = nested->structureRevision();
+	map->set("a.b.value", 2);
+	BOOST_CHECK_EQUAL(nested->structureRevision(), revision);
+	BOOST_CHECK_EQUAL(handle(), 2);
+	handle.set(3);
+	BOOST_CHECK_EQUAL(map->getInt32("a.b.value", 0), 3);
+	map->set("a.b.value", "text");
+	BOOST_CHECK_EQUAL(handle(), 5);
+	map->getOrCreateMap("a")->set("b", Map::create());
+	BOOST_CHECK(map->getMap("a")->structureRevision() != revision);
+	BOOST_CHECK(!handle.exists());
+	handle.set(4);
+	BOOST_CHECK_EQUAL(map->getInt32("a.b.value", 0), 4);
+	BOOST_CHECK(map->remove("a.b.value"));
+	BOOST_CHECK_EQUAL(handle(), 5);
+	map->removeAll();
+	BOOST_CHECK_EQUAL(handle(), 5);
+}
+BOOST_AUTO_TEST_CASE(handleStructureRevision) {
+	auto map = Map::create();
+	map->set("a.b.value", 1);
+	dynv::Handle<int32_t> handle(map, "a.b.value", 5);
+	BOOST_CHECK_EQUAL(handle(), 1);
+	// Changes in other maps and other branches do not change revisions of maps on the path
+	auto root = map->structureRevision(), a = map->getMap("a")->structureRevision(), b = map->getMap("a.b")->structureRevision();
+	auto other = Map::create();
+	other->set("a.b.value", 2);
+	other->remove("a.b.value");
+	map->clone()->removeAll();
+	map->set("a.c.value", 3);
+	map->getMap("a.b")->set("value", 4);
+	BOOST_CHECK_EQUAL(map->structureRevision(), root);
+	BOOST_CHECK_EQUAL(map->getMap("a.b")->structureRevision(), b);
+	BOOST_CHECK(map->getMap("a")->structureRevision() != a);
+	BOOST_CHECK_EQUAL(handle(), 4);
+	// Removing a map on the path and creating it again is noticed from the root
+	BOOST_CHECK(map->remove("a"));
+	BOOST_CHECK_EQUAL(handle(), 5);
+	map->set("a.b.value", 6);
+	BOOST_CHECK(map->structureRevision() != root);
+	BOOST_CHECK_EQUAL(handle(), 6);
+	map->set("a", 7);
+	BOOST_CHECK(!handle.exists());
+	map->removeAll();
+	map->set("a.b.value", 8);
+	BOOST_CHECK_EQUAL(handle(), 8);
+}
+BOOST_AUTO_TEST_CASE(handleString) {
+	auto map = Map::create();
+	dynv::Handle<std::string> handle;
+	BOOST_CHECK_EQUAL(handle(), "");
+	handle.bind(map, "view.layout", "default");
+	BOOST_CHECK_EQUAL(handle(), "default");
+	handle.set("layout");
+	BOOST_CHECK_EQUAL(map->getString("view.layout", ""), "layout");
+	BOOST_CHECK_EQUAL(handle(), "layout");
+}
+BOOST_AUTO_TEST_CASE(changeRevision) {
+	Map map;
+	map.set("a.b.value", 1);
+	auto nested = map.getMap("a.b");
+	auto revision = map.treeChangeRevision();
+	BOOST_CHECK_EQUAL(revision, nested->changeRevision());
+	map.set("a.b.value", 1);
+	map.set("colors", std::vector<Color> { Color(0.1f) });
+	revision = map.treeChangeRevision();
+	map.set("colors", std::vector<Color> { Color(0.1f) });
+	BOOST_CHECK_EQUAL(map.treeChangeRevision(), revision);
+	auto rootRevision = map.changeRevision();
+	nested->set("value", 2);
+	BOOST_CHECK(map.treeChangeRevision() > revision);
+	BOOST_CHECK_EQUAL(map.changeRevision(), rootRevision);
+	revision = map.treeChangeRevision();
+	BOOST_CHECK(map.remove("a.b.value"));
+	BOOST_CHECK(map.treeChangeRevision() > revision);
+}
+BOOST_AUTO_TEST_CASE(clone) {
+	Map map;
+	map.set("a.b.value", 1);
+	map.set("strings", std::vector<std::string> { "a", "b" });
+	map.set("maps", std::vector<Map::Ref> { Map::create(), Map::create() });
+	auto copy = map.clone();
+	std::stringstream expectedXml, resultXml;
+	map.serializeXml(expectedXml);
+	copy->serializeXml(resultXml);
+	BOOST_CHECK_EQUAL(resultXml.str(), expectedXml.str());
+	map.set("a.b.value", 2);
+	BOOST_CHECK_EQUAL(copy->getInt32("a.b.value", 0), 1);
+	BOOST_CHECK(!(map.getMap("a") == copy->getMap("a")));
+}
+BOOST_AUTO_TEST_CASE(manyValues) {
+	Map map;
+	for (int i = 0; i < 100; i++)
+		map.set("value" + std::to_string((i * 37) % 100), i);
+	BOOST_CHECK_EQUAL(map.size(), 100u);
+	for (int i = 0; i < 100; i++)
+		BOOST_CHECK_EQUAL(map.getInt32("value" + std::to_string((i * 37) % 100), -1), i);
+	std::vector<std::string> names;
+	map.visit([&names](const Variable &value) {
+		names.push_back(value.name());
+		return true;
+	});
+	BOOST_CHECK(std::is_sorted(names.begin(), names.end()));
+	for (int i = 0; i < 100; i += 2)
+		BOOST_CHECK(map.remove("value" + std::to_string(i)));
+	BOOST_CHECK_EQUAL(map.size(), 50u);
+	for (int i = 0; i < 100; i++)
+		BOOST_CHECK_EQUAL(map.contains("value" + std::to_string(i)), i % 2 == 1);
+}
 BOOST_AUTO_TEST_SUITE_END()
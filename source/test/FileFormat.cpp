@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "FileFormat.h"
+#include "ColorList.h"
+#include "ColorObject.h"
+#include "dynv/Map.h"
+#include "dynv/Types.h"
+#include <boost/endian/conversion.hpp>
+#include <unordered_map>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+namespace {
+const char *paletteFile = "file_format_test.gpa";
+const size_t colorCount = 10000;
+struct File {
+	File() {
+		std::remove(paletteFile);
+	}
+	~File() {
+		std::remove(paletteFile);
+	}
+};
+bool writePalette(int compressionLevel, size_t count = colorCount, size_t batchSize = 1000, bool compatible = true) {
+	std::ofstream file(paletteFile, std::ios::binary);
+	PaletteFileWriter writer(file, batchSize, compressionLevel, compatible);
+	for (size_t i = 0; i < count; i++) {
+		ColorObject colorObject("color " + std::to_string(i), Color(i / static_cast<float>(colorCount)));
+		// Every 7th color is hidden
+		if (!writer.add(colorObject, i % 7 == 6 ? ~static_cast<size_t>(0) : i))
+			return false;
+	}
+	return writer.finish();
+}
+void checkRange(PaletteFileReader &reader, size_t first, size_t count) {
+	std::vector<ColorObject *> colorObjects;
+	BOOST_REQUIRE(reader.read(first, count, colorObjects));
+	BOOST_REQUIRE_EQUAL(colorObjects.size(), count);
+	for (size_t i = 0; i < count; i++) {
+		auto colorObject = colorObjects[i];
+		size_t index = first + i;
+		BOOST_CHECK_EQUAL(colorObject->getName(), "color " + std::to_string(index));
+		BOOST_CHECK_EQUAL(colorObject->isVisible(), index % 7 != 6);
+		if (colorObject->isVisible())
+			BOOST_CHECK_EQUAL(colorObject->getPosition(), index);
+		colorObject->release();
+	}
+}
+void checkReader() {
+	PaletteFileReader reader(paletteFile);
+	BOOST_REQUIRE(reader.valid());
+	BOOST_CHECK_EQUAL(reader.size(), colorCount);
+	checkRange(reader, 2500, 100);
+	checkRange(reader, 950, 100);
+	checkRange(reader, 0, 1);
+	checkRange(reader, colorCount - 1, 1);
+	checkRange(reader, 3000, 2500);
+	std::vector<ColorObject *> colorObjects;
+	BOOST_CHECK(!reader.read(colorCount - 10, 11, colorObjects));
+	BOOST_CHECK(colorObjects.empty());
+	auto colorList = color_list_new();
+	BOOST_CHECK_EQUAL(palette_file_load(paletteFile, colorList), 0);
+	BOOST_CHECK_EQUAL(colorList->colors.size(), colorCount);
+	color_list_destroy(colorList);
+}
+uint64_t fileSize(const char *filename) {
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	return static_cast<uint64_t>(file.tellg());
+}
+// Loaded palette contains visible colors in palette order followed by hidden colors
+void checkLoad(size_t count) {
+	auto colorList = color_list_new();
+	BOOST_REQUIRE_EQUAL(palette_file_load(paletteFile, colorList), 0);
+	BOOST_REQUIRE_EQUAL(colorList->colors.size(), count);
+	size_t index = 0, hiddenIndex = 6;
+	for (auto colorObject: colorList->colors) {
+		if (colorObject->isVisible()) {
+			if (index % 7 == 6)
+				index++;
+			BOOST_REQUIRE_EQUAL(colorObject->getName(), "color " + std::to_string(index));
+			index++;
+		} else {
+			BOOST_REQUIRE_EQUAL(colorObject->getName(), "color " + std::to_string(hiddenIndex));
+			hiddenIndex += 7;
+		}
+	}
+	color_list_destroy(colorList);
+}
+// Reads file the same way as releases supporting only version 1.0 do
+bool loadVersion10(std::vector<std::string> &names, std::vector<uint32_t> &positions) {
+	std::ifstream file(paletteFile, std::ios::binary);
+	auto readValue = [&file](auto &value) {
+		file.read(reinterpret_cast<char *>(&value), sizeof(value));
+		value = boost::endian::little_to_native(value);
+		return file.good();
+	};
+	auto readHeader = [&file, &readValue](std::string &type, uint64_t &size) {
+		char name[16];
+		file.read(name, sizeof(name));
+		if (!file.good() || name[15] != 0)
+			return false;
+		type = name;
+		return readValue(size);
+	};
+	std::string type;
+	uint64_t size;
+	uint32_t version;
+	if (!readHeader(type, size) || type.compare(0, 11, "GPA version") != 0 || size < 4 || !readValue(version) || version != 0x10000)
+		return false;
+	file.seekg(size - 4, std::ios::cur);
+	std::unordered_map<uint8_t, dynv::types::ValueType> typeMap;
+	while (readHeader(type, size)) {
+		if (type == "handler_map") {
+			uint32_t count;
+			if (!readValue(count))
+				return false;
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t length;
+				if (!readValue(length))
+					return false;
+				std::string name(length, 0);
+				file.read(&name.front(), length);
+				typeMap[static_cast<uint8_t>(i)] = dynv::types::stringToType(name);
+			}
+		} else if (type == "color_list") {
+			std::streamoff end = file.tellg() + static_cast<std::streamoff>(size);
+			while (file.tellg() < end) {
+				dynv::Map options;
+				if (!options.deserialize(file, typeMap))
+					return false;
+				names.push_back(options.getString("name", ""));
+			}
+		} else if (type == "color_positions") {
+			positions.resize(size / sizeof(uint32_t));
+			for (auto &position: positions) {
+				if (!readValue(position))
+					return false;
+			}
+		} else {
+			file.seekg(size, std::ios::cur);
+		}
+	}
+	return file.eof();
+}
+}
+BOOST_AUTO_TEST_SUITE(fileFormat);
+BOOST_AUTO_TEST_CASE(version_1_0_reader) {
+	File file;
+	BOOST_REQUIRE(writePalette(0));
+	std::vector<std::string> names;
+	std::vector<uint32_t> positions;
+	BOOST_REQUIRE(loadVersion10(names, positions));
+	BOOST_REQUIRE_EQUAL(names.size(), colorCount);
+	BOOST_REQUIRE_EQUAL(positions.size(), colorCount);
+	for (size_t i = 0; i < colorCount; i++) {
+		BOOST_REQUIRE_EQUAL(names[i], "color " + std::to_string(i));
+		BOOST_REQUIRE_EQUAL(positions[i], i % 7 == 6 ? UINT32_MAX : i);
+	}
+	// Compressed and columns only files are refused instead of being loaded without colors
+	BOOST_REQUIRE(writePalette(1));
+	names.clear();
+	BOOST_CHECK(!loadVersion10(names, positions));
+	BOOST_CHECK(names.empty());
+	BOOST_REQUIRE(writePalette(0, colorCount, 1000, false));
+	BOOST_CHECK(!loadVersion10(names, positions));
+	BOOST_CHECK(names.empty());
+}
+BOOST_AUTO_TEST_CASE(columns_only) {
+	File file;
+	BOOST_REQUIRE(writePalette(0));
+	auto compatibleSize = fileSize(paletteFile);
+	BOOST_REQUIRE(writePalette(0, colorCount, 1000, false));
+	BOOST_CHECK(fileSize(paletteFile) < compatibleSize);
+	checkReader();
+	checkLoad(colorCount);
+}
+BOOST_AUTO_TEST_CASE(random_access) {
+	File file;
+	BOOST_REQUIRE(writePalette(0));
+	checkReader();
+}
+BOOST_AUTO_TEST_CASE(random_access_compressed) {
+	File file;
+	BOOST_REQUIRE(writePalette(1));
+	checkReader();
+}
+BOOST_AUTO_TEST_CASE(load_in_parts) {
+	File file;
+	BOOST_REQUIRE(writePalette(0, 100000, 100000));
+	checkLoad(100000);
+	BOOST_REQUIRE(writePalette(0, 100000, 3000));
+	checkLoad(100000);
+	BOOST_REQUIRE(writePalette(1, 100000, 20000));
+	checkLoad(100000);
+}
+BOOST_AUTO_TEST_CASE(hidden_colors) {
+	File file;
+	{
+		std::ofstream stream(paletteFile, std::ios::binary);
+		PaletteFileWriter writer(stream, 10, 0);
+		const char *names[] = { "c", "hidden a", "a", "hidden b", "b", "hidden c" };
+		const size_t positions[] = { 2, ~static_cast<size_t>(0), 0, ~static_cast<size_t>(0), 1, ~static_cast<size_t>(0) };
+		for (size_t i = 0; i < 6; i++)
+			BOOST_REQUIRE(writer.add(ColorObject(names[i], Color(0.5f)), positions[i]));
+		BOOST_REQUIRE(writer.finish());
+	}
+	auto colorList = color_list_new();
+	BOOST_REQUIRE_EQUAL(palette_file_load(paletteFile, colorList), 0);
+	std::string order;
+	for (auto colorObject: colorList->colors)
+		order += colorObject->getName() + (colorObject->isVisible() ? ";" : " (hidden);");
+	BOOST_CHECK_EQUAL(order, "a;b;c;hidden a (hidden);hidden b (hidden);hidden c (hidden);");
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_CASE(broken_positions_size) {
+	File file;
+	for (uint64_t size: { static_cast<uint64_t>(1) << 62, static_cast<uint64_t>(6) }) {
+		BOOST_REQUIRE(writePalette(0, 100));
+		{
+			std::ofstream stream(paletteFile, std::ios::binary | std::ios::app);
+			char name[16] = "color_positions";
+			stream.write(name, sizeof(name));
+			uint64_t value = boost::endian::native_to_little(size);
+			stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+			uint32_t position = 0;
+			stream.write(reinterpret_cast<const char *>(&position), sizeof(position));
+		}
+		auto colorList = color_list_new();
+		BOOST_CHECK_NE(palette_file_load(paletteFile, colorList), 0);
+		color_list_destroy(colorList);
+	}
+}
+BOOST_AUTO_TEST_CASE(missing_index) {
+	File file;
+	{
+		std::ofstream stream(paletteFile, std::ios::binary);
+		stream << "GPA version";
+	}
+	PaletteFileReader reader(paletteFile);
+	BOOST_CHECK(!reader.valid());
+	BOOST_CHECK_EQUAL(reader.size(), 0u);
+}
+BOOST_AUTO_TEST_SUITE_END()
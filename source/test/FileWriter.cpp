@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "common/FileWriter.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+using namespace common;
+static std::string readFile(const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	std::stringstream result;
+	result << file.rdbuf();
+	return result.str();
+}
+BOOST_AUTO_TEST_SUITE(fileWriter);
+BOOST_AUTO_TEST_CASE(formatting) {
+	std::string path = "file_writer_test.txt";
+	{
+		FileWriter file(path.c_str(), 16);
+		BOOST_REQUIRE(file.isOpen());
+		file << "values: " << 0 << ' ' << -17 << ' ' << 2147483647 << ' ' << static_cast<int32_t>(-2147483647 - 1) << '\n';
+		file.writeHex(0x0a).uppercase(true).writeHex(0xbc);
+		file << std::string("\n") << std::string(40, 'x');
+		BOOST_CHECK(file.close());
+	}
+	BOOST_CHECK_EQUAL(readFile(path), "values: 0 -17 2147483647 -2147483648\n0aBC\n" + std::string(40, 'x'));
+	std::remove(path.c_str());
+}
+BOOST_AUTO_TEST_CASE(largeOutput) {
+	std::string path = "file_writer_test.txt", expected;
+	{
+		FileWriter file(path.c_str(), 64);
+		for (int i = 0; i < 10000; i++) {
+			file << i << ',';
+			expected += std::to_string(i) + ',';
+		}
+	}
+	BOOST_CHECK(readFile(path) == expected);
+	std::remove(path.c_str());
+}
+BOOST_AUTO_TEST_CASE(openFailure) {
+	FileWriter file("non_existent_directory/file_writer_test.txt");
+	BOOST_CHECK(!file.isOpen());
+	file << "ignored";
+	BOOST_CHECK(!file.good());
+	BOOST_CHECK(!file.close());
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <boost/test/unit_test.hpp>
+#include "ImportExport.h"
+#include "ColorList.h"
+#include "ColorObject.h"
+#include "Converter.h"
+#include "Converters.h"
+#include "lua/Script.h"
+#include "lua/Ref.h"
+#include "lua/Color.h"
+#include "lua/ColorObject.h"
+#include <fstream>
+#include <string>
+#include <cstdio>
+namespace {
+const char *paletteFile = "import_export_test.gpl";
+const size_t colorCount = 20000;
+struct GplFile {
+	GplFile() {
+		std::ofstream file(paletteFile, std::ios::binary);
+		file << "GIMP Palette\nName: test\nColumns: 1\n#\n";
+		for (size_t i = 0; i < colorCount; i++)
+			file << (i % 256) << ' ' << ((i / 256) % 256) << " 0\tcolor " << i << '\n';
+	}
+	~GplFile() {
+		std::remove(paletteFile);
+	}
+};
+const char *textFile = "import_export_test.txt";
+// Converters with a single Lua deserializer for "#rrggbb" values
+struct TextFile {
+	lua::Script script;
+	Converters converters;
+	TextFile() {
+		std::ofstream file(textFile, std::ios::binary);
+		file << "#ff0000\n#00ff00\n";
+		script.registerExtension("color", lua::registerColor);
+		script.registerExtension("colorObject", lua::registerColorObject);
+		bool status = script.loadCode(R"(
+			local color = require('gpick/color')
+			return function(text, colorObject)
+				local r, g, b = text:match('^#(%x%x)(%x%x)(%x%x)$')
+				if not r then return 0 end
+				local c = color:new()
+				c:rgb(tonumber(r, 16) / 255, tonumber(g, 16) / 255, tonumber(b, 16) / 255)
+				colorObject:setColor(c)
+				return 1
+			end
+		)") && script.run(0, 1);
+		BOOST_REQUIRE(status);
+		auto converter = new Converter("hex", "hex", lua::Ref(), lua::Ref(script, -1));
+		converter->paste(true);
+		converters.add(converter);
+		converters.rebuildCopyPasteArrays();
+	}
+	~TextFile() {
+		std::remove(textFile);
+	}
+};
+}
+BOOST_AUTO_TEST_SUITE(importExport);
+BOOST_FIXTURE_TEST_CASE(progress, GplFile) {
+	auto colorList = color_list_new();
+	ImportExport importExport(colorList, paletteFile);
+	float lastProgress = 0;
+	bool increasing = true;
+	importExport.setProgressCallback([&](float progress) {
+		increasing = increasing && progress >= lastProgress;
+		lastProgress = progress;
+		return true;
+	});
+	BOOST_CHECK(importExport.importGPL());
+	BOOST_CHECK(increasing);
+	BOOST_CHECK_EQUAL(lastProgress, 1.0f);
+	BOOST_CHECK_EQUAL(colorList->colors.size(), colorCount);
+	color_list_destroy(colorList);
+}
+BOOST_FIXTURE_TEST_CASE(cancel, GplFile) {
+	auto colorList = color_list_new();
+	ImportExport importExport(colorList, paletteFile);
+	size_t calls = 0, importedAtCancel = 0;
+	importExport.setProgressCallback([&](float progress) {
+		if (++calls < 2)
+			return true;
+		importedAtCancel = colorList->colors.size();
+		return false;
+	});
+	BOOST_CHECK(!importExport.importGPL());
+	BOOST_CHECK(importExport.getLastError() == ImportExport::Error::cancelled);
+	BOOST_CHECK_EQUAL(calls, 2);
+	// Batches added before cancellation are kept, nothing is added after it
+	BOOST_CHECK_GT(importedAtCancel, 0);
+	BOOST_CHECK_LT(importedAtCancel, colorCount);
+	BOOST_REQUIRE_EQUAL(colorList->colors.size(), importedAtCancel);
+	size_t i = 0;
+	for (auto colorObject: colorList->colors)
+		BOOST_CHECK_EQUAL(colorObject->getName(), "color " + std::to_string(i++));
+	color_list_destroy(colorList);
+}
+struct Files: public GplFile, public TextFile {
+};
+BOOST_FIXTURE_TEST_CASE(importFiles, Files) {
+	auto colorList = color_list_new();
+	std::vector<std::string> failed;
+	BOOST_CHECK(ImportExport::importFiles(colorList, { textFile, paletteFile }, &converters, &failed));
+	BOOST_CHECK(failed.empty());
+	BOOST_REQUIRE_EQUAL(colorList->colors.size(), colorCount + 2);
+	auto i = colorList->colors.begin();
+	BOOST_CHECK_EQUAL((*i)->getColor().rgb.red, 1.0f);
+	BOOST_CHECK_EQUAL((*++i)->getColor().rgb.green, 1.0f);
+	BOOST_CHECK_EQUAL((*++i)->getName(), "color 0");
+	color_list_remove_all(colorList);
+	// Text files can not be imported without converters
+	BOOST_CHECK(ImportExport::importFiles(colorList, { textFile, paletteFile }, nullptr, &failed));
+	BOOST_REQUIRE_EQUAL(failed.size(), 1);
+	BOOST_CHECK_EQUAL(failed[0], textFile);
+	BOOST_CHECK_EQUAL(colorList->colors.size(), colorCount);
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_SUITE_END()
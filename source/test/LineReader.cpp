@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "common/LineReader.h"
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace common;
+static std::vector<std::string> readLines(const std::string &text, size_t chunkSize) {
+	std::istringstream stream(text);
+	LineReader reader(stream, chunkSize);
+	std::vector<std::string> lines;
+	char *line;
+	size_t length;
+	while (reader.next(line, length)) {
+		BOOST_CHECK_EQUAL(line[length], 0);
+		lines.emplace_back(line, length);
+	}
+	BOOST_CHECK(!reader.failed());
+	BOOST_CHECK_EQUAL(reader.position(), text.length());
+	return lines;
+}
+BOOST_AUTO_TEST_SUITE(lineReader);
+BOOST_AUTO_TEST_CASE(lines) {
+	for (size_t chunkSize: { 1, 2, 3, 7, 1024 }) {
+		auto lines = readLines("first\nsecond\r\n\nlast", chunkSize);
+		BOOST_REQUIRE_EQUAL(lines.size(), 4u);
+		BOOST_CHECK_EQUAL(lines[0], "first");
+		BOOST_CHECK_EQUAL(lines[1], "second");
+		BOOST_CHECK_EQUAL(lines[2], "");
+		BOOST_CHECK_EQUAL(lines[3], "last");
+	}
+}
+BOOST_AUTO_TEST_CASE(trailingNewline) {
+	auto lines = readLines("a\nb\n", 3);
+	BOOST_REQUIRE_EQUAL(lines.size(), 2u);
+	BOOST_CHECK_EQUAL(lines[1], "b");
+	BOOST_CHECK(readLines("", 16).empty());
+}
+BOOST_AUTO_TEST_CASE(longLines) {
+	std::string text;
+	for (int i = 0; i < 100; i++)
+		text += std::string(i * 37, 'a' + i % 26) + "\n";
+	auto lines = readLines(text, 16);
+	BOOST_REQUIRE_EQUAL(lines.size(), 100u);
+	for (int i = 0; i < 100; i++)
+		BOOST_CHECK(lines[i] == std::string(i * 37, 'a' + i % 26));
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "common/MappedFile.h"
+#include <fstream>
+#include <string>
+#include <cstdio>
+using namespace common;
+BOOST_AUTO_TEST_SUITE(mappedFile);
+BOOST_AUTO_TEST_CASE(contents) {
+	std::string path = "mapped_file_test.bin";
+	std::string data("test data\0with zero", 19);
+	{
+		std::ofstream file(path, std::ios::binary);
+		file.write(data.data(), data.size());
+	}
+	{
+		MappedFile file(path.c_str());
+		BOOST_REQUIRE(file.valid());
+		BOOST_CHECK_EQUAL(file.size(), data.size());
+		BOOST_CHECK(std::string(reinterpret_cast<const char *>(file.data()), file.size()) == data);
+	}
+	std::remove(path.c_str());
+}
+BOOST_AUTO_TEST_CASE(empty) {
+	std::string path = "mapped_file_test.bin";
+	std::ofstream(path, std::ios::binary).close();
+	{
+		MappedFile file(path.c_str());
+		BOOST_CHECK(file.valid());
+		BOOST_CHECK_EQUAL(file.size(), 0u);
+	}
+	std::remove(path.c_str());
+}
+BOOST_AUTO_TEST_CASE(missing) {
+	MappedFile file("this file does not exist");
+	BOOST_CHECK(!file.valid());
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "PaletteJournal.h"
+#include "ColorList.h"
+#include "ColorObject.h"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+namespace {
+const char *snapshotFile = "palette_journal_test.gpa";
+const char *journalFile = "palette_journal_test.journal";
+struct Files {
+	Files() {
+		remove();
+	}
+	~Files() {
+		remove();
+	}
+	void remove() {
+		std::remove(snapshotFile);
+		std::remove(journalFile);
+	}
+};
+// Only visible colors get palette positions, like in the main window palette
+int getPositions(ColorList *colorList) {
+	size_t position = 0;
+	for (auto colorObject: colorList->colors) {
+		if (colorObject->isVisible())
+			colorObject->setPosition(position++);
+	}
+	return 0;
+}
+ColorList *newColorList() {
+	auto colorList = color_list_new();
+	colorList->on_get_positions = getPositions;
+	return colorList;
+}
+void addColor(ColorList *colorList, const std::string &name, float value) {
+	auto colorObject = new ColorObject(name, Color(value));
+	color_list_add_color_object(colorList, colorObject, true);
+	colorObject->release();
+}
+// Palette order: visible colors followed by hidden colors
+std::string describe(ColorList *colorList) {
+	std::string result, hidden;
+	for (auto colorObject: colorList->colors) {
+		auto text = colorObject->getName() + ":" + std::to_string(colorObject->getColor().rgb.red) + ";";
+		if (colorObject->isVisible())
+			result += text;
+		else
+			hidden += text;
+	}
+	return result + "hidden;" + hidden;
+}
+std::string reload() {
+	auto colorList = newColorList();
+	PaletteJournal journal(snapshotFile, journalFile);
+	journal.load(colorList);
+	auto result = describe(colorList);
+	color_list_destroy(colorList);
+	return result;
+}
+uint64_t fileSize(const char *filename) {
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	return static_cast<uint64_t>(file.tellg());
+}
+}
+BOOST_AUTO_TEST_SUITE(paletteJournal);
+BOOST_AUTO_TEST_CASE(replay) {
+	Files files;
+	auto colorList = newColorList();
+	for (int i = 0; i < 100; i++)
+		addColor(colorList, "color " + std::to_string(i), i / 100.0f);
+	PaletteJournal journal(snapshotFile, journalFile);
+	BOOST_CHECK(!journal.load(colorList));
+	BOOST_CHECK(journal.save(colorList));
+	auto snapshotSize = fileSize(snapshotFile);
+	BOOST_CHECK_EQUAL(reload(), describe(colorList));
+	addColor(colorList, "new", 0.5f);
+	BOOST_CHECK(journal.save(colorList));
+	BOOST_CHECK_EQUAL(reload(), describe(colorList));
+	colorList->colors.front()->setName("renamed");
+	color_list_changed(colorList, colorList->colors.front());
+	colorList->colors.back()->setColor(Color(0.25f));
+	color_list_changed(colorList, colorList->colors.back());
+	(*std::next(colorList->colors.begin(), 10))->setVisible(false);
+	color_list_changed(colorList, *std::next(colorList->colors.begin(), 10));
+	color_list_remove_color_object(colorList, *std::next(colorList->colors.begin(), 20));
+	BOOST_CHECK(journal.save(colorList));
+	BOOST_CHECK_EQUAL(reload(), describe(colorList));
+	colorList->colors.reverse();
+	colorList->revision++;
+	BOOST_CHECK(journal.save(colorList));
+	BOOST_CHECK_EQUAL(reload(), describe(colorList));
+	colorList->colors.insert(std::next(colorList->colors.begin(), 5), new ColorObject("inserted", Color(0.75f)));
+	colorList->revision++;
+	BOOST_CHECK(journal.save(colorList));
+	BOOST_CHECK_EQUAL(reload(), describe(colorList));
+	BOOST_CHECK_EQUAL(fileSize(snapshotFile), snapshotSize);
+	BOOST_CHECK_EQUAL(fileSize(journalFile), journal.journalSize());
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_CASE(unchanged_palette_is_not_written) {
+	Files files;
+	auto colorList = newColorList();
+	addColor(colorList, "a", 0.1f);
+	PaletteJournal journal(snapshotFile, journalFile);
+	BOOST_CHECK(journal.save(colorList));
+	auto journalSize = journal.journalSize();
+	BOOST_CHECK(journal.save(colorList));
+	BOOST_CHECK_EQUAL(journal.journalSize(), journalSize);
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_CASE(only_notified_changes_are_compared) {
+	Files files;
+	auto colorList = newColorList();
+	addColor(colorList, "a", 0.1f);
+	PaletteJournal journal(snapshotFile, journalFile);
+	BOOST_CHECK(journal.save(colorList));
+	BOOST_CHECK(journal.isSaved(colorList));
+	auto journalSize = journal.journalSize();
+	colorList->colors.front()->setName("renamed");
+	BOOST_CHECK(journal.save(colorList));
+	BOOST_CHECK_EQUAL(journal.journalSize(), journalSize);
+	color_list_changed(colorList, colorList->colors.front());
+	BOOST_CHECK(!journal.isSaved(colorList));
+	BOOST_CHECK(journal.save(colorList));
+	BOOST_CHECK(journal.isSaved(colorList));
+	BOOST_CHECK(journal.journalSize() > journalSize);
+	BOOST_CHECK_EQUAL(reload(), describe(colorList));
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_CASE(compaction) {
+	Files files;
+	auto colorList = newColorList();
+	addColor(colorList, "a", 0.1f);
+	PaletteJournal journal(snapshotFile, journalFile);
+	journal.setMinimumCompactionSize(256);
+	BOOST_CHECK(journal.save(colorList));
+	auto journalSize = journal.journalSize();
+	for (int i = 0; i < 20; i++) {
+		addColor(colorList, "color " + std::to_string(i), i / 20.0f);
+		BOOST_CHECK(journal.save(colorList));
+		BOOST_CHECK(journal.journalSize() <= std::max<uint64_t>(journal.snapshotSize(), 256));
+	}
+	BOOST_CHECK_EQUAL(reload(), describe(colorList));
+	BOOST_CHECK(journal.compact(colorList));
+	BOOST_CHECK_EQUAL(journal.journalSize(), journalSize);
+	BOOST_CHECK_EQUAL(reload(), describe(colorList));
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_CASE(incomplete_record) {
+	Files files;
+	auto colorList = newColorList();
+	addColor(colorList, "a", 0.1f);
+	PaletteJournal journal(snapshotFile, journalFile);
+	BOOST_CHECK(journal.save(colorList));
+	addColor(colorList, "b", 0.2f);
+	BOOST_CHECK(journal.save(colorList));
+	auto expected = describe(colorList);
+	addColor(colorList, "c", 0.3f);
+	BOOST_CHECK(journal.save(colorList));
+	{
+		std::ofstream file(journalFile, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(static_cast<std::streamoff>(journal.journalSize() - 1));
+		file.put('\xff');
+	}
+	BOOST_CHECK_EQUAL(reload(), expected);
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_CASE(replaced_snapshot) {
+	Files files;
+	auto colorList = newColorList();
+	addColor(colorList, "a", 0.1f);
+	PaletteJournal journal(snapshotFile, journalFile);
+	BOOST_CHECK(journal.save(colorList));
+	auto other = newColorList();
+	addColor(other, "other", 0.9f);
+	PaletteJournal otherJournal(snapshotFile, journalFile);
+	BOOST_CHECK(otherJournal.save(other));
+	addColor(colorList, "b", 0.2f);
+	BOOST_CHECK(journal.save(colorList));
+	BOOST_CHECK_EQUAL(reload(), describe(colorList));
+	color_list_destroy(other);
+	color_list_destroy(colorList);
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "lua/Profiler.h"
+#include <sstream>
+using namespace lua;
+BOOST_AUTO_TEST_CASE(profiler_statistics) {
+	Profiler profiler;
+	auto site = profiler.site("test.serialize");
+	BOOST_CHECK(site == profiler.site("test.serialize"));
+	for (uint64_t i = 1; i <= 100; i++)
+		site->record(i * 1000, 16, i == 100);
+	Profiler::Statistics statistics;
+	BOOST_CHECK(profiler.statistics("test.serialize", statistics));
+	BOOST_CHECK(statistics.calls == 100);
+	BOOST_CHECK(statistics.errors == 1);
+	BOOST_CHECK(statistics.total == 5050000);
+	BOOST_CHECK(statistics.average() == 50500);
+	BOOST_CHECK(statistics.minimum == 1000);
+	BOOST_CHECK(statistics.maximum == 100000);
+	BOOST_CHECK(statistics.median == 50000);
+	BOOST_CHECK(statistics.percentile90 == 90000);
+	BOOST_CHECK(statistics.percentile99 == 99000);
+	BOOST_CHECK(statistics.memory == 1600);
+	BOOST_CHECK(!profiler.statistics("missing", statistics));
+}
+BOOST_AUTO_TEST_CASE(profiler_sample_window) {
+	Profiler profiler;
+	auto site = profiler.site("test");
+	for (size_t i = 0; i < Profiler::SampleCount; i++)
+		site->record(1000000, 0, false);
+	for (size_t i = 0; i < Profiler::SampleCount; i++)
+		site->record(1000, 0, false);
+	auto statistics = site->statistics();
+	BOOST_CHECK(statistics.calls == Profiler::SampleCount * 2);
+	BOOST_CHECK(statistics.percentile99 == 1000);
+	BOOST_CHECK(statistics.maximum == 1000000);
+}
+BOOST_AUTO_TEST_CASE(profiler_reset_and_dump) {
+	Profiler profiler;
+	profiler.site("slow")->record(2000000, 0, false);
+	profiler.site("fast")->record(1000, 0, false);
+	profiler.site("unused");
+	std::stringstream stream;
+	profiler.dump(stream);
+	std::string line;
+	std::getline(stream, line);
+	BOOST_CHECK(line[0] == '#');
+	std::getline(stream, line);
+	BOOST_CHECK(line.compare(0, 5, "slow\t") == 0);
+	std::getline(stream, line);
+	BOOST_CHECK(line.compare(0, 5, "fast\t") == 0);
+	BOOST_CHECK(!std::getline(stream, line));
+	profiler.reset();
+	auto statistics = profiler.statistics();
+	BOOST_CHECK(statistics.size() == 3);
+	for (auto &item: statistics)
+		BOOST_CHECK(item.calls == 0);
+}
@@ -18,6 +18,12 @@
 
 #include <boost/test/unit_test.hpp>
 #include "lua/Script.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <utime.h>
 extern "C" {
 #include <lualib.h>
 #include <lauxlib.h>
@@ -62,3 +68,96 @@ BOOST_AUTO_TEST_CASE(register_nullptr_extension) {
 	std::string returnValue = script.getString(-1);
 	BOOST_CHECK(returnValue == "ok");
 }
+struct CacheFixture {
+	std::string path;
+	CacheFixture() {
+		gchar *directory = g_dir_make_tmp("gpick-test-XXXXXX", nullptr);
+		path = directory;
+		g_free(directory);
+	}
+	~CacheFixture() {
+		for (auto &filename: files())
+			g_remove(filename.c_str());
+		g_rmdir(path.c_str());
+	}
+	std::vector<std::string> files(const char *suffix = "") {
+		std::vector<std::string> result;
+		GDir *directory = g_dir_open(path.c_str(), 0, nullptr);
+		while (const gchar *name = g_dir_read_name(directory)) {
+			if (g_str_has_suffix(name, suffix))
+				result.push_back(path + "/" + name);
+		}
+		g_dir_close(directory);
+		return result;
+	}
+	void write(const std::string &filename, const std::string &data) {
+		std::ofstream file(filename, std::ios::out | std::ios::trunc | std::ios::binary);
+		file << data;
+	}
+	std::string read(const std::string &filename) {
+		std::ifstream file(filename, std::ios::in | std::ios::binary);
+		return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	}
+	std::string require(size_t &hits, size_t &misses) {
+		Script script;
+		script.setPaths({ path });
+		script.setCachePath(path);
+		bool status = script.loadCode("return require(\"cached\")");
+		BOOST_REQUIRE(status == true);
+		status = script.run(0, 1);
+		BOOST_REQUIRE(status == true);
+		hits = script.getCacheHits();
+		misses = script.getCacheMisses();
+		return script.getString(-1);
+	}
+};
+BOOST_FIXTURE_TEST_SUITE(scriptCache, CacheFixture)
+BOOST_AUTO_TEST_CASE(hit) {
+	write(path + "/cached.lua", "return 'first'");
+	size_t hits, misses;
+	BOOST_CHECK_EQUAL(require(hits, misses), "first");
+	BOOST_CHECK_EQUAL(hits, 0);
+	BOOST_CHECK_EQUAL(misses, 1);
+	BOOST_CHECK_EQUAL(files(".luac").size(), 1);
+	BOOST_CHECK_EQUAL(require(hits, misses), "first");
+	BOOST_CHECK_EQUAL(hits, 1);
+	BOOST_CHECK_EQUAL(misses, 0);
+}
+BOOST_AUTO_TEST_CASE(staleFile) {
+	std::string filename = path + "/cached.lua";
+	write(filename, "return 'first'");
+	struct stat file_stat;
+	BOOST_REQUIRE(stat(filename.c_str(), &file_stat) == 0);
+	size_t hits, misses;
+	BOOST_CHECK_EQUAL(require(hits, misses), "first");
+	// Same size and modification time, so only source hash can detect the change.
+	write(filename, "return 'other'");
+	struct utimbuf times;
+	times.actime = file_stat.st_atime;
+	times.modtime = file_stat.st_mtime;
+	BOOST_REQUIRE(utime(filename.c_str(), &times) == 0);
+	BOOST_CHECK_EQUAL(require(hits, misses), "other");
+	BOOST_CHECK_EQUAL(hits, 0);
+	BOOST_CHECK_EQUAL(misses, 1);
+	BOOST_CHECK_EQUAL(require(hits, misses), "other");
+	BOOST_CHECK_EQUAL(hits, 1);
+}
+BOOST_AUTO_TEST_CASE(corruptFile) {
+	write(path + "/cached.lua", "return 'first'");
+	size_t hits, misses;
+	BOOST_CHECK_EQUAL(require(hits, misses), "first");
+	auto cacheFiles = files(".luac");
+	BOOST_REQUIRE_EQUAL(cacheFiles.size(), 1);
+	std::string data = read(cacheFiles[0]);
+	data[data.length() - 8] ^= 0x55;
+	write(cacheFiles[0], data);
+	BOOST_CHECK_EQUAL(require(hits, misses), "first");
+	BOOST_CHECK_EQUAL(hits, 0);
+	BOOST_CHECK_EQUAL(misses, 1);
+	write(cacheFiles[0], data.substr(0, data.length() / 2));
+	BOOST_CHECK_EQUAL(require(hits, misses), "first");
+	BOOST_CHECK_EQUAL(misses, 1);
+	BOOST_CHECK_EQUAL(require(hits, misses), "first");
+	BOOST_CHECK_EQUAL(hits, 1);
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2009-2020, Albertas Vyšniauskas
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the software author nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <boost/test/unit_test.hpp>
+#include "lua/ScriptPool.h"
+#include "lua/Script.h"
+#include "lua/Callbacks.h"
+#include "lua/Color.h"
+#include "lua/ColorObject.h"
+#include "lua/DynvSystem.h"
+#include "Converters.h"
+#include "Converter.h"
+#include "ConverterSerializePosition.h"
+#include "ColorObject.h"
+#include "dynv/Map.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <fstream>
+#include <string>
+#include <vector>
+extern "C" {
+#include <lualib.h>
+#include <lauxlib.h>
+}
+using namespace lua;
+namespace {
+const char *initScript = R"(
+local gpick = require('gpick')
+local prefix = ''
+gpick:setOptionChangeCallback(function(options)
+	prefix = options:getString('test.prefix', '')
+end)
+gpick:addConverter('test', 'Test', function(colorObject, position)
+	local text = prefix .. colorObject:getName() .. ' ' .. position.index .. '/' .. position.count
+	if position.first then text = text .. ' first' end
+	if position.last then text = text .. ' last' end
+	return text .. string.format(' %.4f', colorObject:getColor():red())
+end)
+)";
+int addConverter(lua_State *L) {
+	auto &converters = *static_cast<Converters *>(lua_touserdata(L, lua_upvalueindex(1)));
+	const char *name = luaL_checkstring(L, 2);
+	const char *label = luaL_checkstring(L, 3);
+	converters.add(new Converter(name, label, Ref(L, 4), Ref()));
+	return 0;
+}
+int setOptionChangeCallback(lua_State *L) {
+	auto &callbacks = *static_cast<Callbacks *>(lua_touserdata(L, lua_upvalueindex(1)));
+	callbacks.optionChange(Ref(L, 2));
+	return 0;
+}
+// Registers only what the test script needs, the application registers lua::registerAll extensions
+void registerExtensions(lua_State *L, Converters &converters, Callbacks &callbacks) {
+	Script script(L);
+	script.registerExtension("color", registerColor);
+	script.registerExtension("colorObject", registerColorObject);
+	script.registerExtension("dynvSystem", registerDynvSystem);
+	script.registerExtension(nullptr, [&converters, &callbacks](Script &script) {
+		lua_State *L = script;
+		lua_newtable(L);
+		lua_pushlightuserdata(L, &converters);
+		lua_pushcclosure(L, addConverter, 1);
+		lua_setfield(L, -2, "addConverter");
+		lua_pushlightuserdata(L, &callbacks);
+		lua_pushcclosure(L, setOptionChangeCallback, 1);
+		lua_setfield(L, -2, "setOptionChangeCallback");
+		return 1;
+	});
+}
+struct PoolFixture {
+	std::string path;
+	dynv::Ref settings;
+	std::vector<ColorObject *> colorObjects;
+	PoolFixture():
+		settings(dynv::Map::create()) {
+		gchar *directory = g_dir_make_tmp("gpick-test-XXXXXX", nullptr);
+		path = directory;
+		g_free(directory);
+		std::ofstream(path + "/init.lua") << initScript;
+		settings->set("test.prefix", "a:");
+		for (int i = 0; i < 2000; i++)
+			colorObjects.push_back(new ColorObject("color " + std::to_string(i), Color(i / 2000.0f)));
+	}
+	~PoolFixture() {
+		for (auto colorObject: colorObjects)
+			colorObject->release();
+		g_remove((path + "/init.lua").c_str());
+		g_rmdir(path.c_str());
+	}
+	// Serializes colors with Converter::serialize in a single state, which has options set the same way as pool states
+	std::vector<std::string> expected() {
+		Script script;
+		Converters converters;
+		Callbacks callbacks;
+		registerExtensions(script, converters, callbacks);
+		script.setPaths({ path });
+		std::vector<std::string> result;
+		BOOST_REQUIRE(script.load("init"));
+		lua_State *L = script;
+		callbacks.optionChange().get();
+		pushDynvSystem(L, settings);
+		BOOST_REQUIRE_EQUAL(lua_pcall(L, 1, 0, 0), 0);
+		auto converter = converters.byName("test");
+		BOOST_REQUIRE(converter != nullptr);
+		ConverterSerializePosition position(colorObjects.size());
+		for (size_t i = 0; i < colorObjects.size(); i++) {
+			position.first(i == 0);
+			position.last(i + 1 == colorObjects.size());
+			position.index(i);
+			result.push_back(converter->serialize(*colorObjects[i], position));
+		}
+		return result;
+	}
+};
+}
+BOOST_AUTO_TEST_SUITE(scriptPool);
+BOOST_FIXTURE_TEST_CASE(serializeOnThreads, PoolFixture) {
+	ScriptPool pool(registerExtensions, { path }, "", nullptr, *settings, 4);
+	std::vector<std::string> result;
+	BOOST_REQUIRE(pool.serialize("test", colorObjects, result));
+	auto expectedResult = expected();
+	BOOST_CHECK_EQUAL(result.front(), "a:color 0 0/2000 first 0.0000");
+	BOOST_CHECK(result == expectedResult);
+	// States are reused by the next call
+	BOOST_REQUIRE(pool.serialize("test", colorObjects, result));
+	BOOST_CHECK(result == expectedResult);
+}
+BOOST_FIXTURE_TEST_CASE(changedOption, PoolFixture) {
+	ScriptPool pool(registerExtensions, { path }, "", nullptr, *settings, 4);
+	std::vector<std::string> result;
+	BOOST_REQUIRE(pool.serialize("test", colorObjects, result));
+	settings->set("test.prefix", "b:");
+	BOOST_REQUIRE(pool.serialize("test", colorObjects, result));
+	BOOST_CHECK_EQUAL(result.back(), "b:color 1999 1999/2000 last 0.9995");
+	BOOST_CHECK(result == expected());
+	// Leased state sees the same options
+	auto lease = pool.acquire();
+	BOOST_REQUIRE(lease.valid());
+	BOOST_CHECK_EQUAL(lease.converters().byName("test")->serialize(*colorObjects[1]), "b:color 1 0/1 first last 0.0005");
+}
+BOOST_FIXTURE_TEST_CASE(unknownConverter, PoolFixture) {
+	ScriptPool pool(registerExtensions, { path }, "", nullptr, *settings, 2);
+	std::vector<std::string> result;
+	BOOST_CHECK(!pool.serialize("missing", colorObjects, result));
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,9 +19,7 @@
 #include "ColorVisionDeficiency.h"
 #include "dynv/Map.h"
 #include "MathUtil.h"
-#include "uiUtilities.h"
 #include "I18N.h"
-#include <gtk/gtk.h>
 #include <math.h>
 #include <string.h>
 #include <iostream>
@@ -301,134 +299,4 @@ void ColorVisionDeficiency::deserialize(const dynv::Map &system) {
 	type = typeFromString(system.getString("type", "protanomaly"));
 }
 
-
-static GtkWidget* create_type_list(void){
-	GtkListStore *store;
-	GtkCellRenderer *renderer;
-	GtkWidget *widget;
-	store = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_INT);
-	widget = gtk_combo_box_new_with_model(GTK_TREE_MODEL(store));
-	gtk_combo_box_set_add_tearoffs(GTK_COMBO_BOX(widget), 0);
-	renderer = gtk_cell_renderer_text_new();
-	gtk_cell_layout_pack_start(GTK_CELL_LAYOUT(widget), renderer, 0);
-	gtk_cell_layout_set_attributes(GTK_CELL_LAYOUT(widget), renderer, "text", 0, nullptr);
-	g_object_unref(GTK_TREE_MODEL(store));
-	GtkTreeIter iter1;
-
-	struct {
-		const char *name;
-		int type;
-	} types[] = {
-		{_("Protanomaly"), ColorVisionDeficiency::PROTANOMALY},
-		{_("Deuteranomaly"), ColorVisionDeficiency::DEUTERANOMALY},
-		{_("Tritanomaly"), ColorVisionDeficiency::TRITANOMALY},
-		{_("Protanopia"), ColorVisionDeficiency::PROTANOPIA},
-		{_("Deuteranopia"), ColorVisionDeficiency::DEUTERANOPIA},
-		{_("Tritanopia"), ColorVisionDeficiency::TRITANOPIA},
-	};
-
-	for (int i = 0; i < ColorVisionDeficiency::DEFICIENCY_TYPE_COUNT; ++i){
-		gtk_list_store_append(store, &iter1);
-		gtk_list_store_set(store, &iter1,
-			0, types[i].name,
-			1, types[i].type,
-		-1);
-	}
-
-	return widget;
-}
-std::unique_ptr<IConfiguration> ColorVisionDeficiency::getConfiguration() {
-	return std::move(std::make_unique<Configuration>(*this));
-}
-ColorVisionDeficiency::Configuration::Configuration(ColorVisionDeficiency &transformation) {
-	GtkWidget *table = gtk_table_new(2, 2, false);
-	GtkWidget *widget;
-	int table_y = 0;
-
-	table_y = 0;
-
-	gtk_table_attach(GTK_TABLE(table), gtk_label_aligned_new(_("Type:"), 0, 0.5, 0, 0), 0, 1, table_y, table_y + 1, GTK_FILL, GTK_FILL, 5, 5);
-	type = widget = create_type_list();
-	g_signal_connect(G_OBJECT(type), "changed", G_CALLBACK(type_combobox_change_cb), this);
-	gtk_table_attach(GTK_TABLE(table), widget, 1, 2, table_y, table_y + 1, GtkAttachOptions(GTK_FILL | GTK_EXPAND), GTK_FILL, 5, 0);
-	table_y++;
-
-	info_bar = widget = gtk_info_bar_new();
-	info_label = gtk_label_new("");
-	gtk_label_set_line_wrap(GTK_LABEL(info_label), true);
-	gtk_label_set_justify(GTK_LABEL(info_label), GTK_JUSTIFY_LEFT);
-	gtk_label_set_single_line_mode(GTK_LABEL(info_label), false);
-	gtk_misc_set_alignment(GTK_MISC(info_label), 0, 0.5);
-	gtk_widget_set_size_request(info_label, 1, -1);
-	GtkWidget *content_area = gtk_info_bar_get_content_area(GTK_INFO_BAR(info_bar));
-	gtk_container_add(GTK_CONTAINER(content_area), info_label);
-	gtk_widget_show_all(info_bar);
-	g_signal_connect(G_OBJECT(info_label), "size-allocate", G_CALLBACK(info_label_size_allocate_cb), this);
-
-	gtk_table_attach(GTK_TABLE(table), widget, 1, 2, table_y, table_y + 1, GtkAttachOptions(GTK_FILL | GTK_EXPAND), GTK_FILL, 5, 0);
-	table_y++;
-
-	gtk_combo_box_set_active(GTK_COMBO_BOX(type), transformation.type);
-
-	gtk_table_attach(GTK_TABLE(table), gtk_label_aligned_new(_("Strength:"), 0, 0.5, 0, 0), 0, 1, table_y, table_y + 1, GTK_FILL, GTK_FILL, 5, 5);
-	strength = widget = gtk_hscale_new_with_range(0, 100, 1);
-	gtk_range_set_value(GTK_RANGE(widget), transformation.strength * 100);
-	gtk_table_attach(GTK_TABLE(table), widget, 1, 2, table_y, table_y + 1, GtkAttachOptions(GTK_FILL | GTK_EXPAND), GTK_FILL, 5, 0);
-	table_y++;
-
-	main = table;
-	gtk_widget_show_all(main);
-
-	g_object_ref(main);
-
-}
-
-ColorVisionDeficiency::Configuration::~Configuration(){
-	g_object_unref(main);
-}
-
-GtkWidget* ColorVisionDeficiency::Configuration::getWidget(){
-	return main;
-}
-
-void ColorVisionDeficiency::Configuration::apply(dynv::Map &options) {
-	options.set("strength", static_cast<float>(gtk_range_get_value(GTK_RANGE(strength)) / 100.0f));
-	GtkTreeIter iter;
-	if (gtk_combo_box_get_active_iter(GTK_COMBO_BOX(type), &iter)) {
-		GtkTreeModel* model = gtk_combo_box_get_model(GTK_COMBO_BOX(type));
-		ColorVisionDeficiency::DeficiencyType type_id;
-		gtk_tree_model_get(model, &iter, 1, &type_id, -1);
-		options.set("type", ColorVisionDeficiency::deficiency_type_string[type_id]);
-	}
-}
-
-void ColorVisionDeficiency::Configuration::type_combobox_change_cb(GtkWidget *widget, ColorVisionDeficiency::Configuration *this_)
-{
-	const char *descriptions[] = {
-		_("Altered spectral sensitivity of red receptors"),
-		_("Altered spectral sensitivity of green receptors"),
-		_("Altered spectral sensitivity of blue receptors"),
-		_("Absence of red receptors"),
-		_("Absence of green receptors"),
-		_("Absence of blue receptors"),
-	};
-
-	GtkTreeIter iter;
-	if (gtk_combo_box_get_active_iter(GTK_COMBO_BOX(this_->type), &iter)) {
-		GtkTreeModel* model = gtk_combo_box_get_model(GTK_COMBO_BOX(this_->type));
-		ColorVisionDeficiency::DeficiencyType type_id;
-		gtk_tree_model_get(model, &iter, 1, &type_id, -1);
-
-		gtk_label_set_text(GTK_LABEL(this_->info_label), descriptions[type_id]);
-	}else{
-		gtk_label_set_text(GTK_LABEL(this_->info_label), "");
-	}
-	gtk_info_bar_set_message_type(GTK_INFO_BAR(this_->info_bar), GTK_MESSAGE_INFO);
-}
-
-void ColorVisionDeficiency::Configuration::info_label_size_allocate_cb(GtkWidget *widget, GtkAllocation *allocation, ColorVisionDeficiency::Configuration *this_)
-{
-	gtk_widget_set_size_request(this_->info_label, allocation->width - 16, -1);
-}
-
 }
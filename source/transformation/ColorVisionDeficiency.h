@@ -19,7 +19,6 @@
 #ifndef TRANSFORMATION_COLOR_VISION_DEFICIENCY_H_
 #define TRANSFORMATION_COLOR_VISION_DEFICIENCY_H_
 #include "Transformation.h"
-#include <gtk/gtk.h>
 namespace transformation {
 struct ColorVisionDeficiency;
 struct ColorVisionDeficiency: public Transformation {
@@ -35,7 +34,6 @@ struct ColorVisionDeficiency: public Transformation {
 		GtkWidget *type;
 		GtkWidget *strength;
 		static void type_combobox_change_cb(GtkWidget *widget, Configuration *this_);
-		static void info_label_size_allocate_cb(GtkWidget *widget, GtkAllocation *allocation, Configuration *this_);
 	};
 	enum DeficiencyType {
 		PROTANOMALY,
@@ -54,7 +52,6 @@ struct ColorVisionDeficiency: public Transformation {
 	virtual ~ColorVisionDeficiency() override;
 	virtual void serialize(dynv::Map &system) override;
 	virtual void deserialize(const dynv::Map &system) override;
-	virtual std::unique_ptr<IConfiguration> getConfiguration() override;
 	DeficiencyType typeFromString(const std::string &type_string);
 private:
 	float strength;
@@ -18,6 +18,12 @@
 
 #ifndef GPICK_TRANSFORMATION_CONFIGURATION_H_
 #define GPICK_TRANSFORMATION_CONFIGURATION_H_
+#include "Transformation.h"
 #include "dynv/MapFwd.h"
 #include <gtk/gtk.h>
+#include <memory>
+namespace transformation {
+// Creates configuration widgets for transformation. Returns empty pointer if transformation has no configuration.
+std::unique_ptr<IConfiguration> createConfiguration(Transformation &transformation);
+}
 #endif /* GPICK_TRANSFORMATION_CONFIGURATION_H_ */
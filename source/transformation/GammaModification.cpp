@@ -19,9 +19,7 @@
 #include "GammaModification.h"
 #include "dynv/Map.h"
 #include "../MathUtil.h"
-#include "../uiUtilities.h"
 #include "../I18N.h"
-#include <gtk/gtk.h>
 #include <math.h>
 #include <string.h>
 namespace transformation {
@@ -58,33 +56,4 @@ void GammaModification::serialize(dynv::Map &system) {
 void GammaModification::deserialize(const dynv::Map &system) {
 	value = system.getFloat("value", 1);
 }
-std::unique_ptr<IConfiguration> GammaModification::getConfiguration() {
-	return std::move(std::make_unique<Configuration>(*this));
-}
-GammaModification::Configuration::Configuration(GammaModification &transformation) {
-	GtkWidget *table = gtk_table_new(2, 2, false);
-	GtkWidget *widget;
-	int table_y = 0;
-
-	table_y = 0;
-	gtk_table_attach(GTK_TABLE(table), gtk_label_aligned_new(_("Value:"), 0, 0.5, 0, 0), 0, 1, table_y, table_y + 1, GTK_FILL, GTK_FILL, 5, 5);
-	value = widget = gtk_spin_button_new_with_range(0, 100, 0.01);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(widget), transformation.value);
-	gtk_table_attach(GTK_TABLE(table), widget, 1, 2, table_y, table_y + 1, GtkAttachOptions(GTK_FILL | GTK_EXPAND), GTK_FILL, 5, 0);
-	table_y++;
-
-	main = table;
-	gtk_widget_show_all(main);
-
-	g_object_ref(main);
-}
-GammaModification::Configuration::~Configuration() {
-	g_object_unref(main);
-}
-GtkWidget *GammaModification::Configuration::getWidget() {
-	return main;
-}
-void GammaModification::Configuration::apply(dynv::Map &system) {
-	system.set("value", static_cast<float>(gtk_spin_button_get_value(GTK_SPIN_BUTTON(value))));
-}
 }
@@ -38,7 +38,6 @@ struct GammaModification: public Transformation {
 	virtual ~GammaModification() override;
 	virtual void serialize(dynv::Map &system) override;
 	virtual void deserialize(const dynv::Map &system) override;
-	virtual std::unique_ptr<IConfiguration> getConfiguration() override;
 private:
 	float value;
 	virtual void apply(Color *input, Color *output) override;
@@ -20,11 +20,10 @@
 #include "Quantization.h"
 #include "dynv/Map.h"
 #include "../MathUtil.h"
-#include "../uiUtilities.h"
 #include "../I18N.h"
-#include <gtk/gtk.h>
 #include <math.h>
 #include <string.h>
+#include <algorithm>
 #include <boost/math/special_functions/round.hpp>
 namespace transformation {
 static const char *transformationId = "quantization";
@@ -37,9 +36,9 @@ const char *Quantization::getName() {
 void Quantization::apply(Color *input, Color *output) {
 	if (clip_top) {
 		float max_intensity = (value - 1) / value;
-		output->rgb.red = MIN(max_intensity, boost::math::round(input->rgb.red * value) / value);
-		output->rgb.green = MIN(max_intensity, boost::math::round(input->rgb.green * value) / value);
-		output->rgb.blue = MIN(max_intensity, boost::math::round(input->rgb.blue * value) / value);
+		output->rgb.red = std::min(max_intensity, boost::math::round(input->rgb.red * value) / value);
+		output->rgb.green = std::min(max_intensity, boost::math::round(input->rgb.green * value) / value);
+		output->rgb.blue = std::min(max_intensity, boost::math::round(input->rgb.blue * value) / value);
 	} else {
 		float actualmax = value - 1;
 		output->rgb.red = boost::math::round(input->rgb.red * actualmax) / actualmax;
@@ -50,10 +49,12 @@ void Quantization::apply(Color *input, Color *output) {
 Quantization::Quantization():
 	Transformation(transformationId, getName()) {
 	value = 16;
+	clip_top = false;
 }
 Quantization::Quantization(float value_):
 	Transformation(transformationId, getName()) {
 	value = value_;
+	clip_top = false;
 }
 Quantization::~Quantization() {
 }
@@ -66,33 +67,4 @@ void Quantization::deserialize(const dynv::Map &system) {
 	value = system.getFloat("value", 16);
 	clip_top = system.getBool("clip-top", false);
 }
-std::unique_ptr<IConfiguration> Quantization::getConfiguration() {
-	return std::move(std::make_unique<Configuration>(*this));
-}
-Quantization::Configuration::Configuration(Quantization &transformation) {
-	GtkWidget *table = gtk_table_new(2, 3, false);
-	GtkWidget *widget;
-	int table_y = 0;
-	gtk_table_attach(GTK_TABLE(table), gtk_label_aligned_new(_("Value:"), 0, 0.5, 0, 0), 0, 1, table_y, table_y + 1, GTK_FILL, GTK_FILL, 5, 5);
-	value = widget = gtk_spin_button_new_with_range(2, 256, 1);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(widget), transformation.value);
-	gtk_table_attach(GTK_TABLE(table), widget, 1, 2, table_y, table_y + 1, GtkAttachOptions(GTK_FILL | GTK_EXPAND), GTK_FILL, 5, 0);
-	table_y++;
-	clip_top = widget = gtk_check_button_new_with_label(_("Clip top-end"));
-	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(widget), transformation.clip_top);
-	gtk_table_attach(GTK_TABLE(table), widget, 1, 2, table_y, table_y + 1, GtkAttachOptions(GTK_FILL | GTK_EXPAND), GTK_FILL, 5, 0);
-	main = table;
-	gtk_widget_show_all(main);
-	g_object_ref(main);
-}
-Quantization::Configuration::~Configuration() {
-	g_object_unref(main);
-}
-GtkWidget *Quantization::Configuration::getWidget() {
-	return main;
-}
-void Quantization::Configuration::apply(dynv::Map &system) {
-	system.set<float>("value", gtk_spin_button_get_value(GTK_SPIN_BUTTON(value)));
-	system.set<bool>("clip-top", gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(clip_top)));
-}
 }
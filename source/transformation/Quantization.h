@@ -39,7 +39,6 @@ struct Quantization: public Transformation {
 	virtual ~Quantization() override;
 	virtual void serialize(dynv::Map &system) override;
 	virtual void deserialize(const dynv::Map &system) override;
-	virtual std::unique_ptr<IConfiguration> getConfiguration() override;
 private:
 	float value;
 	bool clip_top;
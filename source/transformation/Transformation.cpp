@@ -39,7 +39,4 @@ void Transformation::serialize(dynv::Map &options) {
 }
 void Transformation::deserialize(const dynv::Map &options) {
 }
-std::unique_ptr<IConfiguration> Transformation::getConfiguration() {
-	return std::unique_ptr<IConfiguration>();
-}
 }
@@ -76,12 +76,6 @@ struct Transformation {
 		 */
 		virtual void deserialize(const dynv::Map &options);
 
-		/**
-		 * Get configuration for transformation object.
-		 * @return Configuration for transformation object.
-		 */
-		virtual std::unique_ptr<IConfiguration> getConfiguration();
-
 		/**
 		 * Get transformation object system name.
 		 * @return Transformation object system name.
@@ -51,7 +51,7 @@
 #include "tools/TextParser.h"
 #include "dbus/Control.h"
 #include "dynv/Map.h"
-#include "FileFormat.h"
+#include "PaletteJournal.h"
 #include "MathUtil.h"
 #include "Clipboard.h"
 #include "I18N.h"
@@ -66,6 +66,7 @@
 #include <algorithm>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <boost/filesystem.hpp>
 #include <boost/interprocess/sync/named_mutex.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
@@ -102,6 +103,9 @@ struct AppArgs
 	gint width, height;
 	bool initialization;
 	dbus::Control dbus_control;
+	std::unique_ptr<PaletteJournal> autosave;
+	guint autosave_timeout;
+	guint settings_timeout;
 };
 
 static void app_release(AppArgs *args);
@@ -310,7 +314,7 @@ int app_save_file(AppArgs *args, const char *filename, const char *filter)
 		current_filename = args->current_filename;
 	}
 	FileType filetype;
-	ImportExport import_export(args->gs->getColorList(), current_filename.c_str(), args->gs);
+	ImportExport import_export(args->gs->getColorList(), current_filename.c_str(), &args->gs->settings());
 	import_export.fixFileExtension(filter);
 	current_filename = import_export.getFilename();
 	bool return_value = false;
@@ -349,7 +353,7 @@ int app_load_file(AppArgs *args, const std::string &filename, ColorList *color_l
 {
 	bool imported = false;
 	bool return_value = false;
-	ImportExport import_export(color_list, filename.c_str(), args->gs);
+	ImportExport import_export(color_list, filename.c_str(), &args->gs->settings());
 	switch (ImportExport::getFileType(filename.c_str())){
 		case FileType::gpl:
 			return_value = import_export.importGPL();
@@ -396,6 +400,25 @@ int app_load_file(AppArgs *args, const std::string &filename, bool autoload)
 	return r;
 }
 
+int app_load_files(AppArgs *args, const std::vector<std::string> &filenames)
+{
+	ColorList *color_list = color_list_new(args->gs->getColorList());
+	vector<string> failed_filenames;
+	bool imported = ImportExport::importFiles(color_list, filenames, &args->gs->converters(), &failed_filenames);
+	for (auto &filename: failed_filenames){
+		cerr << "File could not be imported: " << filename << endl;
+	}
+	if (imported){
+		color_list_remove_all(args->gs->getColorList());
+		color_list_add(args->gs->getColorList(), color_list, true);
+		args->current_filename_set = false;
+		args->imported = true;
+	}
+	color_list_destroy(color_list);
+	app_update_program_name(args);
+	return imported ? 0 : -1;
+}
+
 int app_parse_geometry(AppArgs *args, const char *geometry)
 {
 	gtk_window_parse_geometry(GTK_WINDOW(args->window), geometry);
@@ -501,18 +524,29 @@ static void menu_file_open(GtkWidget *widget, AppArgs *args)
 	gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(dialog), default_path.c_str());
 	auto selected_filter = args->options->getString("open.filter", "all_supported");
 	add_file_filters(dialog, selected_filter.c_str());
+	gtk_file_chooser_set_select_multiple(GTK_FILE_CHOOSER(dialog), TRUE);
 	gboolean finished = FALSE;
 	while (!finished){
 		if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_OK) {
-			gchar *filename;
-			filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+			GSList *filenames = gtk_file_chooser_get_filenames(GTK_FILE_CHOOSER(dialog));
+			vector<string> selected_filenames;
+			for (GSList *i = filenames; i != nullptr; i = g_slist_next(i)){
+				selected_filenames.push_back((const gchar*)i->data);
+			}
+			g_slist_free_full(filenames, g_free);
 			gchar *path;
 			path = gtk_file_chooser_get_current_folder(GTK_FILE_CHOOSER(dialog));
 			args->options->set("open.path", path);
 			g_free(path);
 			const char *identification = (const char*)g_object_get_data(G_OBJECT(gtk_file_chooser_get_filter(GTK_FILE_CHOOSER(dialog))), "identification");
 			args->options->set("open.filter", identification);
-			if (app_load_file(args, filename) == 0){
+			int result = -1;
+			if (selected_filenames.size() == 1){
+				result = app_load_file(args, selected_filenames[0]);
+			}else if (selected_filenames.size() > 1){
+				result = app_load_files(args, selected_filenames);
+			}
+			if (result == 0){
 				finished = TRUE;
 			}else{
 				GtkWidget* message;
@@ -521,7 +555,6 @@ static void menu_file_open(GtkWidget *widget, AppArgs *args)
 				gtk_dialog_run(GTK_DIALOG(message));
 				gtk_widget_destroy(message);
 			}
-			g_free(filename);
 		}else break;
 	}
 	gtk_widget_destroy (dialog);
@@ -1411,6 +1444,10 @@ static gboolean on_palette_button_press(GtkWidget *widget, GdkEventButton *event
 	return FALSE;
 }
 
+static void on_palette_search_changed(GtkEntry *entry, AppArgs *args)
+{
+	palette_list_search(args->color_list, gtk_entry_get_text(entry));
+}
 static gboolean on_palette_list_key_press(GtkWidget *widget, GdkEventKey *event, AppArgs *args)
 {
 	guint modifiers = gtk_accelerator_get_default_mod_mask();
@@ -1515,6 +1552,12 @@ static int color_list_on_insert(ColorList* color_list, ColorObject* color_object
 	return 0;
 }
 
+static int color_list_on_insert_many(ColorList* color_list, const std::vector<ColorObject*> &color_objects)
+{
+	palette_list_add_entries(((AppArgs*)color_list->userdata)->color_list, color_objects);
+	return 0;
+}
+
 static int color_list_on_delete_selected(ColorList* color_list)
 {
 	palette_list_remove_selected_entries(((AppArgs*)color_list->userdata)->color_list);
@@ -1612,6 +1655,68 @@ bool app_is_autoload_enabled(AppArgs *args)
 	return args->options->getBool("main.save_restore_palette", true);
 }
 
+static PaletteJournal &app_get_autosave(AppArgs *args)
+{
+	if (!args->autosave){
+		args->autosave = std::make_unique<PaletteJournal>(buildConfigPath("autosave.gpa"), buildConfigPath("autosave.journal"));
+	}
+	args->autosave->setCompressionLevel(args->options->getInt32("palette_compression_level", 0));
+	return *args->autosave;
+}
+
+int app_load_autosave(AppArgs *args)
+{
+	using namespace boost::interprocess;
+	bool loaded = false;
+	ColorList *color_list = color_list_new(args->gs->getColorList());
+	try{
+		named_mutex mutex(open_or_create, "gpick.autosave");
+		scoped_lock<named_mutex> lock(mutex);
+		loaded = app_get_autosave(args).load(color_list);
+	}catch(const interprocess_exception &e){
+		cerr << "failed to load autosave: " << e.what() << endl;
+	}
+	if (loaded){
+		color_list_remove_all(args->gs->getColorList());
+		color_list_add(args->gs->getColorList(), color_list, true);
+	}
+	color_list_destroy(color_list);
+	args->current_filename_set = false;
+	args->imported = false;
+	app_update_program_name(args);
+	return loaded ? 0 : -1;
+}
+
+// Only changes since the last autosave are appended to the journal
+static void app_save_autosave(AppArgs *args)
+{
+	using namespace boost::interprocess;
+	try{
+		named_mutex mutex(open_or_create, "gpick.autosave");
+		scoped_lock<named_mutex> lock(mutex);
+		if (!app_get_autosave(args).save(args->gs->getColorList())){
+			cerr << "failed to save autosave" << endl;
+		}
+	}catch(const interprocess_exception &e){
+		cerr << "failed to save autosave: " << e.what() << endl;
+	}
+}
+
+// Palette is not walked and the autosave mutex is not taken when nothing changed since the last autosave
+static gboolean autosave_timeout_cb(AppArgs *args)
+{
+	if (app_is_autoload_enabled(args) && !app_get_autosave(args).isSaved(args->gs->getColorList()))
+		app_save_autosave(args);
+	return true;
+}
+
+// Settings are written when they have not changed for one interval
+static gboolean settings_timeout_cb(AppArgs *args)
+{
+	args->gs->writeSettingsInBackground();
+	return true;
+}
+
 static void app_initialize_variables(AppArgs *args)
 {
 	args->current_filename_set = false;
@@ -1621,6 +1726,8 @@ static void app_initialize_variables(AppArgs *args)
 	args->secondary_color_source = 0;
 	args->secondary_source_widget = 0;
 	args->secondary_source_scrolled_viewpoint = 0;
+	args->autosave_timeout = 0;
+	args->settings_timeout = 0;
 	args->gs->loadAll();
 	dialog_options_update(args->gs);
 	args->options = args->gs->settings().getOrCreateMap("gpick.main");
@@ -1631,6 +1738,7 @@ static void app_initialize_variables(AppArgs *args)
 static void app_initialize_color_list(AppArgs *args)
 {
 	args->gs->getColorList()->on_insert = color_list_on_insert;
+	args->gs->getColorList()->on_insert_many = color_list_on_insert_many;
 	args->gs->getColorList()->on_clear = color_list_on_clear;
 	args->gs->getColorList()->on_delete_selected = color_list_on_delete_selected;
 	args->gs->getColorList()->on_get_positions = color_list_on_get_positions;
@@ -1827,6 +1935,14 @@ AppArgs* app_create_main(const StartupOptions &startupOptions, int &return_value
 	gtk_widget_show_all(button);
 	gtk_box_pack_end(GTK_BOX(statusbar), count_label, false, false, 0);
 	gtk_widget_show_all(count_label);
+	widget = gtk_entry_new();
+#if GTK_MAJOR_VERSION >= 3
+	gtk_entry_set_placeholder_text(GTK_ENTRY(widget), _("Search"));
+#endif
+	gtk_widget_set_tooltip_text(widget, _("Select palette colors by name or by similar color"));
+	g_signal_connect(G_OBJECT(widget), "changed", G_CALLBACK(on_palette_search_changed), args);
+	gtk_box_pack_end(GTK_BOX(statusbar), widget, false, false, 0);
+	gtk_widget_show(widget);
 	widget = newIcon(GTK_STOCK_DIALOG_WARNING, 16);
 	gtk_widget_set_tooltip_text(widget, _("File is currently in a non-native format, possible loss of precision and/or metadata."));
 	args->precision_loss_icon = widget;
@@ -1865,23 +1981,16 @@ static void app_release(AppArgs *args)
 	args->color_source_index.clear();
 	floating_picker_free(args->floating_picker);
 	if (!args->startupOptions.single_color_pick_mode){
+		if (args->autosave_timeout){
+			g_source_remove(args->autosave_timeout);
+			args->autosave_timeout = 0;
+		}
+		if (args->settings_timeout){
+			g_source_remove(args->settings_timeout);
+			args->settings_timeout = 0;
+		}
 		if (app_is_autoload_enabled(args)){
-			using namespace boost::interprocess;
-			using namespace boost::filesystem;
-			try{
-				named_mutex mutex(open_or_create, "gpick.autosave");
-				scoped_lock<named_mutex> lock(mutex);
-				auto autosaveFile = buildConfigPath("autosave.gpa");
-				auto autosaveFileTmp = buildConfigPath("autosave.gpa.tmp");
-				palette_file_save(autosaveFileTmp.c_str(), args->gs->getColorList());
-				boost::system::error_code error;
-				rename(path(autosaveFileTmp), path(autosaveFile), error);
-				if (error){
-					cerr << "failed to save autosave: " << error << endl;
-				}
-			}catch(const interprocess_exception &e){
-				cerr << "failed to save autosave: " << e.what() << endl;
-			}
+			app_save_autosave(args);
 		}
 	}
 	color_list_remove_all(args->gs->getColorList());
@@ -1970,6 +2079,10 @@ int app_run(AppArgs *args)
 		}
 		if (args->startupOptions.floating_picker_mode)
 			floating_picker_activate(args->floating_picker, false, false, args->startupOptions.converter_name.c_str());
+		auto autosave_interval = args->options->getInt32("autosave_interval", 60);
+		if (autosave_interval > 0)
+			args->autosave_timeout = g_timeout_add_seconds(autosave_interval, (GSourceFunc)autosave_timeout_cb, args);
+		args->settings_timeout = g_timeout_add_seconds(5, (GSourceFunc)settings_timeout_cb, args);
 		gtk_main();
 		app_save_recent_file_list(args);
 		args->dbus_control.unownName();
@@ -20,6 +20,7 @@
 #define GPICK_UI_APP_H_
 #include "dynv/Map.h"
 #include <string>
+#include <vector>
 #include <gtk/gtk.h>
 struct GlobalState;
 struct ColorObject;
@@ -38,6 +39,9 @@ struct StartupOptions {
 void app_initialize();
 AppArgs* app_create_main(const StartupOptions &options, int &return_value);
 int app_load_file(AppArgs *args, const std::string &filename, bool autoload = false);
+// Replaces palette with colors from all files, directories are expanded to the files they contain
+int app_load_files(AppArgs *args, const std::vector<std::string> &filenames);
+int app_load_autosave(AppArgs *args);
 int app_run(AppArgs *args);
 int app_parse_geometry(AppArgs *args, const char *geometry);
 bool app_is_autoload_enabled(AppArgs *args);
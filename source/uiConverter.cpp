@@ -25,7 +25,11 @@
 #include "I18N.h"
 #include "ColorObject.h"
 #include "ColorList.h"
+#include "lua/Profiler.h"
 #include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
 using namespace std;
 
 typedef enum
@@ -37,6 +41,10 @@ typedef enum
 	CONVERTERLIST_COPY_ENABLED,
 	CONVERTERLIST_PASTE,
 	CONVERTERLIST_PASTE_ENABLED,
+	CONVERTERLIST_CALLS,
+	CONVERTERLIST_AVERAGE,
+	CONVERTERLIST_PERCENTILE99,
+	CONVERTERLIST_MEMORY,
 	CONVERTERLIST_N_COLUMNS
 }ConverterListColumns;
 
@@ -47,8 +55,44 @@ struct ConverterArgs
 	GlobalState *gs;
 };
 
+struct ConverterStatistics
+{
+	string calls, average, percentile99, memory;
+};
+// Combines statistics of all profiled Lua functions of a converter
+static ConverterStatistics converter_get_statistics(Converter *converter, ConverterArgs *args)
+{
+	uint64_t calls = 0, total = 0, percentile99 = 0;
+	int64_t memory = 0;
+	for (auto suffix: {".serialize", ".deserialize", ".serializeMany"}){
+		lua::Profiler::Statistics statistics;
+		if (!args->gs->profiler().statistics(converter->name() + suffix, statistics))
+			continue;
+		calls += statistics.calls;
+		total += statistics.total;
+		percentile99 = std::max(percentile99, statistics.percentile99);
+		memory += statistics.memory;
+	}
+	ConverterStatistics result;
+	if (calls == 0)
+		return result;
+	stringstream ss;
+	ss << calls;
+	result.calls = ss.str();
+	ss.str("");
+	ss << fixed << setprecision(3) << static_cast<double>(total / calls) / 1000000.0 << " ms";
+	result.average = ss.str();
+	ss.str("");
+	ss << static_cast<double>(percentile99) / 1000000.0 << " ms";
+	result.percentile99 = ss.str();
+	ss.str("");
+	ss << setprecision(1) << static_cast<double>(memory) / 1024.0 << " KiB";
+	result.memory = ss.str();
+	return result;
+}
 static void converter_update_row(GtkTreeModel *model, GtkTreeIter *iter1, Converter *converter, ConverterArgs *args)
 {
+	auto statistics = converter_get_statistics(converter, args);
 	ConverterSerializePosition position(1);
 	Color c;
 	c.rgb.red = 0.75;
@@ -65,6 +109,10 @@ static void converter_update_row(GtkTreeModel *model, GtkTreeIter *iter1, Conver
 		CONVERTERLIST_COPY_ENABLED, converter->hasSerialize(),
 		CONVERTERLIST_PASTE, converter->paste(),
 		CONVERTERLIST_PASTE_ENABLED, converter->hasDeserialize(),
+		CONVERTERLIST_CALLS, statistics.calls.c_str(),
+		CONVERTERLIST_AVERAGE, statistics.average.c_str(),
+		CONVERTERLIST_PERCENTILE99, statistics.percentile99.c_str(),
+		CONVERTERLIST_MEMORY, statistics.memory.c_str(),
 		-1);
 	color_object->release();
 }
@@ -94,7 +142,7 @@ static GtkWidget* converter_dropdown_new(ConverterArgs *args, GtkTreeModel *mode
 	if (model){
 		combo = gtk_combo_box_new_with_model(model);
 	}else{
-		store = gtk_list_store_new (CONVERTERLIST_N_COLUMNS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_POINTER, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN);
+		store = gtk_list_store_new (CONVERTERLIST_N_COLUMNS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_POINTER, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
 		combo = gtk_combo_box_new_with_model(GTK_TREE_MODEL(store));
 	}
 	renderer = gtk_cell_renderer_text_new();
@@ -111,7 +159,7 @@ static GtkWidget* converter_list_new(ConverterArgs *args)
 	GtkWidget *view = gtk_tree_view_new();
 	args->list = view;
 	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(view),1);
-	store = gtk_list_store_new (CONVERTERLIST_N_COLUMNS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_POINTER, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN);
+	store = gtk_list_store_new (CONVERTERLIST_N_COLUMNS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_POINTER, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
 	col = gtk_tree_view_column_new();
 	gtk_tree_view_column_set_sizing(col,GTK_TREE_VIEW_COLUMN_AUTOSIZE);
 	gtk_tree_view_column_set_resizable(col,1);
@@ -144,6 +192,25 @@ static GtkWidget* converter_list_new(ConverterArgs *args)
 	gtk_tree_view_append_column(GTK_TREE_VIEW(view), col);
 	g_signal_connect(renderer, "toggled", (GCallback) paste_toggled_cb, args);
 	gtk_tree_view_column_set_attributes(col, renderer, "active", CONVERTERLIST_PASTE, "activatable", CONVERTERLIST_PASTE_ENABLED, (void*)0);
+	const struct{
+		const char *title;
+		int column;
+	}statistics_columns[] = {
+		{_("Calls"), CONVERTERLIST_CALLS},
+		{_("Average time"), CONVERTERLIST_AVERAGE},
+		{_("99th percentile"), CONVERTERLIST_PERCENTILE99},
+		{_("Lua memory"), CONVERTERLIST_MEMORY},
+	};
+	for (auto &statistics_column: statistics_columns){
+		col = gtk_tree_view_column_new();
+		gtk_tree_view_column_set_sizing(col,GTK_TREE_VIEW_COLUMN_AUTOSIZE);
+		gtk_tree_view_column_set_resizable(col,1);
+		gtk_tree_view_column_set_title(col, statistics_column.title);
+		renderer = gtk_cell_renderer_text_new();
+		gtk_tree_view_column_pack_start(col, renderer, TRUE);
+		gtk_tree_view_column_add_attribute(col, renderer, "text", statistics_column.column);
+		gtk_tree_view_append_column(GTK_TREE_VIEW(view), col);
+	}
 	gtk_tree_view_set_model (GTK_TREE_VIEW (view), GTK_TREE_MODEL(store));
 	g_object_unref (GTK_TREE_MODEL(store));
 	GtkTreeSelection *selection = gtk_tree_view_get_selection ( GTK_TREE_VIEW(view) );
@@ -151,6 +218,34 @@ static GtkWidget* converter_list_new(ConverterArgs *args)
 	gtk_tree_view_set_reorderable(GTK_TREE_VIEW (view), TRUE);
 	return view;
 }
+static void save_statistics_cb(GtkWidget *widget, ConverterArgs *args)
+{
+	GtkWidget *dialog = gtk_file_chooser_dialog_new(_("Save statistics"), GTK_WINDOW(gtk_widget_get_toplevel(widget)), GTK_FILE_CHOOSER_ACTION_SAVE, GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL, GTK_STOCK_SAVE, GTK_RESPONSE_OK, nullptr);
+	gtk_dialog_set_alternative_button_order(GTK_DIALOG(dialog), GTK_RESPONSE_OK, GTK_RESPONSE_CANCEL, -1);
+	gtk_file_chooser_set_do_overwrite_confirmation(GTK_FILE_CHOOSER(dialog), true);
+	gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(dialog), "converters.tsv");
+	if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_OK) {
+		gchar *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+		if (!args->gs->profiler().dump(filename)) {
+			GtkWidget *message = gtk_message_dialog_new(GTK_WINDOW(dialog), GTK_DIALOG_MODAL, GTK_MESSAGE_ERROR, GTK_BUTTONS_OK, _("File could not be saved"));
+			gtk_dialog_run(GTK_DIALOG(message));
+			gtk_widget_destroy(message);
+		}
+		g_free(filename);
+	}
+	gtk_widget_destroy(dialog);
+}
+static void reset_statistics_cb(GtkWidget *widget, ConverterArgs *args)
+{
+	args->gs->profiler().reset();
+	GtkTreeModel *model = gtk_tree_view_get_model(GTK_TREE_VIEW(args->list));
+	GtkTreeIter iter;
+	gboolean valid = gtk_tree_model_get_iter_first(model, &iter);
+	while (valid) {
+		gtk_list_store_set(GTK_LIST_STORE(model), &iter, CONVERTERLIST_CALLS, "", CONVERTERLIST_AVERAGE, "", CONVERTERLIST_PERCENTILE99, "", CONVERTERLIST_MEMORY, "", -1);
+		valid = gtk_tree_model_iter_next(model, &iter);
+	}
+}
 void dialog_converter_show(GtkWindow *parent, GlobalState *gs)
 {
 	ConverterArgs *args = new ConverterArgs;
@@ -185,6 +280,17 @@ void dialog_converter_show(GtkWindow *parent, GlobalState *gs)
 	gtk_table_attach(GTK_TABLE(table), color_list, 1, 2, table_y, table_y+1, GtkAttachOptions(GTK_FILL | GTK_EXPAND), GTK_FILL, 0, 0);
 	table_y++;
 
+	gtk_table_attach(GTK_TABLE(table), gtk_label_aligned_new(_("Statistics:"),0,0.5,0,0), 0, 1, table_y, table_y+1, GtkAttachOptions(GTK_FILL), GTK_FILL, 0, 0);
+	GtkWidget *hbox = gtk_hbox_new(false, 5);
+	GtkWidget *button = gtk_button_new_from_stock(GTK_STOCK_SAVE_AS);
+	gtk_box_pack_start(GTK_BOX(hbox), button, false, false, 0);
+	g_signal_connect(G_OBJECT(button), "clicked", G_CALLBACK(save_statistics_cb), args);
+	button = gtk_button_new_from_stock(GTK_STOCK_CLEAR);
+	gtk_box_pack_start(GTK_BOX(hbox), button, false, false, 0);
+	g_signal_connect(G_OBJECT(button), "clicked", G_CALLBACK(reset_statistics_cb), args);
+	gtk_table_attach(GTK_TABLE(table), hbox, 1, 2, table_y, table_y+1, GtkAttachOptions(GTK_FILL | GTK_EXPAND), GTK_FILL, 0, 0);
+	table_y++;
+
 	GtkTreeIter iter1, iter2;
 	GtkTreeModel *model = gtk_tree_view_get_model(GTK_TREE_VIEW(list));
 	Converter *display_converter = args->gs->converters().display();
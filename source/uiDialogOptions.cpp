@@ -20,11 +20,13 @@
 #include "uiUtilities.h"
 #include "ToolColorNaming.h"
 #include "GlobalState.h"
+#include "Converters.h"
 #include "I18N.h"
 #include "dynv/Map.h"
 #include "lua/Script.h"
 #include "lua/DynvSystem.h"
 #include "lua/Callbacks.h"
+#include "lua/Profiler.h"
 #include <string>
 #include <iostream>
 using namespace std;
@@ -82,9 +84,16 @@ bool dialog_options_update(GlobalState *gs) {
 	int stack_top = lua_gettop(L);
 	gs->callbacks().optionChange().get();
 	lua::pushDynvSystem(L, &gs->settings());
-	int status = lua_pcall(L, 1, 0, 0);
+	int status;
+	{
+		lua::Profiler::Scope scope(gs->callbacks().optionChangeSite(), L);
+		status = lua_pcall(L, 1, 0, 0);
+		if (status != 0)
+			scope.error();
+	}
 	if (status == 0){
 		lua_settop(L, stack_top);
+		gs->converters().builtinOptions().upperCase = gs->settings().getString("gpick.options.hex_case", "upper") == "upper";
 		return true;
 	}else{
 		cerr << "optionsUpdate: " << lua_tostring(L, -1) << endl;
@@ -26,6 +26,7 @@
 #include "Converters.h"
 #include "Converter.h"
 #include "GlobalState.h"
+#include "lua/ScriptPool.h"
 #include "I18N.h"
 #include "parser/TextFile.h"
 #include <functional>
@@ -381,7 +382,7 @@ bool ImportExportDialog::showImport()
 				for (size_t i = 0; i != n_formats; ++i){
 					if (formats[i].type == type){
 						ColorList *color_list = color_list_new(m_color_list);
-						ImportExport import_export(color_list, filename, m_gs);
+						ImportExport import_export(color_list, filename, &m_gs->settings());
 						import_export.setConverters(&m_gs->converters());
 						if (import_export.importType(formats[i].type)){
 							finished = true;
@@ -427,7 +428,7 @@ bool ImportExportDialog::showImportTextFile()
 			GtkWidget* message;
 			gchar *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
 			ColorList *color_list = color_list_new(m_color_list);
-			ImportExport import_export(color_list, filename, m_gs);
+			ImportExport import_export(color_list, filename, &m_gs->settings());
 			import_export.setConverters(&m_gs->converters());
 			text_file_parser::Configuration configuration;
 			configuration.single_line_c_comments = import_export_dialog_options.isSingleLineCCommentsEnabled();
@@ -502,9 +503,12 @@ bool ImportExportDialog::showExport()
 			string format_name = gtk_file_filter_get_name(gtk_file_chooser_get_filter(GTK_FILE_CHOOSER(dialog)));
 			for (size_t i = 0; i != n_formats; ++i){
 				if (formats[i].name == format_name){
-					ImportExport import_export(m_color_list, filename, m_gs);
+					ImportExport import_export(m_color_list, filename, &m_gs->settings());
 					import_export.fixFileExtension(formats[i].pattern);
 					import_export.setConverter(import_export_dialog_options.getSelectedConverter());
+					import_export.setSerializer([this](const Converter &converter, const vector<ColorObject*> &color_objects, vector<string> &lines) {
+						return m_gs->scriptPool().serialize(converter.name(), color_objects, lines);
+					});
 					string item_size = import_export_dialog_options.getSelectedItemSize();
 					import_export.setItemSize(item_size.c_str());
 					string background = import_export_dialog_options.getSelectedBackground();
@@ -21,6 +21,7 @@
 #include "gtk/ColorCell.h"
 #include "ColorObject.h"
 #include "ColorList.h"
+#include "ColorListIndex.h"
 #include "ColorSource.h"
 #include "DragDrop.h"
 #include "GlobalState.h"
@@ -35,6 +36,8 @@
 #include "StandardEventHandler.h"
 #include <sstream>
 #include <iomanip>
+#include <unordered_map>
+#include <unordered_set>
 using namespace math;
 using namespace std;
 
@@ -49,6 +52,9 @@ struct ListPaletteArgs : public IReadonlyColorsUI {
 	bool disable_selection;
 	GtkWidget* count_label;
 	GlobalState* gs;
+	ColorListIndex index;
+	// List store iterators stay valid until their row is removed
+	std::unordered_map<ColorObject *, GtkTreeIter> rows;
 
 	virtual ~ListPaletteArgs() {
 	}
@@ -240,20 +246,26 @@ static void palette_list_entry_fill(GtkListStore* store, GtkTreeIter *iter, Colo
 {
 	string text = args->gs->converters().serialize(color_object, Converters::Type::colorList);
 	gtk_list_store_set(store, iter, 0, color_object->reference(), 1, text.c_str(), 2, color_object->getName().c_str(), -1);
+	args->index.add(color_object);
+	args->rows[color_object] = *iter;
 }
 static void palette_list_entry_update_row(GtkListStore* store, GtkTreeIter *iter, ColorObject* color_object, ListPaletteArgs* args)
 {
 	string text = args->gs->converters().serialize(color_object, Converters::Type::colorList);
 	gtk_list_store_set(store, iter, 1, text.c_str(), 2, color_object->getName().c_str(), -1);
+	args->index.update(color_object);
+	color_list_changed(args->gs->getColorList(), color_object);
 }
-static void palette_list_entry_update_name(GtkListStore* store, GtkTreeIter *iter, ColorObject* color_object)
+static void palette_list_entry_update_name(GtkListStore* store, GtkTreeIter *iter, ColorObject* color_object, ListPaletteArgs* args)
 {
 	gtk_list_store_set(store, iter, 2, color_object->getName().c_str(), -1);
+	args->index.update(color_object);
+	color_list_changed(args->gs->getColorList(), color_object);
 }
-static void palette_list_cell_edited(GtkCellRendererText *cell, gchar *path, gchar *new_text, gpointer user_data)
+static void palette_list_cell_edited(GtkCellRendererText *cell, gchar *path, gchar *new_text, ListPaletteArgs *args)
 {
 	GtkTreeIter iter;
-	GtkTreeModel *model=GTK_TREE_MODEL(user_data);
+	GtkTreeModel *model = gtk_tree_view_get_model(GTK_TREE_VIEW(args->treeview));
 	gtk_tree_model_get_iter_from_string(model, &iter, path );
 	gtk_list_store_set(GTK_LIST_STORE(model), &iter,
 		2, new_text,
@@ -261,6 +273,8 @@ static void palette_list_cell_edited(GtkCellRendererText *cell, gchar *path, gch
 	ColorObject *color_object;
 	gtk_tree_model_get(model, &iter, 0, &color_object, -1);
 	color_object->setName(new_text);
+	args->index.update(color_object);
+	color_list_changed(args->gs->getColorList(), color_object);
 }
 static void palette_list_row_activated(GtkTreeView *tree_view, GtkTreePath *path, GtkTreeViewColumn *column, gpointer user_data)
 {
@@ -855,7 +869,7 @@ GtkWidget* palette_list_new(GlobalState* gs, GtkWidget* count_label) {
 	gtk_tree_view_column_add_attribute(col, renderer, "text", 2);
 	gtk_tree_view_append_column(GTK_TREE_VIEW(view), col);
 	g_object_set(renderer, "editable", TRUE, nullptr);
-	g_signal_connect(renderer, "edited", (GCallback) palette_list_cell_edited, store);
+	g_signal_connect(renderer, "edited", (GCallback) palette_list_cell_edited, args);
 
 	gtk_tree_view_set_enable_search(GTK_TREE_VIEW(view), false);
 	gtk_tree_view_set_model(GTK_TREE_VIEW(view), GTK_TREE_MODEL(store));
@@ -913,6 +927,8 @@ void palette_list_remove_all_entries(GtkWidget* widget) {
 	}
 
 	gtk_list_store_clear(GTK_LIST_STORE(store));
+	args->index.clear();
+	args->rows.clear();
 
 	update_counts(args);
 }
@@ -962,6 +978,8 @@ void palette_list_remove_selected_entries(GtkWidget* widget)
 		gtk_tree_model_get(GTK_TREE_MODEL(store), &iter, 0, &color_object, -1);
 		if (color_object->isSelected()){
 			valid = gtk_list_store_remove(GTK_LIST_STORE(store), &iter);
+			args->index.remove(color_object);
+			args->rows.erase(color_object);
 			color_object->release();
 		}else{
 			valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(store), &iter);
@@ -980,6 +998,19 @@ void palette_list_add_entry(GtkWidget* widget, ColorObject* color_object)
 	palette_list_entry_fill(store, &iter1, color_object, args);
 	update_counts(args);
 }
+void palette_list_add_entries(GtkWidget* widget, const std::vector<ColorObject*> &color_objects)
+{
+	ListPaletteArgs* args = (ListPaletteArgs*)g_object_get_data(G_OBJECT(widget), "arguments");
+	GtkTreeIter iter1;
+	GtkListStore *store;
+	store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(widget)));
+	for (auto color_object: color_objects){
+		gtk_list_store_append(store, &iter1);
+		palette_list_entry_fill(store, &iter1, color_object, args);
+	}
+	// Counts are updated once, as counting selected rows walks the whole selection
+	update_counts(args);
+}
 int palette_list_remove_entry(GtkWidget* widget, ColorObject* r_color_object)
 {
 	ListPaletteArgs* args = (ListPaletteArgs*)g_object_get_data(G_OBJECT(widget), "arguments");
@@ -993,6 +1024,8 @@ int palette_list_remove_entry(GtkWidget* widget, ColorObject* r_color_object)
 		gtk_tree_model_get(GTK_TREE_MODEL(store), &iter, 0, &color_object, -1);
 		if (color_object == r_color_object){
 			valid = gtk_list_store_remove(GTK_LIST_STORE(store), &iter);
+			args->index.remove(color_object);
+			args->rows.erase(color_object);
 			color_object->release();
 			return 0;
 		}
@@ -1008,7 +1041,7 @@ static void execute_callback(GtkListStore *store, GtkTreeIter *iter, ListPalette
 	PaletteListCallbackReturn r = callback(color_object, userdata);
 	switch (r){
 		case PALETTE_LIST_CALLBACK_UPDATE_NAME:
-			palette_list_entry_update_name(store, iter, color_object);
+			palette_list_entry_update_name(store, iter, color_object, args);
 			break;
 		case PALETTE_LIST_CALLBACK_UPDATE_ROW:
 			palette_list_entry_update_row(store, iter, color_object, args);
@@ -1027,10 +1060,15 @@ static void execute_replace_callback(GtkListStore *store, GtkTreeIter *iter, Lis
 	PaletteListCallbackReturn r = callback(&color_object, userdata);
 	if (color_object != orig_color_object){
 		gtk_list_store_set(store, iter, 0, color_object, -1);
+		args->index.remove(orig_color_object);
+		args->index.add(color_object);
+		args->rows.erase(orig_color_object);
+		args->rows[color_object] = *iter;
+		color_list_changed(args->gs->getColorList(), color_object);
 	}
 	switch (r){
 		case PALETTE_LIST_CALLBACK_UPDATE_NAME:
-			palette_list_entry_update_name(store, iter, color_object);
+			palette_list_entry_update_name(store, iter, color_object, args);
 			break;
 		case PALETTE_LIST_CALLBACK_UPDATE_ROW:
 			palette_list_entry_update_row(store, iter, color_object, args);
@@ -1145,7 +1183,7 @@ void palette_list_update_first_selected(GtkWidget* widget, bool only_name)
 		gtk_tree_model_get_iter(model, &iter, reinterpret_cast<GtkTreePath*>(i->data));
 		gtk_tree_model_get(model, &iter, 0, &color_object, -1);
 		if (only_name)
-			palette_list_entry_update_name(GTK_LIST_STORE(model), &iter, color_object);
+			palette_list_entry_update_name(GTK_LIST_STORE(model), &iter, color_object, args);
 		else
 			palette_list_entry_update_row(GTK_LIST_STORE(model), &iter, color_object, args);
 	}
@@ -1156,3 +1194,58 @@ void palette_list_append_copy_menu(GtkWidget* widget, GtkWidget *menu) {
 	auto args = reinterpret_cast<ListPaletteArgs *>(g_object_get_data(G_OBJECT(widget), "arguments"));
 	StandardMenu::appendMenu(menu, args, args->gs);
 }
+void palette_list_search(GtkWidget* widget, const char *query)
+{
+	auto args = reinterpret_cast<ListPaletteArgs *>(g_object_get_data(G_OBJECT(widget), "arguments"));
+	GtkTreeView *treeview = GTK_TREE_VIEW(widget);
+	GtkTreeSelection *selection = gtk_tree_view_get_selection(treeview);
+	GtkTreeModel *model = gtk_tree_view_get_model(treeview);
+	gtk_tree_selection_unselect_all(selection);
+	if (query == nullptr || query[0] == 0) {
+		update_counts(args);
+		return;
+	}
+	std::unordered_set<ColorObject *> matches;
+	ColorObject *color_object;
+	if (args->gs->converters().deserialize(query, &color_object)) {
+		float distance = args->gs->settings().getFloat("gpick.main.search_distance", 5.0f);
+		args->index.findByColor(color_object->getColor(), distance, [&matches](ColorObject *match, float) {
+			matches.insert(match);
+			return true;
+		});
+		color_object->release();
+	}
+	args->index.findByName(query, [&matches](ColorObject *match) {
+		matches.insert(match);
+		return true;
+	});
+	if (matches.empty()) {
+		update_counts(args);
+		return;
+	}
+	// Matching rows are selected with "changed" handlers blocked, so listeners are notified once instead of once per match
+	guint changed_signal = g_signal_lookup("changed", GTK_TYPE_TREE_SELECTION);
+	g_signal_handlers_block_matched(selection, G_SIGNAL_MATCH_ID, changed_signal, 0, nullptr, nullptr, nullptr);
+	GtkTreePath *first_path = nullptr;
+	for (auto match: matches) {
+		auto row = args->rows.find(match);
+		if (row == args->rows.end())
+			continue;
+		gtk_tree_selection_select_iter(selection, &row->second);
+		GtkTreePath *path = gtk_tree_model_get_path(model, &row->second);
+		if (first_path == nullptr || gtk_tree_path_compare(path, first_path) < 0) {
+			if (first_path != nullptr)
+				gtk_tree_path_free(first_path);
+			first_path = path;
+		} else {
+			gtk_tree_path_free(path);
+		}
+	}
+	g_signal_handlers_unblock_matched(selection, G_SIGNAL_MATCH_ID, changed_signal, 0, nullptr, nullptr, nullptr);
+	g_signal_emit(selection, changed_signal, 0);
+	if (first_path != nullptr) {
+		gtk_tree_view_scroll_to_cell(treeview, first_path, nullptr, false, 0, 0);
+		gtk_tree_path_free(first_path);
+	}
+	update_counts(args);
+}
@@ -19,11 +19,13 @@
 #ifndef GPICK_UI_LIST_PALETTE_H_
 #define GPICK_UI_LIST_PALETTE_H_
 #include <gtk/gtk.h>
+#include <vector>
 struct GlobalState;
 struct ColorObject;
 struct ColorList;
 GtkWidget* palette_list_new(GlobalState* gs, GtkWidget* count_label);
 void palette_list_add_entry(GtkWidget* widget, ColorObject *color_object);
+void palette_list_add_entries(GtkWidget* widget, const std::vector<ColorObject*> &color_objects);
 GtkWidget* palette_list_preview_new(GlobalState* gs, bool expander, bool expanded, ColorList* color_list, ColorList** out_color_list);
 GtkWidget* palette_list_get_widget(ColorList *color_list);
 void palette_list_remove_all_entries(GtkWidget* widget);
@@ -46,4 +48,5 @@ gint32 palette_list_get_count(GtkWidget* widget);
 ColorObject *palette_list_get_first_selected(GtkWidget* widget);
 void palette_list_update_first_selected(GtkWidget* widget, bool only_name);
 void palette_list_append_copy_menu(GtkWidget* widget, GtkWidget *menu);
+void palette_list_search(GtkWidget* widget, const char *query);
 #endif /* GPICK_UI_LIST_PALETTE_H_ */
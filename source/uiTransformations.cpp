@@ -25,6 +25,7 @@
 #include "transformation/Chain.h"
 #include "transformation/Factory.h"
 #include "transformation/ColorVisionDeficiency.h"
+#include "transformation/Configuration.h"
 #include <iostream>
 using namespace std;
 
@@ -224,7 +225,7 @@ static void configure_transformation(TransformationsArgs *args, transformation::
 	}
 	if (transformation){
 		gtk_label_set_text(GTK_LABEL(args->configuration_label), transformation->getReadableName().c_str());
-		args->configuration = std::move(transformation->getConfiguration());
+		args->configuration = transformation::createConfiguration(*transformation);
 		args->transformation = transformation;
 		gtk_box_pack_start(GTK_BOX(args->config_vbox), args->configuration->getWidget(), true, true, 0);
 	}else{